@@ -0,0 +1,40 @@
+#include "games/actions/plan.h"
+
+namespace actions {
+
+int StepsLeft(const actions::proto::Plan& plan) {
+  const int left = plan.steps_size() - plan.next_step();
+  return left > 0 ? left : 0;
+}
+
+const actions::proto::Step& CurrentStep(const actions::proto::Plan& plan) {
+  return plan.steps(plan.next_step());
+}
+
+void AdvancePlan(actions::proto::Plan* plan) {
+  if (plan->next_step() + 1 >= plan->steps_size()) {
+    ClearPlan(plan);
+    return;
+  }
+  plan->set_next_step(plan->next_step() + 1);
+}
+
+void ClearPlan(actions::proto::Plan* plan) {
+  plan->clear_steps();
+  plan->clear_next_step();
+}
+
+void CompactPlan(actions::proto::Plan* plan) {
+  if (plan->next_step() <= 0) {
+    plan->clear_next_step();
+    return;
+  }
+  if (plan->next_step() >= plan->steps_size()) {
+    ClearPlan(plan);
+    return;
+  }
+  plan->mutable_steps()->DeleteSubrange(0, plan->next_step());
+  plan->clear_next_step();
+}
+
+}  // namespace actions
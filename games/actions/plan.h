@@ -0,0 +1,29 @@
+#ifndef GAMES_ACTIONS_PLAN_H
+#define GAMES_ACTIONS_PLAN_H
+
+#include "games/actions/proto/plan.pb.h"
+
+namespace actions {
+
+// A Plan is executed by moving its next_step cursor along the steps, rather
+// than deleting each step as it is done, so that advancing does not shift the
+// rest of the plan. The done steps are dropped by CompactPlan.
+
+// Returns the number of steps not yet done.
+int StepsLeft(const actions::proto::Plan& plan);
+
+// Returns the step to execute next. The plan must have steps left.
+const actions::proto::Step& CurrentStep(const actions::proto::Plan& plan);
+
+// Marks the current step done. When that was the last step, clears the plan.
+void AdvancePlan(actions::proto::Plan* plan);
+
+// Removes all steps, done or not.
+void ClearPlan(actions::proto::Plan* plan);
+
+// Removes the done steps, so that the current step is the first.
+void CompactPlan(actions::proto::Plan* plan);
+
+}  // namespace actions
+
+#endif
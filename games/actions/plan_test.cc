@@ -0,0 +1,56 @@
+#include "games/actions/plan.h"
+
+#include "games/actions/proto/plan.pb.h"
+#include "gtest/gtest.h"
+
+namespace actions {
+
+TEST(Plan, Advance) {
+  proto::Plan plan;
+  EXPECT_EQ(0, StepsLeft(plan));
+  plan.add_steps()->set_action(proto::AA_MOVE);
+  plan.add_steps()->set_action(proto::AA_BUY);
+  plan.add_steps()->set_action(proto::AA_SELL);
+  EXPECT_EQ(3, StepsLeft(plan));
+  EXPECT_EQ(proto::AA_MOVE, CurrentStep(plan).action());
+
+  AdvancePlan(&plan);
+  EXPECT_EQ(2, StepsLeft(plan));
+  EXPECT_EQ(3, plan.steps_size());
+  EXPECT_EQ(proto::AA_BUY, CurrentStep(plan).action());
+
+  AdvancePlan(&plan);
+  EXPECT_EQ(1, StepsLeft(plan));
+  EXPECT_EQ(proto::AA_SELL, CurrentStep(plan).action());
+
+  // Finishing the plan clears it.
+  AdvancePlan(&plan);
+  EXPECT_EQ(0, StepsLeft(plan));
+  EXPECT_EQ(0, plan.steps_size());
+  EXPECT_FALSE(plan.has_next_step());
+
+  AdvancePlan(&plan);
+  EXPECT_EQ(0, StepsLeft(plan));
+}
+
+TEST(Plan, Compact) {
+  proto::Plan plan;
+  plan.add_steps()->set_action(proto::AA_MOVE);
+  plan.add_steps()->set_action(proto::AA_BUY);
+  plan.add_steps()->set_action(proto::AA_SELL);
+  CompactPlan(&plan);
+  EXPECT_EQ(3, plan.steps_size());
+
+  AdvancePlan(&plan);
+  CompactPlan(&plan);
+  EXPECT_FALSE(plan.has_next_step());
+  ASSERT_EQ(2, plan.steps_size());
+  EXPECT_EQ(proto::AA_BUY, CurrentStep(plan).action());
+  EXPECT_EQ(proto::AA_SELL, plan.steps(1).action());
+
+  ClearPlan(&plan);
+  EXPECT_EQ(0, StepsLeft(plan));
+  EXPECT_EQ(0, plan.steps_size());
+}
+
+}  // namespace actions
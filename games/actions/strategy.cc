@@ -4,11 +4,22 @@
 
 #include "absl/strings/substitute.h"
 #include "games/actions/proto/strategy.pb.h"
+#include "util/context/context.h"
 #include "util/status/status.h"
 
-std::unordered_map<std::string, actions::proto::Strategy> registry;
-
 namespace actions {
+namespace {
+
+// Strategies defined in one simulation context.
+struct Strategies {
+  std::unordered_map<std::string, actions::proto::Strategy> registry;
+};
+
+std::unordered_map<std::string, actions::proto::Strategy>& registry() {
+  return util::Context::Current().Get<Strategies>().registry;
+}
+
+}  // namespace
 
 util::Status RegisterStrategy(const actions::proto::Strategy& strategy) {
   if (strategy.key_case() != actions::proto::Strategy::kDefine) {
@@ -16,6 +27,7 @@ util::Status RegisterStrategy(const actions::proto::Strategy& strategy) {
         "Cannot register a strategy without 'define' field set");
   }
   const std::string& name = strategy.define();
+  auto& registry = actions::registry();
   if (registry.find(name) != registry.end()) {
     return util::AlreadyExistsError(
         absl::Substitute("Strategy $0 already registered", name));
@@ -31,6 +43,7 @@ util::Status LoadStrategy(const std::string& name,
         "Cannot copy into null Strategy pointer");
   }
 
+  auto& registry = actions::registry();
   if (registry.find(name) == registry.end()) {
     return util::NotFoundError(
         absl::Substitute("Strategy $0 not found in registry", name));
@@ -1,129 +1,254 @@
 #include "games/ai/executer.h"
 
+#include <deque>
+#include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "absl/strings/substitute.h"
+#include "games/actions/plan.h"
 #include "games/actions/proto/plan.pb.h"
 #include "games/ai/impl/executor_impl.h"
 #include "games/geography/connection.h"
 #include "games/units/unit.h"
 #include "util/arithmetic/microunits.h"
+#include "util/context/context.h"
 #include "util/logging/logging.h"
 #include "util/status/status.h"
 
 namespace ai {
 namespace {
 
-std::unordered_map<actions::proto::AtomicAction, StepExecutor>
-    execution_action_map = {
-        {actions::proto::AA_MOVE, ai::impl::MoveUnit},
-        {actions::proto::AA_BUY, ai::impl::BuyOrSell},
-        {actions::proto::AA_SELL, ai::impl::BuyOrSell},
-        {actions::proto::AA_TURN_AROUND, ai::impl::TurnAround},
-        {actions::proto::AA_SWITCH_STATE, ai::impl::SwitchState},
+// The executor and cost calculator registered for one action ID.
+struct Handler {
+  StepExecutor execute;
+  CostCalculator cost;
 };
-std::unordered_map<actions::proto::AtomicAction, CostCalculator>
-    action_cost_map = {};
 
-std::unordered_map<std::string, StepExecutor> execution_key_map = {};
-std::unordered_map<std::string, CostCalculator> key_cost_map = {};
+// Executors and costs registered in one simulation context, indexed by
+// action ID. Executors may register new keys while running, so handlers are
+// kept in a deque, where adding one does not move the others.
+struct Executors {
+  Executors() : handlers(actions::proto::AtomicAction_ARRAYSIZE) {
+    handlers[actions::proto::AA_MOVE].execute = ai::impl::MoveUnit;
+    handlers[actions::proto::AA_BUY].execute = ai::impl::BuyOrSell;
+    handlers[actions::proto::AA_SELL].execute = ai::impl::BuyOrSell;
+    handlers[actions::proto::AA_TURN_AROUND].execute = ai::impl::TurnAround;
+    handlers[actions::proto::AA_SWITCH_STATE].execute = ai::impl::SwitchState;
+  }
+
+  std::deque<Handler> handlers;
+  std::unordered_map<std::string, ActionId> key_ids;
+  CostCalculator default_cost = nullptr;
+};
 
-CostCalculator default_cost = nullptr;
+Executors& executors() {
+  return util::Context::Current().Get<Executors>();
+}
 
-util::Status executeKey(const ActionCost& cost, const std::string& key,
-                        const actions::proto::Step& step, units::Unit* unit) {
-  if (execution_key_map.find(key) != execution_key_map.end()) {
-    return execution_key_map.at(key)(cost, step, unit);
+ActionId keyActionId(const std::string& key, Executors* registered) {
+  auto found = registered->key_ids.find(key);
+  if (found != registered->key_ids.end()) {
+    return found->second;
   }
-  return util::NotImplementedError(
-      absl::Substitute("Executor for key $0 not implemented", key));
+  const ActionId id = registered->handlers.size();
+  registered->handlers.emplace_back();
+  registered->key_ids.emplace(key, id);
+  return id;
 }
 
-util::Status executeAction(const ActionCost& cost,
-                           actions::proto::AtomicAction action,
-                           const actions::proto::Step& step,
-                           units::Unit* unit) {
-  if (execution_action_map.find(action) == execution_action_map.end()) {
-    return util::NotImplementedError(
-        absl::Substitute("Executor for action $0 not implemented", action));
+ActionId stepActionId(const actions::proto::Step& step,
+                      Executors* registered) {
+  switch (step.trigger_case()) {
+    case actions::proto::Step::kKey:
+      return keyActionId(step.key(), registered);
+    case actions::proto::Step::kAction:
+      return step.action();
+    case actions::proto::Step::TRIGGER_NOT_SET:
+    default:
+      return kNoAction;
+  }
+}
+
+// Returns the handler for id, or null if it is out of range.
+const Handler* findHandler(const Executors& registered, ActionId id) {
+  if (id < 0 || id >= static_cast<ActionId>(registered.handlers.size())) {
+    return nullptr;
+  }
+  return &registered.handlers[id];
+}
+
+ActionCost getCost(const Executors& registered, const Handler* handler,
+                   const actions::proto::Step& step, const units::Unit& unit) {
+  if (handler != nullptr && handler->cost != nullptr) {
+    return handler->cost(step, unit);
+  }
+  // A key without a cost of its own uses the AA_UNKNOWN cost, if any.
+  if (step.trigger_case() == actions::proto::Step::kKey) {
+    const auto& unknown = registered.handlers[actions::proto::AA_UNKNOWN];
+    if (unknown.cost != nullptr) {
+      return unknown.cost(step, unit);
+    }
+  }
+  if (registered.default_cost != nullptr) {
+    return registered.default_cost(step, unit);
+  }
+  return ZeroCost(step, unit);
+}
+
+// Charges the unit for step, whose action ID is id, and runs its executor. The
+// unit must not be null. The handler is looked up by id here rather than
+// passed in, since the cost calculator may register new actions.
+util::LazyStatus executeStep(const Executors& registered, ActionId id,
+                             const actions::proto::Step& step,
+                             units::Unit* unit) {
+  const auto action =
+      getCost(registered, findHandler(registered, id), step, *unit);
+  const Handler* handler = findHandler(registered, id);
+  if (action.cost_u > unit->action_points_u()) {
+    return util::LazyStatus(absl::StatusCode::kFailedPrecondition,
+                            "Not enough action points");
+  }
+  unit->use_action_points(action.cost_u);
+  if (handler == nullptr || handler->execute == nullptr) {
+    switch (step.trigger_case()) {
+      case actions::proto::Step::kKey: {
+        // Keys are never removed once interned, so the registry's copy
+        // outlives the status.
+        auto found = registered.key_ids.find(step.key());
+        if (found == registered.key_ids.end()) {
+          return util::LazyStatus(absl::StatusCode::kUnimplemented,
+                                  "Executor for key not implemented");
+        }
+        return util::LazyStatus::Deferred(
+            absl::StatusCode::kUnimplemented, [key = &found->first]() {
+              return absl::Substitute("Executor for key $0 not implemented",
+                                      *key);
+            });
+      }
+      case actions::proto::Step::kAction:
+        return util::LazyStatus::Deferred(
+            absl::StatusCode::kUnimplemented, [action = step.action()]() {
+              return absl::Substitute(
+                  "Executor for action $0 not implemented", action);
+            });
+      case actions::proto::Step::TRIGGER_NOT_SET:
+      default:
+        return util::LazyStatus(absl::StatusCode::kInvalidArgument,
+                                "Plan step has neither action or key");
+    }
   }
-  return execution_action_map[step.action()](cost, step, unit);  
+  return handler->execute(action, step, unit);
 }
 
 }  // namespace
 
+ActionId KeyActionId(const std::string& key) {
+  return keyActionId(key, &executors());
+}
+
+ActionId StepActionId(const actions::proto::Step& step) {
+  return stepActionId(step, &executors());
+}
+
 void RegisterCost(const std::string& key, CostCalculator cost) {
-  key_cost_map[key] = cost;
+  Executors& registered = executors();
+  registered.handlers[keyActionId(key, &registered)].cost = cost;
 }
 
 void RegisterCost(actions::proto::AtomicAction action, CostCalculator cost) {
-  action_cost_map[action] = cost;
+  executors().handlers[action].cost = cost;
 }
 
 void RegisterDefaultCost(CostCalculator cost) {
-  default_cost = cost;
+  executors().default_cost = cost;
 }
 
 void RegisterExecutor(const std::string& key, StepExecutor exe) {
-  execution_key_map[key] = exe;
+  Executors& registered = executors();
+  registered.handlers[keyActionId(key, &registered)].execute = exe;
 }
 
 void RegisterExecutor(actions::proto::AtomicAction action, StepExecutor exe) {
-  execution_action_map[action] = exe;
+  executors().handlers[action].execute = exe;
 }
 
 ActionCost GetCost(const actions::proto::Step& step, const units::Unit& unit) {
-  switch (step.trigger_case()) {
-    case actions::proto::Step::kKey:
-      if (key_cost_map.find(step.key()) != key_cost_map.end()) {
-        return key_cost_map.at(step.key())(step, unit);
-      }
-    case actions::proto::Step::kAction:
-      if (action_cost_map.find(step.action()) != action_cost_map.end()) {
-        return action_cost_map.at(step.action())(step, unit);
-      }
-    default:
-      break;
+  Executors& registered = executors();
+  return getCost(registered,
+                 findHandler(registered, stepActionId(step, &registered)),
+                 step, unit);
+}
+
+util::LazyStatus ExecuteStep(const actions::proto::Plan& plan,
+                             units::Unit* unit) {
+  if (actions::StepsLeft(plan) == 0) {
+    return util::LazyStatus(absl::StatusCode::kInvalidArgument,
+                            "No steps in plan");
   }
-  if (default_cost != nullptr) {
-    return default_cost(step, unit);
+  if (unit == nullptr) {
+    return util::LazyStatus(absl::StatusCode::kInvalidArgument, "Null unit");
   }
-  return ZeroCost(step, unit);
+  Executors& registered = executors();
+  const auto& step = actions::CurrentStep(plan);
+  return executeStep(registered, stepActionId(step, &registered), step, unit);
 }
 
-util::Status ExecuteStep(const actions::proto::Plan& plan, units::Unit* unit) {
-  if (plan.steps_size() == 0) {
-    return util::InvalidArgumentError("No steps in plan");
+void ExecuteSteps(const std::vector<units::Unit*>& units,
+                  std::vector<util::LazyStatus>* statuses) {
+  statuses->assign(units.size(), util::LazyStatus());
+  Executors& registered = executors();
+
+  // Resolve every step to its action ID, then counting-sort the units by ID,
+  // which keeps their order within each group. Bucket zero holds steps with
+  // no action ID.
+  std::vector<ActionId> ids(units.size(), kNoAction);
+  for (int i = 0; i < units.size(); ++i) {
+    units::Unit* unit = units[i];
+    if (unit == nullptr) {
+      (*statuses)[i] =
+          util::LazyStatus(absl::StatusCode::kInvalidArgument, "Null unit");
+      continue;
+    }
+    if (actions::StepsLeft(unit->plan()) == 0) {
+      (*statuses)[i] = util::LazyStatus(absl::StatusCode::kInvalidArgument,
+                                        "No steps in plan");
+      continue;
+    }
+    ids[i] = stepActionId(actions::CurrentStep(unit->plan()), &registered);
   }
-  if (unit == nullptr) {
-    return util::InvalidArgumentError("Null unit");
+  std::vector<int> starts(registered.handlers.size() + 2, 0);
+  for (int i = 0; i < units.size(); ++i) {
+    if ((*statuses)[i].ok()) {
+      ++starts[ids[i] + 2];
+    }
   }
-  const auto& step = plan.steps(0);
-  const auto action = GetCost(step, *unit);
-  if (action.cost_u > unit->action_points_u()) {
-    return util::FailedPreconditionError("Not enough action points");
+  for (int b = 1; b < starts.size(); ++b) {
+    starts[b] += starts[b - 1];
   }
-  unit->use_action_points(action.cost_u);
-  switch (step.trigger_case()) {
-    case actions::proto::Step::kKey:
-      return executeKey(action, step.key(), step, unit);
-    case actions::proto::Step::kAction:
-      return executeAction(action, step.action(), step, unit);
-    case actions::proto::Step::TRIGGER_NOT_SET:
-    default:
-      return util::InvalidArgumentError("Plan step has neither action or key");
-      break;
+  std::vector<int> order(starts.back());
+  for (int i = 0; i < units.size(); ++i) {
+    if ((*statuses)[i].ok()) {
+      order[starts[ids[i] + 1]++] = i;
+    }
   }
 
-  return util::NotImplementedError("This error message should be unreachable.");
+  // Placing the units has moved each starts[b] to the end of bucket b.
+  int begin = 0;
+  for (int bucket = 0; bucket + 1 < starts.size(); ++bucket) {
+    const int end = starts[bucket];
+    for (int k = begin; k < end; ++k) {
+      const int i = order[k];
+      (*statuses)[i] =
+          executeStep(registered, bucket - 1,
+                      actions::CurrentStep(units[i]->plan()), units[i]);
+    }
+    begin = end;
+  }
 }
 
 void DeleteStep(actions::proto::Plan* plan) {
-  if (plan->steps_size() == 1) {
-    plan->clear_steps();
-  } else if (plan->steps_size() > 1) {
-    plan->mutable_steps()->DeleteSubrange(0, 1);
-  }
+  actions::AdvancePlan(plan);
 }
 
 } // namespace ai
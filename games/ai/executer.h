@@ -2,11 +2,13 @@
 #define GAMES_AI_EXECUTER_H
 
 #include <string>
+#include <vector>
 
 #include "games/ai/public/cost.h"
 #include "games/actions/proto/plan.pb.h"
 #include "games/units/unit.h"
 #include "util/arithmetic/microunits.h"
+#include "util/status/lazy_status.h"
 #include "util/status/status.h"
 
 namespace ai {
@@ -15,6 +17,17 @@ typedef std::function<util::Status(const ActionCost&,
                                    const actions::proto::Step&, units::Unit*)>
     StepExecutor;
 
+// Identifies the executor and cost of a step. AtomicAction values are their
+// own IDs; each key is given the next free ID the first time it is seen.
+typedef int ActionId;
+constexpr ActionId kNoAction = -1;
+
+// Returns the ID of key, giving it one if it has none yet.
+ActionId KeyActionId(const std::string& key);
+
+// Returns the ID of the step's action or key, or kNoAction if it has neither.
+ActionId StepActionId(const actions::proto::Step& step);
+
 void RegisterExecutor(const std::string& key, StepExecutor exe);
 void RegisterExecutor(actions::proto::AtomicAction action, StepExecutor exe);
 
@@ -22,11 +35,19 @@ void RegisterCost(const std::string& key, CostCalculator cost);
 void RegisterCost(actions::proto::AtomicAction action, CostCalculator cost);
 void RegisterDefaultCost(CostCalculator cost);
 
-// Executes the first step of plan; returns a status showing either success, or
+// Executes the current step of plan; returns a status showing either success, or
 // what the problem was.
-util::Status ExecuteStep(const actions::proto::Plan& plan, units::Unit* unit);
+util::LazyStatus ExecuteStep(const actions::proto::Plan& plan,
+                             units::Unit* unit);
+
+// Executes the current step of each unit's plan as ExecuteStep would, putting
+// the result for units[i] in statuses[i]. The steps are grouped by action ID
+// and each group is run in turn, so units with the same kind of step act
+// together; within a group, units act in the order given.
+void ExecuteSteps(const std::vector<units::Unit*>& units,
+                  std::vector<util::LazyStatus>* statuses);
 
-// Deletes the first step of plan.
+// Marks the current step of plan done, as actions::AdvancePlan.
 void DeleteStep(actions::proto::Plan* plan);
 
 // Returns the cost of the action for the unit, first looking for a specially
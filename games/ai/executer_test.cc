@@ -1,10 +1,17 @@
 #include "games/ai/executer.h"
 
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "games/actions/plan.h"
 #include "games/actions/proto/plan.pb.h"
 #include "games/units/unit.h"
 #include "games/units/proto/templates.pb.h"
 #include "games/units/proto/units.pb.h"
 #include "games/units/unit.h"
+#include "util/context/context.h"
 #include "util/proto/object_id.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -29,9 +36,11 @@ TEST_F(ExecuterTest, TestDeleteStep) {
   EXPECT_EQ(0, plan_.steps_size());
   step = plan_.add_steps();
   step = plan_.add_steps();
-  EXPECT_EQ(2, plan_.steps_size());
+  EXPECT_EQ(2, actions::StepsLeft(plan_));
+  DeleteStep(&plan_);
+  EXPECT_EQ(1, actions::StepsLeft(plan_));
   DeleteStep(&plan_);
-  EXPECT_EQ(1, plan_.steps_size());
+  EXPECT_EQ(0, plan_.steps_size());
 }
 
 TEST_F(ExecuterTest, TestExecuteStep) {
@@ -109,6 +118,116 @@ TEST_F(ExecuterTest, TestExecuteStep) {
   EXPECT_EQ(0, unit->action_points_u());
 }
 
+TEST_F(ExecuterTest, TestActionIds) {
+  util::Context context;
+  util::Context::Scope scope(&context);
+
+  actions::proto::Step step;
+  EXPECT_EQ(kNoAction, StepActionId(step));
+  step.set_action(actions::proto::AA_SELL);
+  EXPECT_EQ(actions::proto::AA_SELL, StepActionId(step));
+
+  const ActionId first = KeyActionId("first");
+  const ActionId second = KeyActionId("second");
+  EXPECT_GE(first, actions::proto::AtomicAction_ARRAYSIZE);
+  EXPECT_NE(first, second);
+  EXPECT_EQ(first, KeyActionId("first"));
+  step.set_key("second");
+  EXPECT_EQ(second, StepActionId(step));
+}
+
+TEST_F(ExecuterTest, TestExecuteSteps) {
+  util::Context context;
+  util::Context::Scope scope(&context);
+
+  units::proto::Template temp;
+  temp.mutable_template_id()->set_kind("batch");
+  temp.set_base_action_points_u(1);
+  units::Unit::RegisterTemplate(temp);
+
+  std::vector<std::string> order;
+  auto record = [&order](const ActionCost&, const actions::proto::Step&,
+                         units::Unit* unit) {
+    order.push_back(util::objectid::DisplayString(unit->unit_id()));
+    return util::OkStatus();
+  };
+  RegisterExecutor("wait", record);
+  RegisterExecutor(actions::proto::AA_BUY, record);
+
+  std::vector<std::unique_ptr<units::Unit>> owned;
+  std::vector<units::Unit*> acting;
+  auto add = [&](int number) {
+    units::proto::Unit unit_proto;
+    unit_proto.mutable_unit_id()->set_kind("batch");
+    unit_proto.mutable_unit_id()->set_number(number);
+    owned.push_back(units::Unit::FromProto(unit_proto));
+    acting.push_back(owned.back().get());
+    return owned.back()->mutable_plan()->add_steps();
+  };
+  add(1)->set_key("wait");
+  add(2)->set_action(actions::proto::AA_BUY);
+  add(3)->set_key("wait");
+  add(4);
+  add(5)->set_key("unregistered");
+  acting.push_back(nullptr);
+
+  std::vector<util::LazyStatus> statuses;
+  ExecuteSteps(acting, &statuses);
+  ASSERT_EQ(acting.size(), statuses.size());
+  EXPECT_TRUE(statuses[0].ok()) << statuses[0].ToString();
+  EXPECT_TRUE(statuses[1].ok()) << statuses[1].ToString();
+  EXPECT_TRUE(statuses[2].ok()) << statuses[2].ToString();
+  EXPECT_THAT(statuses[3].ToString(),
+              testing::HasSubstr("neither action or key"));
+  EXPECT_THAT(statuses[4].ToString(), testing::HasSubstr("not implemented"));
+  EXPECT_THAT(statuses[5].ToString(), testing::HasSubstr("Null unit"));
+
+  // Grouped by action, in the given order within each group.
+  ASSERT_EQ(3, order.size());
+  EXPECT_EQ(util::objectid::DisplayString(acting[1]->unit_id()), order[0]);
+  EXPECT_EQ(util::objectid::DisplayString(acting[0]->unit_id()), order[1]);
+  EXPECT_EQ(util::objectid::DisplayString(acting[2]->unit_id()), order[2]);
+}
+
+TEST_F(ExecuterTest, RegisterDuringBatch) {
+  util::Context context;
+  util::Context::Scope scope(&context);
+
+  units::proto::Template temp;
+  temp.mutable_template_id()->set_kind("registering");
+  temp.set_base_action_points_u(1);
+  units::Unit::RegisterTemplate(temp);
+
+  // Each run registers enough new keys to make the registry grow.
+  int runs = 0;
+  auto grow = [&runs](const ActionCost&, const actions::proto::Step&,
+                      units::Unit*) {
+    for (int i = 0; i < 100; ++i) {
+      KeyActionId(absl::StrCat("new_", runs, "_", i));
+    }
+    ++runs;
+    return util::OkStatus();
+  };
+  RegisterExecutor("grow", grow);
+
+  std::vector<std::unique_ptr<units::Unit>> owned;
+  std::vector<units::Unit*> acting;
+  for (int number = 1; number <= 3; ++number) {
+    units::proto::Unit unit_proto;
+    unit_proto.mutable_unit_id()->set_kind("registering");
+    unit_proto.mutable_unit_id()->set_number(number);
+    owned.push_back(units::Unit::FromProto(unit_proto));
+    owned.back()->mutable_plan()->add_steps()->set_key("grow");
+    acting.push_back(owned.back().get());
+  }
+
+  std::vector<util::LazyStatus> statuses;
+  ExecuteSteps(acting, &statuses);
+  for (const auto& status : statuses) {
+    EXPECT_TRUE(status.ok()) << status.ToString();
+  }
+  EXPECT_EQ(3, runs);
+}
 
 } // namespace impl
 } // namespace ai
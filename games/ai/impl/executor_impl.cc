@@ -66,7 +66,7 @@ util::Status MoveUnit(const ActionCost& cost, const actions::proto::Step& step,
   const auto& connection_id = step.connection_id();
   *location->mutable_connection_id() = connection_id;
   // Connection known to exist from validation.
-  const auto* connection = geography::Connection::ById(connection_id);
+  auto* connection = geography::Connection::ById(connection_id);
   uint64 progress_u = location->progress_u();
   uint64 length_u = connection->length_u() - progress_u;
   uint64 distance_u =
@@ -79,9 +79,8 @@ util::Status MoveUnit(const ActionCost& cost, const actions::proto::Step& step,
         util::objectid::DisplayString(a_area_id),
         util::objectid::DisplayString(z_area_id));
 
-  geography::Connection::Movement movement(connection_id, unit_id, a_area_id,
-                                           progress_u, distance_u);
-  connection->Listen(movement);
+  connection->Record(
+      {unit, progress_u, distance_u, a_area_id == connection->a_id()});
   if (distance_u >= length_u) {
     location->clear_progress_u();
     *location->mutable_a_area_id() = z_area_id;
@@ -121,13 +120,15 @@ util::Status BuyOrSell(const ActionCost& cost, const actions::proto::Step& step,
         util::objectid::DisplayString(location.a_area_id()));
   }
 
+  // The market keeps the container for unfilled buy offers and deferred
+  // credit, and fills it later.
   if (step.action() == actions::proto::AA_BUY) {
-    market->TryToBuy(step.good(), unit->Capacity(step.good()),
-                     unit->mutable_resources());
+    const auto capacity_u = unit->RemainingCapacity(step.good());
+    market->TryToBuy(step.good(), capacity_u, unit->share_resources());
   } else {
     market->TryToSell(step.good(),
                       market::GetAmount(unit->resources(), step.good()),
-                      unit->mutable_resources());
+                      unit->share_resources());
   }
 
   return util::OkStatus();
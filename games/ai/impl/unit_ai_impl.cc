@@ -70,16 +70,16 @@ CalculateDistance(const std::vector<geography::Connection::IdType>& path,
   return distance;
 }
 
-util::Status FindPath(const geography::proto::Location& source,
-                      const CostFunction& cost_function,
-                      const Heuristic& heuristic,
-                      const util::proto::ObjectId& target_id,
-                      std::vector<geography::Connection::IdType>* path) {
+util::LazyStatus FindPath(const geography::proto::Location& source,
+                          const CostFunction& cost_function,
+                          const Heuristic& heuristic,
+                          const util::proto::ObjectId& target_id,
+                          std::vector<geography::Connection::IdType>* path) {
   util::proto::ObjectId start_id = source.a_area_id();
   if (start_id == target_id) {
     DLOGF(Log::P_DEBUG, "FindPath start equals end %d, nothing to do",
           start_id.number());
-    return util::OkStatus();
+    return util::LazyStatus();
   }
 
   DLOGF(Log::P_DEBUG, "FindPath %d -> %d", start_id.number(),
@@ -145,9 +145,16 @@ util::Status FindPath(const geography::proto::Location& source,
   if (visited.find(target_id) == visited.end()) {
     DLOG(Log::P_DEBUG, "  Didn't find a path");
     // Didn't find a path.
-    return util::NotFoundErrorf("Couldn't find path from %s to %s",
-                                util::objectid::DisplayString(start_id),
-                                util::objectid::DisplayString(target_id));
+    // Only the numbers are kept, so that the status does not copy the ids.
+    return util::LazyStatus::Deferred(
+        absl::StatusCode::kNotFound,
+        [start = start_id.number(), target = target_id.number()]() {
+          return absl::StrFormat(
+              "Couldn't find path from %s to %s",
+              util::objectid::DisplayString(util::objectid::New("area", start)),
+              util::objectid::DisplayString(
+                  util::objectid::New("area", target)));
+        });
   }
 
   util::proto::ObjectId current_area_id = target_id;
@@ -156,7 +163,7 @@ util::Status FindPath(const geography::proto::Location& source,
     path->push_back(node.conn_id);
     current_area_id = node.previous_id;
   }
-  return util::OkStatus();
+  return util::LazyStatus();
 }
 
 void PlanPath(const geography::proto::Location& source,
@@ -196,6 +203,7 @@ void PlanPath(const geography::proto::Location& source,
     }
   }
 
+  plan->mutable_steps()->Reserve(plan->steps_size() + path.size());
   for (int i = path.size() - 1; i >= 0; --i) {
     auto& conn_id = path[i];
     DLOGF(Log::P_DEBUG, "  Path step: %s",
@@ -208,11 +216,11 @@ void PlanPath(const geography::proto::Location& source,
 
 // Adds to plan steps for traversing the connections between unit's current
 // location and the provided target area.
-util::Status FindPath(const units::Unit& unit,
-                      const CostFunction& cost_function,
-                      const Heuristic& heuristic,
-                      const util::proto::ObjectId& target_id,
-                      actions::proto::Plan* plan) {
+util::LazyStatus FindPath(const units::Unit& unit,
+                          const CostFunction& cost_function,
+                          const Heuristic& heuristic,
+                          const util::proto::ObjectId& target_id,
+                          actions::proto::Plan* plan) {
   const auto& source = unit.location();
   std::vector<geography::Connection::IdType> path;
   auto status = FindPath(source, cost_function, heuristic, target_id, &path);
@@ -222,7 +230,7 @@ util::Status FindPath(const units::Unit& unit,
 
   PlanPath(unit.location(), path, plan);
 
-  return util::OkStatus();
+  return util::LazyStatus();
 }
 
 util::Status
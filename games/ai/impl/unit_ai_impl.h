@@ -9,6 +9,7 @@
 #include "games/geography/connection.h"
 #include "games/units/unit.h"
 #include "util/arithmetic/microunits.h"
+#include "util/status/lazy_status.h"
 #include "util/status/status.h"
 
 namespace ai {
@@ -36,11 +37,11 @@ CalculateDistance(const std::vector<geography::Connection::IdType>& path,
 
 // Fills path with the lowest-cost steps (using connection IDs) from source to
 // destination.
-util::Status FindPath(const geography::proto::Location& source,
-                      const CostFunction& cost_function,
-                      const Heuristic& heuristic,
-                      const util::proto::ObjectId& target_id,
-                      std::vector<geography::Connection::IdType>* path);
+util::LazyStatus FindPath(const geography::proto::Location& source,
+                          const CostFunction& cost_function,
+                          const Heuristic& heuristic,
+                          const util::proto::ObjectId& target_id,
+                          std::vector<geography::Connection::IdType>* path);
 
 // Adds the steps in path to plan.
 void PlanPath(const geography::proto::Location& source,
@@ -49,11 +50,11 @@ void PlanPath(const geography::proto::Location& source,
 
 // Adds to plan steps for traversing the connections between unit's current
 // location and the provided target area.
-util::Status FindPath(const units::Unit& unit,
-                      const CostFunction& cost_function,
-                      const Heuristic& heuristic,
-                      const util::proto::ObjectId& target_id,
-                      actions::proto::Plan* plan);
+util::LazyStatus FindPath(const units::Unit& unit,
+                          const CostFunction& cost_function,
+                          const Heuristic& heuristic,
+                          const util::proto::ObjectId& target_id,
+                          actions::proto::Plan* plan);
 
 class ShuttleTrader : public ai::UnitAi {
 public:
@@ -1,21 +1,38 @@
 #include "games/ai/planner.h"
 
+#include <memory>
 #include <unordered_map>
 
 #include "absl/strings/substitute.h"
 #include "games/ai/unit_ai.h"
 #include "games/ai/impl/unit_ai_impl.h"
+#include "util/context/context.h"
 #include "util/status/status.h"
 
 namespace ai {
+namespace {
 
-std::unordered_map<actions::proto::Strategy::StrategyCase, UnitAi*> unit_ai_map = {
-  {actions::proto::Strategy::kShuttleTrade, new impl::ShuttleTrader()},
+// Planners registered in one simulation context.
+struct Planners {
+  Planners() : shuttle_trader(new impl::ShuttleTrader()) {
+    unit_ai_map[actions::proto::Strategy::kShuttleTrade] = shuttle_trader.get();
+  }
+
+  std::unique_ptr<UnitAi> shuttle_trader;
+  std::unordered_map<actions::proto::Strategy::StrategyCase, UnitAi*>
+      unit_ai_map;
 };
 
+Planners& planners() {
+  return util::Context::Current().Get<Planners>();
+}
+
+} // namespace
+
 util::Status MakePlan(const units::Unit& unit,
                       const actions::proto::Strategy& strategy,
                       actions::proto::Plan* plan) {
+  auto& unit_ai_map = planners().unit_ai_map;
   if (unit_ai_map.find(strategy.strategy_case()) == unit_ai_map.end()) {
     return util::NotFoundError(
         absl::Substitute("Unknown strategy case $0 in $1",
@@ -31,7 +48,7 @@ util::Status RegisterPlanner(const actions::proto::Strategy& strategy,
     return util::InvalidArgumentError(
         absl::Substitute("Null planner passed for $0", strategy.DebugString()));
   }
-  unit_ai_map[strategy.strategy_case()] = planner;
+  planners().unit_ai_map[strategy.strategy_case()] = planner;
   return util::OkStatus();
 }
 
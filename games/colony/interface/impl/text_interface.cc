@@ -624,21 +624,6 @@ void TextInterface::runGameHandler(char inp) {
   drawWorld();
 }
 
-// Returns false if the field cannot do the chain due to missing fixed capital
-// or raw materials, or being the wrong type.
-bool possible(const geography::proto::Field& field, const industry::Production& chain) {
-  if (!geography::HasFixedCapital(field, chain)) {
-    return false;
-  }
-  if (!geography::HasLandType(field, chain)) {
-    return false;
-  }
-  if (!geography::HasRawMaterials(field, chain)) {
-    return false;
-  }
-  return true;
-}
-
 void TextInterface::selectArea(int idx) {
   if (idx == kNullAreaIndex) {
     selected_area_index_ = -1;
@@ -696,11 +681,14 @@ void TextInterface::changeFieldProcess(bool pos) {
     return;
   }
 
+  // The index handles land type and raw materials; fixed capital is checked
+  // here.
+  std::vector<const industry::Production*> eligible;
+  world_model_->chain_index().Eligible(*field, &eligible);
   std::vector<std::string> possibles = {""};
-  for (const auto& name : world_model_->chain_names()) {
-    const auto& chain = world_model_->chain(name);
-    if (possible(*field, chain)) {
-      possibles.push_back(name);
+  for (const auto* chain : eligible) {
+    if (geography::HasFixedCapital(*field, *chain)) {
+      possibles.push_back(chain->get_name());
     }
   }
 
@@ -1,25 +1,117 @@
 #include "games/factions/factions.h"
 
+#include <utility>
+
 #include "util/arithmetic/bits.h"
+#include "util/context/context.h"
+#include "util/logging/logging.h"
 #include "util/proto/object_id.h"
 
 namespace factions {
+namespace {
+
+// Adds to conflicts every division of the factions in present into two sides
+// such that each side is allied within and hostile to the other, skipping
+// those contained in one already found. Bit j of alliance[i] is set if
+// factions i and j will ally, and likewise for hostile; ids names them.
+void divide(const bits::WideMask& present,
+            const std::vector<bits::WideMask>& alliance,
+            const std::vector<bits::WideMask>& hostile,
+            const std::vector<util::proto::ObjectId>& ids,
+            Conflicts* conflicts) {
+  std::vector<bits::WideMask> combats;
+  for (int ii = present.next(0); ii >= 0; ii = present.next(ii + 1)) {
+    const auto targets = hostile[ii] & present;
+    for (int jj = targets.next(ii + 1); jj >= 0; jj = targets.next(jj + 1)) {
+      std::pair<std::vector<util::proto::ObjectId>,
+                std::vector<util::proto::ObjectId>>
+          conflict({ids[ii]}, {ids[jj]});
+      bits::WideMask oneSide;
+      oneSide.set(ii);
+      bits::WideMask otherSide;
+      otherSide.set(jj);
+      for (int kk = present.next(0); kk >= 0; kk = present.next(kk + 1)) {
+        if (kk == ii || kk == jj) {
+          continue;
+        }
+        if (bits::Subset(oneSide, alliance[kk]) &&
+            bits::Subset(otherSide, hostile[kk])) {
+          oneSide.set(kk);
+          conflict.first.push_back(ids[kk]);
+          continue;
+        }
+        if (bits::Subset(otherSide, alliance[kk]) &&
+            bits::Subset(oneSide, hostile[kk])) {
+          otherSide.set(kk);
+          conflict.second.push_back(ids[kk]);
+        }
+      }
+      const auto current = oneSide | otherSide;
+      bool seen = false;
+      for (const auto& combat : combats) {
+        if (bits::Subset(current, combat)) {
+          seen = true;
+          break;
+        }
+      }
+      if (seen) {
+        continue;
+      }
+      conflicts->push_back(std::move(conflict));
+      combats.push_back(current);
+    }
+  }
+}
+
+constexpr int kPrivilegeBits = 32;
+// Beyond this a POP ID is taken to be garbage rather than given a bit.
+constexpr uint64 kMaxPopId = 1 << 24;
+
+// Returns true if pop_id can be given a bit, logging an error if not.
+bool validPopId(uint64 pop_id) {
+  if (pop_id < kMaxPopId) {
+    return true;
+  }
+  Log::Errorf("POP ID %d is too large for a faction to track", pop_id);
+  return false;
+}
+
+} // namespace
 
-std::unordered_map<uint64, FactionController*> FactionController::faction_map_;
-std::unordered_map<util::proto::ObjectId, FactionController*> id_faction_map_;
+struct FactionController::Registry {
+  std::unordered_map<uint64, FactionController*> by_number;
+  std::unordered_map<util::proto::ObjectId, FactionController*> by_id;
+};
+
+FactionController::Registry& FactionController::registry() {
+  return util::Context::Current().Get<Registry>();
+}
 
 FactionController::FactionController(const proto::Faction& p)
-    : proto_(p), privileges_(p.privileges().begin(), p.privileges().end()) {
+    : proto_(p), privileges_(kPrivilegeBits) {
+  Registry& lookup = registry();
   if (proto_.has_faction_id()) {
-    id_faction_map_[faction_id()] = this;
-    faction_map_[faction_id().number()] = this;
+    lookup.by_id[faction_id()] = this;
+    lookup.by_number[faction_id().number()] = this;
   }
   if (proto_.has_id()) {
-    faction_map_[id()] = this;
+    lookup.by_number[id()] = this;
   }
 
   for (const uint64 pop_id : proto_.pop_ids()) {
-    citizens_.insert(pop_id);
+    if (validPopId(pop_id)) {
+      citizens_.set(pop_id);
+    }
+  }
+  for (const auto& privilege : proto_.privileges()) {
+    if (!validPopId(privilege.first)) {
+      continue;
+    }
+    for (int bit = 0; bit < kPrivilegeBits; ++bit) {
+      if (privilege.second & (1u << bit)) {
+        privileges_[bit].set(privilege.first);
+      }
+    }
   }
 }
 
@@ -28,34 +120,55 @@ const util::proto::ObjectId& FactionController::faction_id() const {
 }
 
 bool FactionController::IsFullCitizen(uint64 pop_id) const {
-  return citizens_.find(pop_id) != citizens_.end();
+  return pop_id < kMaxPopId && citizens_.test(pop_id);
 }
 
 FactionController* FactionController::GetByID(uint64 id) {
-  return faction_map_[id];
+  return registry().by_number[id];
 }
 
 FactionController* FactionController::GetByID(const util::proto::ObjectId& id) {
-  if (id_faction_map_.find(id) == id_faction_map_.end()) {
+  const auto& by_id = registry().by_id;
+  auto found = by_id.find(id);
+  if (found == by_id.end()) {
     return NULL;
   }
-  return id_faction_map_.at(id);
+  return found->second;
 }
 
 bool FactionController::HasPrivileges(uint64 pop_id, int32 mask) const {
-  const auto& it = privileges_.find(pop_id);
-  if (it == privileges_.end()) {
+  if (pop_id >= kMaxPopId) {
     return false;
   }
-  return (it->second & mask) == mask;
+  for (int bit = 0; bit < kPrivilegeBits; ++bit) {
+    if ((mask & (1u << bit)) && !privileges_[bit].test(pop_id)) {
+      return false;
+    }
+  }
+  return true;
 }
 
 bool FactionController::HasAnyPrivilege(uint64 pop_id, int32 mask) const {
-  const auto& it = privileges_.find(pop_id);
-  if (it == privileges_.end()) {
+  if (pop_id >= kMaxPopId) {
     return false;
   }
-  return it->second & mask;
+  for (int bit = 0; bit < kPrivilegeBits; ++bit) {
+    if ((mask & (1u << bit)) && privileges_[bit].test(pop_id)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bits::WideMask FactionController::WithPrivileges(const bits::WideMask& pop_ids,
+                                                 int32 mask) const {
+  bits::WideMask ret = pop_ids;
+  for (int bit = 0; bit < kPrivilegeBits; ++bit) {
+    if (mask & (1u << bit)) {
+      ret &= privileges_[bit];
+    }
+  }
+  return ret;
 }
 
 std::unique_ptr<FactionController>
@@ -70,27 +183,16 @@ FactionController::FromProto(const proto::Faction& proto) {
   return ret;
 }
 
-std::vector<std::pair<std::vector<util::proto::ObjectId>,
-                      std::vector<util::proto::ObjectId>>>
-Divide(const std::vector<util::proto::ObjectId> factions,
-       util::objectid::Predicate willAlly,
-       util::objectid::Predicate willFight) {
-  std::vector<std::pair<std::vector<util::proto::ObjectId>,
-                        std::vector<util::proto::ObjectId>>>
-      conflicts;
-
-  auto numFactions = factions.size();
-  std::vector<bits::Mask> alliance;
-  std::vector<bits::Mask> hostile;
-  for (unsigned int ii = 0; ii < numFactions; ++ii) {
-    alliance.push_back(bits::GetMask(ii));
-    hostile.push_back(bits::kEmpty);
-  }
+Conflicts Divide(const std::vector<util::proto::ObjectId> factions,
+                 util::objectid::Predicate willAlly,
+                 util::objectid::Predicate willFight) {
+  const unsigned int numFactions = factions.size();
+  std::vector<bits::WideMask> alliance(numFactions);
+  std::vector<bits::WideMask> hostile(numFactions);
+  bits::WideMask present;
   for (unsigned int ii = 0; ii < numFactions; ++ii) {
+    present.set(ii);
     for (unsigned int jj = ii+1; jj < numFactions; ++jj) {
-      if (ii == jj) {
-        continue;
-      }
       if (willAlly(factions[ii], factions[jj])) {
         alliance[ii].set(jj);
         alliance[jj].set(ii);
@@ -102,56 +204,50 @@ Divide(const std::vector<util::proto::ObjectId> factions,
     }
   }
 
-  std::vector<bits::Mask> combats;
-  for (unsigned int ii = 0; ii < numFactions; ++ii) {
-    for (unsigned int jj = ii+1; jj < numFactions; ++jj) {
-      if (!hostile[ii].test(jj)) {
-        continue;
-      }
+  Conflicts conflicts;
+  divide(present, alliance, hostile, factions, &conflicts);
+  return conflicts;
+}
 
-      auto combat = bits::GetMask(ii, jj);
-      auto conflict = std::pair<std::vector<util::proto::ObjectId>,
-                                std::vector<util::proto::ObjectId>>(
-          {factions[ii]}, {factions[jj]});
-      auto oneSide = bits::GetMask(ii);
-      auto otherSide = bits::GetMask(jj);
-      for (unsigned int kk = 0; kk < numFactions; ++kk) {
-        if (kk == ii || kk == jj) {
-          continue;
-        }
-        auto support = alliance[kk] & oneSide;
-        if (support == oneSide) {
-          auto oppose = hostile[kk] & otherSide;
-          if (oppose == otherSide) {
-            oneSide.set(kk);
-            conflict.first.push_back(factions[kk]);
-            continue;
-          }
-        }
-        support = alliance[kk] & otherSide;
-        if (support == otherSide) {
-          auto oppose = hostile[kk] & oneSide;
-          if (oppose == oneSide) {
-            conflict.second.push_back(factions[kk]);
-            otherSide.set(kk);
-          }
-        }
-      }
-      bool seen = false;
-      auto current = oneSide | otherSide;
-      for (const auto& combat : combats) {
-        if (bits::Subset(current, combat)) {
-          seen = true;
-          break;
-        }
-      }
-      if (seen) {
-        continue;
-      }
-      conflicts.push_back(conflict);
-      combats.push_back(current);
+Relations::Relations(util::objectid::Predicate willAlly,
+                     util::objectid::Predicate willFight)
+    : willAlly_(willAlly), willFight_(willFight) {}
+
+unsigned int Relations::index(const util::proto::ObjectId& faction_id) {
+  auto found = indices_.find(faction_id);
+  if (found != indices_.end()) {
+    return found->second;
+  }
+  const unsigned int idx = ids_.size();
+  indices_.emplace(faction_id, idx);
+  ids_.push_back(faction_id);
+  allies_.emplace_back();
+  enemies_.emplace_back();
+  for (unsigned int other = 0; other < idx; ++other) {
+    if (willAlly_(ids_[other], faction_id)) {
+      allies_[other].set(idx);
+      allies_[idx].set(other);
+    }
+    if (willFight_(ids_[other], faction_id)) {
+      enemies_[other].set(idx);
+      enemies_[idx].set(other);
     }
   }
+  return idx;
+}
+
+const Conflicts&
+Relations::Divide(const std::vector<util::proto::ObjectId>& factions) {
+  bits::WideMask present;
+  for (const auto& faction_id : factions) {
+    present.set(index(faction_id));
+  }
+  auto found = divisions_.find(present);
+  if (found != divisions_.end()) {
+    return found->second;
+  }
+  auto& conflicts = divisions_[present];
+  divide(present, allies_, enemies_, ids_, &conflicts);
   return conflicts;
 }
 
@@ -3,23 +3,60 @@
 
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "games/factions/proto/factions.pb.h"
+#include "util/arithmetic/bits.h"
 #include "util/headers/int_types.h"
 #include "util/proto/object_id.h"
 
 namespace factions {
 
+// Pairs of opposing sides.
+typedef std::vector<std::pair<std::vector<util::proto::ObjectId>,
+                              std::vector<util::proto::ObjectId>>>
+    Conflicts;
+
 // Divide returns pairs of sets of the provided IDs such that each pair
 // is a possible candidate for a conflict. This means that in each set,
 // every faction willAlly every other; and every faction in one set willFight
 // every faction in the other. Note that not every ID is necessarily assigned
 // to a conflict; indeed there may be no conflicts at all. Also note that
 // factions may be assigned to more than one conflict.
-std::vector<std::pair<std::vector<util::proto::ObjectId>,
-                      std::vector<util::proto::ObjectId>>>
-Divide(const std::vector<util::proto::ObjectId> factions,
-       util::objectid::Predicate willAlly, util::objectid::Predicate willFight);
+Conflicts Divide(const std::vector<util::proto::ObjectId> factions,
+                 util::objectid::Predicate willAlly,
+                 util::objectid::Predicate willFight);
+
+// Alliances and enmities between factions, asked of the predicates once per
+// pair and kept as bitsets, so that dividing factions into sides costs a few
+// mask operations per faction. Divisions are cached by the set of factions
+// divided, since the same factions tend to meet again and again; this
+// assumes the predicates never change their answers.
+class Relations {
+public:
+  Relations(util::objectid::Predicate willAlly,
+            util::objectid::Predicate willFight);
+
+  // As the free Divide, except that conflicts and the factions within them
+  // follow the order in which this object first saw the factions, rather
+  // than the order given.
+  const Conflicts& Divide(const std::vector<util::proto::ObjectId>& factions);
+
+private:
+  // Returns the index of faction_id, giving it one if it has none.
+  unsigned int index(const util::proto::ObjectId& faction_id);
+
+  util::objectid::Predicate willAlly_;
+  util::objectid::Predicate willFight_;
+  std::unordered_map<util::proto::ObjectId, unsigned int> indices_;
+  std::vector<util::proto::ObjectId> ids_;
+  // Bit j of allies_[i] is set if factions i and j will ally; likewise for
+  // enemies_ and fighting.
+  std::vector<bits::WideMask> allies_;
+  std::vector<bits::WideMask> enemies_;
+  std::unordered_map<bits::WideMask, Conflicts> divisions_;
+};
 
 // Information about the control and extent of a faction.
 class FactionController {
@@ -42,6 +79,15 @@ public:
   // Returns true if the faction has any of the given privileges for the POP.
   bool HasAnyPrivilege(uint64 pop_id, int32 mask) const;
 
+  // Returns those of pop_ids, a mask with bit i set for POP i, for which the
+  // faction has all the given privileges. For checking many POPs at once,
+  // for example every POP in an area.
+  bits::WideMask WithPrivileges(const bits::WideMask& pop_ids,
+                                int32 mask) const;
+
+  // Returns the full citizens, with bit i set for POP i.
+  const bits::WideMask& citizens() const { return citizens_; }
+
   // Returns the controller with the given ID.
   // DEPRECATED: Use the ObjectId instead.
   static FactionController* GetByID(uint64 id);
@@ -57,12 +103,15 @@ private:
 
   // Wire format.
   proto::Faction proto_;
-  // Citizen IDs.
-  std::unordered_set<uint64> citizens_;
-  // Privilege map.
-  std::unordered_map<uint64, int32> privileges_;
-  // Lookup map.
-  static std::unordered_map<uint64, FactionController*> faction_map_;
+  // Citizen IDs. POP IDs are small numbers handed out in sequence, so a
+  // bit per possible ID is dense.
+  bits::WideMask citizens_;
+  // Element b has bit i set if the faction has privilege 1 << b for POP i.
+  std::vector<bits::WideMask> privileges_;
+
+  // Lookup maps of one simulation context.
+  struct Registry;
+  static Registry& registry();
 };
 
 } // namespace factions
@@ -1,5 +1,6 @@
 #include "games/factions/factions.h"
 
+#include <algorithm>
 #include <cmath>
 
 #include "absl/strings/substitute.h"
@@ -56,6 +57,71 @@ TEST_F(FactionControllerTest, TestPrivileges) {
       2, factions::proto::P_OVERRIDE_PRODUCTION | factions::proto::P_MIGRATE));
 }
 
+TEST_F(FactionControllerTest, TestWithPrivileges) {
+  (*proto_.mutable_privileges())[1] =
+      factions::proto::P_OVERRIDE_PRODUCTION | factions::proto::P_MIGRATE;
+  (*proto_.mutable_privileges())[2] = factions::proto::P_OVERRIDE_PRODUCTION;
+  (*proto_.mutable_privileges())[100] = factions::proto::P_MIGRATE;
+  auto faction = FactionController::FromProto(proto_);
+
+  bits::WideMask area;
+  area.set(1);
+  area.set(2);
+  area.set(3);
+  area.set(100);
+  auto overriders =
+      faction->WithPrivileges(area, factions::proto::P_OVERRIDE_PRODUCTION);
+  EXPECT_EQ(2, overriders.count());
+  EXPECT_TRUE(overriders.test(1));
+  EXPECT_TRUE(overriders.test(2));
+  auto migrants = faction->WithPrivileges(area, factions::proto::P_MIGRATE);
+  EXPECT_EQ(2, migrants.count());
+  EXPECT_TRUE(migrants.test(100));
+  auto both = faction->WithPrivileges(
+      area, factions::proto::P_OVERRIDE_PRODUCTION | factions::proto::P_MIGRATE);
+  EXPECT_EQ(1, both.count());
+  EXPECT_TRUE(both.test(1));
+}
+
+TEST_F(FactionControllerTest, TestHighestPrivilegeBit) {
+  const int32 highest = static_cast<int32>(1u << 31);
+  (*proto_.mutable_privileges())[1] = highest;
+  (*proto_.mutable_privileges())[2] = factions::proto::P_MIGRATE;
+  auto faction = FactionController::FromProto(proto_);
+
+  EXPECT_TRUE(faction->HasPrivileges(1, highest));
+  EXPECT_FALSE(faction->HasPrivileges(1, highest | factions::proto::P_MIGRATE));
+  EXPECT_FALSE(faction->HasPrivileges(2, highest));
+  EXPECT_TRUE(faction->HasAnyPrivilege(1, highest));
+  EXPECT_FALSE(faction->HasAnyPrivilege(2, highest));
+
+  bits::WideMask pops;
+  pops.set(1);
+  pops.set(2);
+  auto privileged = faction->WithPrivileges(pops, highest);
+  EXPECT_EQ(1, privileged.count());
+  EXPECT_TRUE(privileged.test(1));
+}
+
+bool sameSide(const std::vector<util::proto::ObjectId>& one,
+              const std::vector<util::proto::ObjectId>& two) {
+  return std::equal(one.begin(), one.end(), two.begin(), two.end(),
+                    util::objectid::Equal);
+}
+
+bool sameConflicts(const Conflicts& one, const Conflicts& two) {
+  if (one.size() != two.size()) {
+    return false;
+  }
+  for (unsigned int i = 0; i < one.size(); ++i) {
+    if (!sameSide(one[i].first, two[i].first) ||
+        !sameSide(one[i].second, two[i].second)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 TEST(Faction, TestCombatSetup) {
   Log::Register(Log::coutLogger);
   struct TestCase {
@@ -258,6 +324,10 @@ TEST(Faction, TestCombatSetup) {
   for (const auto& cc : cases) {
     Log::Infof("Starting Divide test: %s", cc.desc);
     auto conflicts = Divide(cc.factions, cc.willAlly, cc.willFight);
+    Relations relations(cc.willAlly, cc.willFight);
+    EXPECT_TRUE(sameConflicts(conflicts, relations.Divide(cc.factions))) << cc.desc;
+    // Again, from the cache.
+    EXPECT_TRUE(sameConflicts(conflicts, relations.Divide(cc.factions))) << cc.desc;
     EXPECT_EQ(conflicts.size(), cc.allies.size());
     if (conflicts.size() != cc.allies.size()) {
       for (const auto& conflict : conflicts) {
@@ -287,4 +357,26 @@ TEST(Faction, TestCombatSetup) {
   }
 }
 
+TEST(Faction, TestDivideMany) {
+  // More factions than fit in a bits::Mask.
+  std::vector<util::proto::ObjectId> factions;
+  for (int i = 0; i < 40; ++i) {
+    factions.push_back(util::objectid::New("f", i));
+  }
+  Relations relations(util::objectid::Equal, util::objectid::NotEqual);
+  const auto& conflicts = relations.Divide(factions);
+  EXPECT_EQ(40 * 39 / 2, conflicts.size());
+  EXPECT_TRUE(sameConflicts(
+      conflicts,
+      Divide(factions, util::objectid::Equal, util::objectid::NotEqual)));
+
+  // A subset, in a different order, is divided afresh.
+  const auto& few = relations.Divide({factions[35], factions[2]});
+  ASSERT_EQ(1, few.size());
+  ASSERT_EQ(1, few[0].first.size());
+  EXPECT_TRUE(factions[2] == few[0].first[0]);
+  ASSERT_EQ(1, few[0].second.size());
+  EXPECT_TRUE(factions[35] == few[0].second[0]);
+}
+
 }  // namespace factions
@@ -0,0 +1,93 @@
+#include "games/geography/chain_index.h"
+
+#include <utility>
+
+#include "games/geography/geography.h"
+
+namespace geography {
+
+void ChainIndex::Add(const industry::Production& chain) {
+  Entry entry;
+  entry.chain = &chain;
+  entry.uses_raw_materials = false;
+  for (const auto& step : chain.Proto()->steps()) {
+    entry.step_masks.emplace_back();
+    auto& variant_masks = entry.step_masks.back();
+    for (const auto& variant : step.variants()) {
+      GoodsMask mask;
+      for (const auto& raw : variant.raw_materials().quantities()) {
+        entry.uses_raw_materials = true;
+        if (raw.second <= 0) {
+          continue;
+        }
+        auto good = goods_.find(raw.first);
+        if (good == goods_.end()) {
+          if (goods_.size() >= kMaxIndexedGoods) {
+            continue;
+          }
+          good = goods_.emplace(raw.first, goods_.size()).first;
+        }
+        mask.set(good->second);
+      }
+      variant_masks.push_back(mask);
+    }
+  }
+  by_land_type_[chain.Proto()->land_type()].push_back(std::move(entry));
+}
+
+void ChainIndex::Clear() {
+  by_land_type_.clear();
+  goods_.clear();
+}
+
+ChainIndex::GoodsMask
+ChainIndex::presentGoods(const market::proto::Container& con) const {
+  GoodsMask present;
+  for (const auto& quantity : con.quantities()) {
+    if (quantity.second <= 0) {
+      continue;
+    }
+    auto good = goods_.find(quantity.first);
+    if (good == goods_.end()) {
+      continue;
+    }
+    present.set(good->second);
+  }
+  return present;
+}
+
+void ChainIndex::Eligible(
+    const proto::Field& field,
+    std::vector<const industry::Production*>* chains) const {
+  auto bucket = by_land_type_.find(field.land_type());
+  if (bucket == by_land_type_.end()) {
+    return;
+  }
+
+  const GoodsMask present = presentGoods(field.resources());
+  for (const auto& entry : bucket->second) {
+    bool possible = true;
+    for (const auto& variant_masks : entry.step_masks) {
+      bool can_do_step = false;
+      for (const auto& mask : variant_masks) {
+        if ((mask & ~present).none()) {
+          can_do_step = true;
+          break;
+        }
+      }
+      if (!can_do_step) {
+        possible = false;
+        break;
+      }
+    }
+    if (!possible) {
+      continue;
+    }
+    if (entry.uses_raw_materials && !HasRawMaterials(field, *entry.chain)) {
+      continue;
+    }
+    chains->push_back(entry.chain);
+  }
+}
+
+}  // namespace geography
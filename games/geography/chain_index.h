@@ -0,0 +1,57 @@
+// Index of production chains by the field properties they require.
+#ifndef BASE_GEOGRAPHY_CHAIN_INDEX_H
+#define BASE_GEOGRAPHY_CHAIN_INDEX_H
+
+#include <bitset>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "games/geography/proto/geography.pb.h"
+#include "games/industry/industry.h"
+
+namespace geography {
+
+// Groups production chains by land type, with the raw materials of each
+// variant compiled to a bitmask over the goods seen at indexing time. Finding
+// the chains a field can run is then one bucket lookup and a mask test per
+// chain, with the exact amount check only for chains that use raw materials.
+// The result is the same as filtering with HasLandType and HasRawMaterials.
+class ChainIndex {
+public:
+  // Raw-material goods beyond this many are not masked, and chains using them
+  // always get the exact check.
+  static constexpr int kMaxIndexedGoods = 128;
+  typedef std::bitset<kMaxIndexedGoods> GoodsMask;
+
+  // Adds the chain, which must outlive the index.
+  void Add(const industry::Production& chain);
+
+  // Removes all chains.
+  void Clear();
+
+  // Fills chains, which must not be null, with the indexed chains that the
+  // field has the land type and raw materials for, in the order they were
+  // added. Does not clear chains.
+  void Eligible(const proto::Field& field,
+                std::vector<const industry::Production*>* chains) const;
+
+private:
+  struct Entry {
+    const industry::Production* chain;
+    // For each step, the goods required by each variant.
+    std::vector<std::vector<GoodsMask>> step_masks;
+    // True if any variant has raw materials, requiring the exact check.
+    bool uses_raw_materials;
+  };
+
+  // Returns the mask of indexed goods present in the container.
+  GoodsMask presentGoods(const market::proto::Container& con) const;
+
+  std::unordered_map<int, std::vector<Entry>> by_land_type_;
+  std::unordered_map<std::string, int> goods_;
+};
+
+}  // namespace geography
+
+#endif
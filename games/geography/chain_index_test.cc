@@ -0,0 +1,95 @@
+#include "games/geography/chain_index.h"
+
+#include <vector>
+
+#include "games/geography/geography.h"
+#include "games/geography/proto/geography.pb.h"
+#include "games/industry/industry.h"
+#include "games/industry/proto/industry.pb.h"
+#include "games/market/goods_utils.h"
+#include "gtest/gtest.h"
+
+namespace geography {
+namespace {
+constexpr char kOre[] = "ore";
+constexpr char kFish[] = "fish";
+
+industry::proto::Production makeChain(const std::string& name,
+                                      industry::proto::LandType land_type) {
+  industry::proto::Production proto;
+  proto.set_name(name);
+  proto.set_land_type(land_type);
+  proto.add_steps()->add_variants();
+  return proto;
+}
+
+} // namespace
+
+class ChainIndexTest : public testing::Test {
+protected:
+  std::vector<const industry::Production*> eligible(const proto::Field& field) {
+    std::vector<const industry::Production*> chains;
+    index_.Eligible(field, &chains);
+    return chains;
+  }
+
+  ChainIndex index_;
+};
+
+TEST_F(ChainIndexTest, LandType) {
+  industry::Production pasture(makeChain("pasture", industry::proto::LT_PASTURE));
+  industry::Production forest(makeChain("forest", industry::proto::LT_FOREST));
+  index_.Add(pasture);
+  index_.Add(forest);
+
+  proto::Field field;
+  field.set_land_type(industry::proto::LT_FOREST);
+  auto chains = eligible(field);
+  ASSERT_EQ(1, chains.size());
+  EXPECT_EQ(&forest, chains[0]);
+
+  field.set_land_type(industry::proto::LT_ORCHARDS);
+  EXPECT_TRUE(eligible(field).empty());
+}
+
+TEST_F(ChainIndexTest, RawMaterials) {
+  auto mine_proto = makeChain("mine", industry::proto::LT_PASTURE);
+  market::SetAmount(kOre, 2, mine_proto.mutable_steps(0)
+                                 ->mutable_variants(0)
+                                 ->mutable_raw_materials());
+  // Second variant uses fish instead.
+  market::SetAmount(kFish, 1, mine_proto.mutable_steps(0)
+                                  ->add_variants()
+                                  ->mutable_raw_materials());
+  industry::Production mine(mine_proto);
+  industry::Production herd(makeChain("herd", industry::proto::LT_PASTURE));
+  index_.Add(mine);
+  index_.Add(herd);
+
+  proto::Field field;
+  field.set_land_type(industry::proto::LT_PASTURE);
+  auto chains = eligible(field);
+  ASSERT_EQ(1, chains.size());
+  EXPECT_EQ(&herd, chains[0]);
+
+  // Present but not enough.
+  market::SetAmount(kOre, 1, field.mutable_resources());
+  EXPECT_EQ(1, eligible(field).size());
+  EXPECT_FALSE(HasRawMaterials(field, mine));
+
+  market::SetAmount(kOre, 2, field.mutable_resources());
+  chains = eligible(field);
+  ASSERT_EQ(2, chains.size());
+  EXPECT_EQ(&mine, chains[0]);
+  EXPECT_EQ(&herd, chains[1]);
+
+  market::SetAmount(kOre, 0, field.mutable_resources());
+  market::SetAmount(kFish, 1, field.mutable_resources());
+  EXPECT_EQ(2, eligible(field).size());
+  EXPECT_TRUE(HasRawMaterials(field, mine));
+
+  index_.Clear();
+  EXPECT_TRUE(eligible(field).empty());
+}
+
+} // namespace geography
@@ -1,15 +1,11 @@
 #include "games/geography/connection.h"
 
+#include <algorithm>
 #include <functional>
 
+#include "util/context/context.h"
 #include "util/proto/object_id.h"
 
-std::unordered_map<util::proto::ObjectId,
-                   std::unordered_set<geography::Connection*>>
-    endpoint_map_;
-std::unordered_map<uint64, std::unordered_set<geography::Connection*>>
-    both_endpoints_map_;
-std::unordered_map<geography::Connection::IdType, geography::Connection*> id_map_;
 std::equal_to<util::proto::ObjectId> ids_equal;
 
 namespace geography {
@@ -23,33 +19,92 @@ uint64 Fingerprint(const util::proto::ObjectId& one,
 
 } // namespace
 
-Connection::Connection(const proto::Connection& conn) : proto_(conn) {
-  endpoint_map_[proto_.a_area_id()].insert(this);
-  endpoint_map_[proto_.z_area_id()].insert(this);
-  both_endpoints_map_[Fingerprint(proto_.a_area_id(), proto_.z_area_id())]
+struct Connection::Registry {
+  std::unordered_map<util::proto::ObjectId, std::unordered_set<Connection*>>
+      endpoints;
+  std::unordered_map<uint64, std::unordered_set<Connection*>> both_endpoints;
+  std::unordered_map<IdType, Connection*> ids;
+  // Connections with recorded movements, in the order of their first one.
+  std::vector<Connection*> moved;
+};
+
+Connection::Registry& Connection::registry() {
+  return util::Context::Current().Get<Registry>();
+}
+
+Connection::Connection(const proto::Connection& conn)
+    : proto_(conn), registry_(&registry()) {
+  registry_->endpoints[proto_.a_area_id()].insert(this);
+  registry_->endpoints[proto_.z_area_id()].insert(this);
+  registry_->both_endpoints[Fingerprint(proto_.a_area_id(),
+                                        proto_.z_area_id())]
       .insert(this);
-  both_endpoints_map_[Fingerprint(proto_.z_area_id(), proto_.a_area_id())]
+  registry_->both_endpoints[Fingerprint(proto_.z_area_id(),
+                                        proto_.a_area_id())]
       .insert(this);
-  id_map_[proto_.connection_id()] = this;
+  registry_->ids[proto_.connection_id()] = this;
 }
 
 Connection::~Connection() {
-  endpoint_map_[proto_.a_area_id()].erase(this);
-  endpoint_map_[proto_.z_area_id()].erase(this);
-  both_endpoints_map_[Fingerprint(proto_.a_area_id(), proto_.z_area_id())]
+  registry_->endpoints[proto_.a_area_id()].erase(this);
+  registry_->endpoints[proto_.z_area_id()].erase(this);
+  registry_->both_endpoints[Fingerprint(proto_.a_area_id(),
+                                        proto_.z_area_id())]
       .erase(this);
-  both_endpoints_map_[Fingerprint(proto_.z_area_id(), proto_.a_area_id())]
+  registry_->both_endpoints[Fingerprint(proto_.z_area_id(),
+                                        proto_.a_area_id())]
       .erase(this);
-  id_map_.erase(connection_id());
+  registry_->ids.erase(connection_id());
+  if (!movements_.empty()) {
+    auto& moved = registry_->moved;
+    moved.erase(std::find(moved.begin(), moved.end(), this));
+  }
 }
 
 void Connection::Register(const util::proto::ObjectId& listener_id,
                           Connection::Listener* l) {
-  listeners_[listener_id] = l;
+  for (auto& listener : listeners_) {
+    if (listener.first == listener_id) {
+      listener.second = l;
+      return;
+    }
+  }
+  listeners_.emplace_back(listener_id, l);
 }
 
 void Connection::UnRegister(const util::proto::ObjectId& listener_id) {
-  listeners_.erase(listener_id);
+  for (auto it = listeners_.begin(); it != listeners_.end(); ++it) {
+    if (it->first == listener_id) {
+      listeners_.erase(it);
+      return;
+    }
+  }
+}
+
+void Connection::Record(const Connection::Movement& movement) {
+  if (listeners_.empty()) {
+    return;
+  }
+  if (movements_.empty()) {
+    registry_->moved.push_back(this);
+  }
+  movements_.push_back(movement);
+}
+
+void Connection::DeliverMovements() {
+  for (const Connection* connection : registry().moved) {
+    for (const auto& listener : connection->listeners_) {
+      listener.second->Listen(*connection, connection->movements_);
+    }
+  }
+}
+
+void Connection::ClearMovements() {
+  auto& moved = registry().moved;
+  for (Connection* connection : moved) {
+    connection->movements_.clear();
+  }
+  moved.clear();
 }
 
 std::unique_ptr<Connection>
@@ -84,20 +139,22 @@ Connection::FromProto(const proto::Connection& conn) {
 
 const std::unordered_set<Connection*>&
 Connection::ByEndpoint(const util::proto::ObjectId& area_id) {
-  return endpoint_map_[area_id];
+  return registry().endpoints[area_id];
 }
 
 const std::unordered_set<Connection*>&
 Connection::ByEndpoints(const util::proto::ObjectId& area_one,
                         const util::proto::ObjectId& area_two) {
-  return both_endpoints_map_[Fingerprint(area_one, area_two)];
+  return registry().both_endpoints[Fingerprint(area_one, area_two)];
 }
 
 Connection* Connection::ById(const Connection::IdType& conn_id) {
-  if (id_map_.find(conn_id) == id_map_.end()) {
+  const auto& ids = registry().ids;
+  auto found = ids.find(conn_id);
+  if (found == ids.end()) {
     return nullptr;
   }
-  return id_map_.at(conn_id);
+  return found->second;
 }
 
 const util::proto::ObjectId&
@@ -132,10 +189,4 @@ const Area* Connection::OtherSide(const Area* area) const {
   return NULL;
 }
 
-void Connection::Listen(const Connection::Movement& movement) const {
-  for (const auto& listener : listeners_) {
-    listener.second->Listen(movement);
-  }
-}
-
 } // namespace geography
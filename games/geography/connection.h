@@ -6,10 +6,13 @@
 #include <memory>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "games/geography/geography.h"
 #include "games/geography/mobile.h"
 #include "games/geography/proto/geography.pb.h"
+#include "util/arithmetic/microunits.h"
 #include "util/proto/object_id.h"
 #include "util/headers/int_types.h"
 
@@ -23,36 +26,44 @@ class Connection {
 public:
   ~Connection();
 
-  // Holds information about a unit passing through the connection.
+  // One unit's passage along the connection in one round. Plain data, so that
+  // recording a movement copies no protos; the connection is implied by the
+  // buffer the movement is recorded in.
   struct Movement {
-    Movement(const util::proto::ObjectId& conn_id,
-             const util::proto::ObjectId& id,
-             const util::proto::ObjectId& area_id, micro::uMeasure s_u,
-             micro::uMeasure d_u)
-        : start_u(s_u), distance_u(d_u) {
-      connection_id.Clear();
-      connection_id.MergeFrom(conn_id);
-      object_id.Clear();
-      object_id.MergeFrom(id);
-      base_area_id.Clear();
-      base_area_id.MergeFrom(area_id);
-    }
-    util::proto::ObjectId connection_id;
-    util::proto::ObjectId object_id;
-    util::proto::ObjectId base_area_id;
+    // The unit moving.
+    Mobile* mobile;
+    // Distance from the end the unit set out from at the start of the round.
     micro::uMeasure start_u;
+    // Distance covered in the round.
     micro::uMeasure distance_u;
+    // True if the unit set out from the A end.
+    bool from_a;
   };
 
+  // Called once per round with all the movements through a connection.
   struct Listener {
-    virtual void Listen(const Movement& movement) = 0;
+    virtual void Listen(const Connection& connection,
+                        const std::vector<Movement>& movements) = 0;
   };
   typedef util::proto::ObjectId IdType;
 
   // Callbacks for detection and evasion.
   void Register(const util::proto::ObjectId& listener_id, Listener* l);
   void UnRegister(const util::proto::ObjectId& listener_id);
-  void Listen(const Movement& movement) const;
+
+  // Adds movement to this round's buffer; listeners are not called until
+  // DeliverMovements. Does nothing if the connection has no listeners, so
+  // games that never deliver movements also never need to clear them.
+  void Record(const Movement& movement);
+  // Movements recorded since the last ClearMovements.
+  const std::vector<Movement>& movements() const { return movements_; }
+  // Passes each connection's recorded movements to its listeners, one call
+  // per listener and connection, in the order the connections were first
+  // moved through. The movements stay recorded, so listeners may keep
+  // references to them until ClearMovements.
+  static void DeliverMovements();
+  // Empties every connection's movement buffer, ready for the next round.
+  static void ClearMovements();
 
   // Endpoint access.
   Area* a() { return Area::GetById(proto_.a_area_id()); }
@@ -96,11 +107,21 @@ private:
   Connection() = delete;
   Connection(const proto::Connection& conn);
 
+  // Connections of one simulation context.
+  struct Registry;
+  static Registry& registry();
+
   // The underlying data.
   proto::Connection proto_;
 
-  // Listener map.
-  std::unordered_map<util::proto::ObjectId, Listener*> listeners_;
+  // Listeners in the order they were registered.
+  std::vector<std::pair<util::proto::ObjectId, Listener*>> listeners_;
+
+  // This round's movements.
+  std::vector<Movement> movements_;
+
+  // Where this connection is listed.
+  Registry* registry_;
 };
 
 } // namespace geography
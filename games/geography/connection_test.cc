@@ -1,6 +1,7 @@
 #include "games/geography/connection.h"
 
 #include <memory>
+#include <vector>
 
 #include "games/geography/geography.h"
 #include "games/geography/mobile.h"
@@ -138,14 +139,23 @@ TEST_F(ConnectionTest, Listen) {
   ASSERT_NE(connection.get(), nullptr);
 
   struct Counter : public Connection::Listener {
-    Counter() : count_u(0) {}
-    void Listen(const Connection::Movement& movement) {
-      count_u += movement.distance_u;
+    Counter() : calls(0), count_u(0) {}
+    void Listen(const Connection& connection,
+                const std::vector<Connection::Movement>& movements) override {
+      ++calls;
+      for (const auto& movement : movements) {
+        count_u += movement.distance_u;
+      }
     }
+    int calls;
     micro::uMeasure count_u;
   };
 
-  auto area_id = util::objectid::New("area", 1);
+  // Nobody would hear about it, so it is not kept.
+  Connection::Movement movement = {nullptr, 1, 1, true};
+  connection->Record(movement);
+  EXPECT_TRUE(connection->movements().empty());
+
   auto counter_id1 = util::objectid::New("counter", 1);
   Counter counter1 = Counter();
   connection->Register(counter_id1, &counter1);
@@ -153,18 +163,26 @@ TEST_F(ConnectionTest, Listen) {
   Counter counter2 = Counter();
   connection->Register(counter_id2, &counter2);
 
-  auto unit_id = util::objectid::New("unit", 1);
-  Connection::Movement movement(proto_.connection_id(), unit_id, area_id, 1, 1);
-
-  connection->Listen(movement);
-  EXPECT_EQ(counter1.count_u, 1);
-  EXPECT_EQ(counter2.count_u, 1);
-
-  connection->UnRegister(counter_id1);
+  connection->Record(movement);
   movement.distance_u = 2;
-  connection->Listen(movement);
-  EXPECT_EQ(counter1.count_u, 1);
+  connection->Record(movement);
+  // Nobody hears about movements until they are delivered.
+  EXPECT_EQ(counter1.count_u, 0);
+  Connection::DeliverMovements();
+  EXPECT_EQ(counter1.calls, 1);
+  EXPECT_EQ(counter1.count_u, 3);
   EXPECT_EQ(counter2.count_u, 3);
+
+  Connection::ClearMovements();
+  EXPECT_TRUE(connection->movements().empty());
+  connection->UnRegister(counter_id1);
+  movement.distance_u = 4;
+  connection->Record(movement);
+  Connection::DeliverMovements();
+  EXPECT_EQ(counter1.count_u, 3);
+  EXPECT_EQ(counter2.calls, 2);
+  EXPECT_EQ(counter2.count_u, 7);
+  Connection::ClearMovements();
 }
 
 } // namespace geography
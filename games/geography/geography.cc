@@ -7,14 +7,21 @@
 #include "games/industry/proto/industry.pb.h"
 #include "games/market/goods_utils.h"
 #include "games/market/proto/goods.pb.h"
+#include "util/context/context.h"
 #include "util/logging/logging.h"
 #include "util/proto/object_id.h"
 #include "util/status/status.h"
 
-std::unordered_map<util::proto::ObjectId, geography::Area*> area_id_map_;
-
 namespace geography {
 
+struct Area::Registry {
+  std::unordered_map<util::proto::ObjectId, Area*> areas;
+};
+
+Area::Registry& Area::registry() {
+  return util::Context::Current().Get<Registry>();
+}
+
 bool HasFixedCapital(const proto::Field& field,
                      const industry::Production& production) {
   const auto* proto = production.Proto();
@@ -97,7 +104,8 @@ std::unique_ptr<Area> Area::FromProto(const proto::Area& area) {
     Log::Errorf("Invalid area id 0: %s", area.DebugString());
     return ret;
   }
-  if (area_id_map_.find(area.area_id()) != area_id_map_.end()) {
+  const auto& areas = registry().areas;
+  if (areas.find(area.area_id()) != areas.end()) {
     Log::Errorf("Area %s already exists", area.area_id().DebugString());
     return ret;
   }
@@ -105,12 +113,14 @@ std::unique_ptr<Area> Area::FromProto(const proto::Area& area) {
   return ret;
 }
 
-Area::Area(const proto::Area& area) : proto_(area), market_(area.market()) {
-  area_id_map_[proto_.area_id()] = this;
+Area::Area(const proto::Area& area)
+    : proto_(area), generation_(0), market_(area.market()),
+      registry_(&registry()) {
+  registry_->areas[proto_.area_id()] = this;
 }
 
 Area::~Area() {
-  area_id_map_.erase(proto_.area_id());
+  registry_->areas.erase(proto_.area_id());
 }
 
 const util::proto::ObjectId& Area::area_id() const {
@@ -118,13 +128,16 @@ const util::proto::ObjectId& Area::area_id() const {
 }
 
 Area* Area::GetById(const util::proto::ObjectId& area_id) {
-  if (area_id_map_.find(area_id) == area_id_map_.end()) {
+  const auto& areas = registry().areas;
+  auto found = areas.find(area_id);
+  if (found == areas.end()) {
     return nullptr;
   }
-  return area_id_map_.at(area_id);
+  return found->second;
 }
 
 void Area::Update() {
+  ++generation_;
   market::proto::Quantity temp;
   // Recovery of raw materials in the fields, eg topsoil.
   for (auto& field : *(proto_.mutable_fields())) {
@@ -143,6 +156,25 @@ void Area::Update() {
   }
 }
 
+bool Area::Recovered() const {
+  for (const auto& field : proto_.fields()) {
+    const auto& recovery = field.has_progress()
+                               ? proto_.limits().recovery()
+                               : proto_.limits().fallow_recovery();
+    for (const auto& quantity : recovery.quantities()) {
+      if (!market::Contains(field.resources(), quantity.first)) {
+        return false;
+      }
+      auto amount = market::GetAmount(field.resources(), quantity.first);
+      auto maximum = market::GetAmount(proto_.limits().maximum(), quantity.first);
+      if (std::min(amount + quantity.second, maximum) != amount) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
 const std::vector<uint64> Area::pop_ids() const {
   return std::vector<uint64>(proto_.pop_ids().begin(), proto_.pop_ids().end());
 }
@@ -8,6 +8,7 @@
 #include "games/industry/industry.h"
 #include "games/market/market.h"
 #include "games/market/proto/market.pb.h"
+#include "util/headers/int_types.h"
 #include "util/status/status.h"
 
 namespace geography {
@@ -36,11 +37,20 @@ public:
     return market_.Proto().prices_u();
   }
   void Update();
+  // Returns true if Update would not change any field, because every
+  // recovering resource is already at its maximum.
+  bool Recovered() const;
 
   const util::proto::ObjectId& area_id() const;
 
-  proto::Area* Proto() { return &proto_; }
+  proto::Area* Proto() {
+    ++generation_;
+    return &proto_;
+  }
   const proto::Area* Proto() const { return &proto_; }
+  // Changes on every call of a non-const accessor or Update, so that a copy
+  // of the proto taken at the same generation is still current.
+  uint64 generation() const { return generation_; }
   market::Market* mutable_market() { return &market_; }
   const market::Market& market() const { return market_; }
   int numPops() const { return proto_.pop_ids_size(); }
@@ -48,7 +58,10 @@ public:
   int num_fields() const { return proto_.fields_size(); }
   const std::vector<const proto::Field*> fields() const;
   const proto::Field* field(int idx) const { return &proto_.fields(idx); }
-  proto::Field* mutable_field(int idx) { return proto_.mutable_fields(idx); }
+  proto::Field* mutable_field(int idx) {
+    ++generation_;
+    return proto_.mutable_fields(idx);
+  }
 
   static Area* GetById(const util::proto::ObjectId& id);
   static std::unique_ptr<Area> FromProto(const proto::Area& area);
@@ -56,8 +69,16 @@ public:
 private:
   Area() = delete;
   Area(const proto::Area& area);
+
+  // Areas of one simulation context.
+  struct Registry;
+  static Registry& registry();
+
   proto::Area proto_;
+  uint64 generation_;
   market::Market market_;
+  // Where this area is listed.
+  Registry* registry_;
 };
 
 Area* ById(const util::proto::ObjectId& area_id);
@@ -83,8 +83,10 @@ TEST_F(GeographyTest, Recovery) {
 
   auto& resources = *field_->mutable_resources();
   EXPECT_DOUBLE_EQ(market::GetAmount(resources, stuff_), 0);
+  EXPECT_FALSE(area_->Recovered());
   area_->Update();
   EXPECT_DOUBLE_EQ(market::GetAmount(resources, stuff_), 10);
+  EXPECT_TRUE(area_->Recovered());
   area_->Update();
   EXPECT_DOUBLE_EQ(market::GetAmount(resources, stuff_), 10);
 }
@@ -0,0 +1,248 @@
+#include "games/industry/compiled_production.h"
+
+#include "absl/strings/substitute.h"
+
+namespace industry {
+
+int GoodsIndex::Intern(const std::string& name) {
+  auto it = indices_.find(name);
+  if (it != indices_.end()) {
+    return it->second;
+  }
+  int idx = names_.size();
+  indices_.emplace(name, idx);
+  names_.push_back(name);
+  return idx;
+}
+
+int GoodsIndex::Find(const std::string& name) const {
+  auto it = indices_.find(name);
+  if (it == indices_.end()) {
+    return -1;
+  }
+  return it->second;
+}
+
+void GoodsIndex::ToDense(const market::proto::Container& con,
+                         micro::Measure* dense) const {
+  for (int i = 0; i < size(); ++i) {
+    dense[i] = 0;
+  }
+  for (const auto& quantity : con.quantities()) {
+    int idx = Find(quantity.first);
+    if (idx < 0) {
+      continue;
+    }
+    dense[idx] = quantity.second;
+  }
+}
+
+void GoodsIndex::FromDense(const micro::Measure* dense,
+                           market::proto::Container* con) const {
+  auto& quantities = *con->mutable_quantities();
+  for (int i = 0; i < size(); ++i) {
+    if (dense[i] == 0 && quantities.find(names_[i]) == quantities.end()) {
+      continue;
+    }
+    quantities[names_[i]] = dense[i];
+  }
+}
+
+CompiledProduction::CompiledProduction(const Production& chain,
+                                       GoodsIndex* goods)
+    : chain_(&chain) {
+  const auto& proto = *chain.Proto();
+  step_offsets_.push_back(0);
+  for (const auto& step : proto.steps()) {
+    for (const auto& input : step.variants()) {
+      Variant variant;
+      variant.inputs.begin = input_terms_.size();
+      // Consumables and movable capital of the same good share a term.
+      for (const auto& good : input.consumables().quantities()) {
+        input_terms_.push_back({goods->Intern(good.first), good.second, 0});
+      }
+      for (const auto& good : input.movable_capital().quantities()) {
+        int idx = goods->Intern(good.first);
+        bool found = false;
+        for (int i = variant.inputs.begin; i < input_terms_.size(); ++i) {
+          if (input_terms_[i].good == idx) {
+            input_terms_[i].capital_u = good.second;
+            found = true;
+            break;
+          }
+        }
+        if (!found) {
+          input_terms_.push_back({idx, 0, good.second});
+        }
+      }
+      variant.inputs.end = input_terms_.size();
+      variant.fixed_capital = addTerms(input.fixed_capital(), goods);
+      variant.raw_materials = addTerms(input.raw_materials(), goods);
+      variant.install_cost = addTerms(input.install_cost(), goods);
+
+      variant.resources.begin = resource_terms_.size();
+      variant.resources.end = variant.resources.begin;
+      for (const Term* t = begin(variant.fixed_capital);
+           t != end(variant.fixed_capital); ++t) {
+        resourceTerm(&variant, t->good)->capital_u = t->amount_u;
+      }
+      for (const InputTerm* t = begin_inputs(variant.inputs);
+           t != end_inputs(variant.inputs); ++t) {
+        resourceTerm(&variant, t->good)->consumed_u =
+            t->consumed_u + t->capital_u;
+      }
+      for (const Term* t = begin(variant.install_cost);
+           t != end(variant.install_cost); ++t) {
+        resourceTerm(&variant, t->good)->install_u = t->amount_u;
+      }
+      variants_.push_back(variant);
+    }
+    step_offsets_.push_back(variants_.size());
+  }
+  outputs_ = addTerms(proto.outputs(), goods);
+}
+
+CompiledProduction::Range
+CompiledProduction::addTerms(const market::proto::Container& con,
+                             GoodsIndex* goods) {
+  Range range;
+  range.begin = terms_.size();
+  for (const auto& good : con.quantities()) {
+    terms_.push_back({goods->Intern(good.first), good.second});
+  }
+  range.end = terms_.size();
+  return range;
+}
+
+CompiledProduction::ResourceTerm*
+CompiledProduction::resourceTerm(Variant* variant, int good) {
+  for (int i = variant->resources.begin; i < variant->resources.end; ++i) {
+    if (resource_terms_[i].good == good) {
+      return &resource_terms_[i];
+    }
+  }
+  resource_terms_.push_back({good, 0, 0, 0});
+  variant->resources.end = resource_terms_.size();
+  return &resource_terms_.back();
+}
+
+bool CompiledProduction::Complete(const proto::Progress& progress) const {
+  return chain_->Complete(progress);
+}
+
+util::Status
+CompiledProduction::checkProgress(const proto::Progress& progress) const {
+  if (chain_->get_name() != progress.name()) {
+    return util::InvalidArgumentError(
+        absl::Substitute("Production $0 cannot advance process $1",
+                         chain_->get_name(), progress.name()));
+  }
+  if (Complete(progress)) {
+    return util::AlreadyExistsError(
+        absl::Substitute("Process $0 is already complete", progress.name()));
+  }
+  return util::OkStatus();
+}
+
+void CompiledProduction::ExpectedOutput(const proto::Progress& progress,
+                                        micro::Measure* output) const {
+  const micro::Measure efficiency_u = chain_->EfficiencyU(progress);
+  for (const Term* t = begin(outputs_); t != end(outputs_); ++t) {
+    output[t->good] += micro::MultiplyU(t->amount_u, efficiency_u);
+  }
+}
+
+void CompiledProduction::RequiredConsumables(const proto::Progress& progress,
+                                             int var,
+                                             micro::Measure* required) const {
+  if (chain_->get_name() != progress.name() || Complete(progress)) {
+    return;
+  }
+  const Variant& input = variant(progress.step(), var);
+  const micro::Measure scaling_u = progress.scaling_u();
+  for (const InputTerm* t = begin_inputs(input.inputs);
+       t != end_inputs(input.inputs); ++t) {
+    required[t->good] += micro::MultiplyU(t->consumed_u + t->capital_u,
+                                          scaling_u);
+  }
+}
+
+util::Status CompiledProduction::StepPossible(
+    const micro::Measure* fixed_capital, const micro::Measure* inputs,
+    const micro::Measure* raw_materials, const proto::Progress& progress,
+    micro::Measure institutional_capital_u, int var) const {
+  auto status = checkProgress(progress);
+  if (!status.ok()) {
+    return status;
+  }
+
+  const Variant& input = variant(progress.step(), var);
+  const micro::Measure scaling_u = progress.scaling_u();
+  for (const Term* t = begin(input.fixed_capital);
+       t != end(input.fixed_capital); ++t) {
+    if (fixed_capital[t->good] < micro::MultiplyU(t->amount_u, scaling_u)) {
+      return util::ResourceExhaustedError(absl::Substitute(
+          "Insufficient fixed capital for $0 at scale $1", progress.name(),
+          micro::DisplayString(scaling_u, 2)));
+    }
+  }
+
+  const micro::Measure consumed_scale_u = micro::MultiplyU(
+      scaling_u, chain_->ExperienceEffectU(institutional_capital_u));
+  for (const Term* t = begin(input.raw_materials);
+       t != end(input.raw_materials); ++t) {
+    if (raw_materials[t->good] <
+        micro::MultiplyU(t->amount_u, consumed_scale_u)) {
+      return util::ResourceExhaustedError(absl::Substitute(
+          "Insufficient raw materials for $0", progress.name()));
+    }
+  }
+
+  for (const InputTerm* t = begin_inputs(input.inputs);
+       t != end_inputs(input.inputs); ++t) {
+    micro::Measure needed_u = micro::MultiplyU(t->consumed_u, consumed_scale_u) +
+                              micro::MultiplyU(t->capital_u, scaling_u);
+    if (inputs[t->good] < needed_u) {
+      return util::ResourceExhaustedError(absl::Substitute(
+          "Insufficient input materials for $0", progress.name()));
+    }
+  }
+  return util::OkStatus();
+}
+
+util::Status CompiledProduction::PerformStep(
+    const micro::Measure* fixed_capital,
+    micro::Measure institutional_capital_u, int var, micro::Measure* inputs,
+    micro::Measure* raw_materials, micro::Measure* output,
+    micro::Measure* used_capital, proto::Progress* progress) const {
+  auto status = StepPossible(fixed_capital, inputs, raw_materials, *progress,
+                             institutional_capital_u, var);
+  if (!status.ok()) {
+    return status;
+  }
+
+  const Variant& input = variant(progress->step(), var);
+  const micro::Measure scaling_u = progress->scaling_u();
+  const micro::Measure consumed_scale_u = micro::MultiplyU(
+      scaling_u, chain_->ExperienceEffectU(institutional_capital_u));
+  for (const Term* t = begin(input.raw_materials);
+       t != end(input.raw_materials); ++t) {
+    raw_materials[t->good] -= micro::MultiplyU(t->amount_u, consumed_scale_u);
+  }
+  for (const InputTerm* t = begin_inputs(input.inputs);
+       t != end_inputs(input.inputs); ++t) {
+    micro::Measure capital_u = micro::MultiplyU(t->capital_u, scaling_u);
+    inputs[t->good] -=
+        micro::MultiplyU(t->consumed_u, consumed_scale_u) + capital_u;
+    used_capital[t->good] += capital_u;
+  }
+
+  progress->set_step(1 + progress->step());
+  if (Complete(*progress)) {
+    ExpectedOutput(*progress, output);
+    return util::OkStatus();
+  }
+  return util::NotComplete();
+}
+
+}  // namespace industry
@@ -0,0 +1,178 @@
+// Flat, immutable representation of production chains for hot loops.
+#ifndef BASE_INDUSTRY_COMPILED_PRODUCTION_H
+#define BASE_INDUSTRY_COMPILED_PRODUCTION_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "games/industry/industry.h"
+#include "games/industry/proto/industry.pb.h"
+#include "games/market/proto/goods.pb.h"
+#include "util/arithmetic/microunits.h"
+#include "util/status/status.h"
+
+namespace industry {
+
+// Dense numbering of goods, shared between compiled chains so that they agree
+// on the layout of goods buffers.
+class GoodsIndex {
+public:
+  // Returns the index of the good, adding it if it is new.
+  int Intern(const std::string& name);
+
+  // Returns the index of the good, or -1 if it is not known.
+  int Find(const std::string& name) const;
+
+  // Returns the name of the good with the given index.
+  const std::string& Name(int idx) const { return names_[idx]; }
+
+  // Overwrites the first size() entries of dense with the amounts in con.
+  // Goods that are not in the index are ignored.
+  void ToDense(const market::proto::Container& con,
+               micro::Measure* dense) const;
+
+  // Sets the amounts in con from the first size() entries of dense. Zero
+  // entries are only written if the good is already present in con.
+  void FromDense(const micro::Measure* dense,
+                 market::proto::Container* con) const;
+
+  int size() const { return names_.size(); }
+
+private:
+  std::unordered_map<std::string, int> indices_;
+  std::vector<std::string> names_;
+};
+
+// A Production compiled into flat step and variant tables over a GoodsIndex.
+// The methods mirror those of Production, but read and write caller-provided
+// buffers indexed by good, each with at least goods.size() entries as of
+// compilation, and do not allocate.
+class CompiledProduction {
+public:
+  // One good in an input or output, per unit of scale.
+  struct Term {
+    int good;
+    micro::Measure amount_u;
+  };
+
+  // Consumables and movable capital of one good, which are checked together
+  // but scale differently with experience.
+  struct InputTerm {
+    int good;
+    micro::Measure consumed_u;
+    micro::Measure capital_u;
+  };
+
+  // Every good used by one variant for capital, consumption, or installation,
+  // as the scale calculation needs them.
+  struct ResourceTerm {
+    int good;
+    micro::Measure capital_u;
+    micro::Measure consumed_u;
+    micro::Measure install_u;
+  };
+
+  // Half-open range of indices into a term table.
+  struct Range {
+    int begin;
+    int end;
+  };
+
+  struct Variant {
+    Range inputs;
+    Range fixed_capital;
+    Range raw_materials;
+    Range install_cost;
+    Range resources;
+  };
+
+  // Compiles chain, which must outlive this object, interning its goods in
+  // goods.
+  CompiledProduction(const Production& chain, GoodsIndex* goods);
+
+  // Returns true if this progress has completed all steps.
+  bool Complete(const proto::Progress& progress) const;
+
+  // Adds the output for the scale and efficiency of progress to output.
+  void ExpectedOutput(const proto::Progress& progress,
+                      micro::Measure* output) const;
+
+  // Adds the consumables and movable capital needed for the next step of
+  // progress using variant to required. Adds nothing if progress is for a
+  // different chain or is complete.
+  void RequiredConsumables(const proto::Progress& progress, int variant,
+                           micro::Measure* required) const;
+
+  // Returns OK if fixed_capital, inputs, and raw_materials contain enough
+  // goods for the current step of progress using variant.
+  util::Status StepPossible(const micro::Measure* fixed_capital,
+                            const micro::Measure* inputs,
+                            const micro::Measure* raw_materials,
+                            const proto::Progress& progress,
+                            micro::Measure institutional_capital_u,
+                            int variant) const;
+
+  // Runs the current step of progress as Production::PerformStep does, taking
+  // goods from inputs and raw_materials and moving movable capital to
+  // used_capital. Adds the products to output if the process completes.
+  util::Status PerformStep(const micro::Measure* fixed_capital,
+                           micro::Measure institutional_capital_u, int variant,
+                           micro::Measure* inputs,
+                           micro::Measure* raw_materials,
+                           micro::Measure* output,
+                           micro::Measure* used_capital,
+                           proto::Progress* progress) const;
+
+  // Table access.
+  const Variant& variant(int step, int var) const {
+    return variants_[step_offsets_[step] + var];
+  }
+  int num_steps() const { return step_offsets_.size() - 1; }
+  int num_variants(int step) const {
+    return step_offsets_[step + 1] - step_offsets_[step];
+  }
+  const InputTerm* begin_inputs(const Range& range) const {
+    return input_terms_.data() + range.begin;
+  }
+  const InputTerm* end_inputs(const Range& range) const {
+    return input_terms_.data() + range.end;
+  }
+  const ResourceTerm* begin_resources(const Range& range) const {
+    return resource_terms_.data() + range.begin;
+  }
+  const ResourceTerm* end_resources(const Range& range) const {
+    return resource_terms_.data() + range.end;
+  }
+  const Term* begin(const Range& range) const {
+    return terms_.data() + range.begin;
+  }
+  const Term* end(const Range& range) const {
+    return terms_.data() + range.end;
+  }
+  const Range& outputs() const { return outputs_; }
+  const Production& chain() const { return *chain_; }
+
+private:
+  // Appends the goods in con to terms_ and returns their range.
+  Range addTerms(const market::proto::Container& con, GoodsIndex* goods);
+
+  // Returns the resource term for good within the variant's resources,
+  // appending one if needed.
+  ResourceTerm* resourceTerm(Variant* variant, int good);
+
+  // Returns an error if progress cannot be advanced by this chain.
+  util::Status checkProgress(const proto::Progress& progress) const;
+
+  const Production* chain_;
+  std::vector<int> step_offsets_;
+  std::vector<Variant> variants_;
+  std::vector<InputTerm> input_terms_;
+  std::vector<ResourceTerm> resource_terms_;
+  std::vector<Term> terms_;
+  Range outputs_;
+};
+
+}  // namespace industry
+
+#endif
@@ -0,0 +1,179 @@
+#include "games/industry/compiled_production.h"
+
+#include <vector>
+
+#include "games/industry/industry.h"
+#include "games/industry/proto/industry.pb.h"
+#include "games/market/goods_utils.h"
+#include "games/market/proto/goods.pb.h"
+#include "gmock/gmock.h"
+#include "util/arithmetic/microunits.h"
+#include "util/status/status.h"
+#include "gtest/gtest.h"
+
+namespace industry {
+namespace {
+constexpr char kWool[] = "wool";
+constexpr char kCloth[] = "cloth";
+constexpr char kDogs[] = "dogs";
+constexpr char kMules[] = "mules";
+constexpr char kFlax[] = "flax";
+
+using market::proto::Container;
+
+bool sameGoods(const Container& one, const Container& two) {
+  for (const auto& good : one.quantities()) {
+    if (market::GetAmount(two, good.first) != good.second) {
+      return false;
+    }
+  }
+  for (const auto& good : two.quantities()) {
+    if (market::GetAmount(one, good.first) != good.second) {
+      return false;
+    }
+  }
+  return true;
+}
+} // namespace
+
+class CompiledProductionTest : public testing::Test {
+protected:
+  void SetUp() override {
+    proto_.set_name("spinning");
+    auto* input = proto_.add_steps()->add_variants();
+    market::SetAmount(kWool, 1000, input->mutable_consumables());
+    market::SetAmount(kWool, 500, input->mutable_movable_capital());
+    market::SetAmount(kDogs, 1000, input->mutable_movable_capital());
+    market::SetAmount(kMules, 1000, input->mutable_fixed_capital());
+    market::SetAmount(kFlax, 2000, input->mutable_raw_materials());
+    input = proto_.add_steps()->add_variants();
+    market::SetAmount(kWool, 1000, input->mutable_consumables());
+    market::SetAmount(kCloth, 3000, proto_.mutable_outputs());
+  }
+
+  std::vector<micro::Measure> dense(const Container& con) {
+    std::vector<micro::Measure> ret(goods_.size());
+    goods_.ToDense(con, ret.data());
+    return ret;
+  }
+
+  Container sparse(const std::vector<micro::Measure>& dense) {
+    Container ret;
+    goods_.FromDense(dense.data(), &ret);
+    market::CleanContainer(&ret);
+    return ret;
+  }
+
+  proto::Production proto_;
+  GoodsIndex goods_;
+};
+
+TEST_F(CompiledProductionTest, Tables) {
+  Production production(proto_);
+  CompiledProduction compiled(production, &goods_);
+  EXPECT_EQ(5, goods_.size());
+  EXPECT_EQ(2, compiled.num_steps());
+  EXPECT_EQ(1, compiled.num_variants(0));
+  EXPECT_EQ(1, compiled.num_variants(1));
+
+  // Wool consumables and movable capital share a term.
+  const auto& variant = compiled.variant(0, 0);
+  ASSERT_EQ(2, variant.inputs.end - variant.inputs.begin);
+  const auto* wool = compiled.begin_inputs(variant.inputs);
+  EXPECT_EQ(kWool, goods_.Name(wool->good));
+  EXPECT_EQ(1000, wool->consumed_u);
+  EXPECT_EQ(500, wool->capital_u);
+  EXPECT_EQ(1, variant.fixed_capital.end - variant.fixed_capital.begin);
+  EXPECT_EQ(1, variant.raw_materials.end - variant.raw_materials.begin);
+  EXPECT_EQ(0, variant.install_cost.end - variant.install_cost.begin);
+  EXPECT_EQ(-1, goods_.Find("nothing"));
+}
+
+TEST_F(CompiledProductionTest, MatchesProduction) {
+  proto_.set_experience_effect_u(200000);
+  auto* scale = proto_.add_scaling();
+  scale->set_size_u(micro::kOneInU);
+  scale->set_effect_u(micro::kOneInU / 2);
+  Production production(proto_);
+  CompiledProduction compiled(production, &goods_);
+
+  Container fixcap;
+  market::SetAmount(kMules, 2000, &fixcap);
+  Container inputs;
+  market::SetAmount(kWool, 5000, &inputs);
+  market::SetAmount(kDogs, 2000, &inputs);
+  Container raw;
+  market::SetAmount(kFlax, 5000, &raw);
+
+  auto progress = production.MakeProgress(1500000);
+  auto compiled_progress = progress;
+  std::vector<micro::Measure> required(goods_.size());
+  compiled.RequiredConsumables(compiled_progress, 0, required.data());
+  EXPECT_TRUE(sameGoods(production.RequiredConsumables(progress, 0),
+                        sparse(required)));
+
+  auto dense_fixcap = dense(fixcap);
+  auto dense_inputs = dense(inputs);
+  auto dense_raw = dense(raw);
+  std::vector<micro::Measure> dense_output(goods_.size());
+  std::vector<micro::Measure> dense_used(goods_.size());
+  Container output;
+  Container used;
+  for (int step = 0; step < 2; ++step) {
+    auto status = production.PerformStep(fixcap, 1000000, 0, &inputs, &raw,
+                                         &output, &used, &progress);
+    auto compiled_status = compiled.PerformStep(
+        dense_fixcap.data(), 1000000, 0, dense_inputs.data(),
+        dense_raw.data(), dense_output.data(), dense_used.data(),
+        &compiled_progress);
+    EXPECT_EQ(status.ok(), compiled_status.ok());
+    EXPECT_EQ(util::IsNotComplete(status),
+              util::IsNotComplete(compiled_status));
+    EXPECT_EQ(progress.step(), compiled_progress.step());
+  }
+  EXPECT_TRUE(compiled.Complete(compiled_progress));
+  market::CleanContainer(&inputs);
+  market::CleanContainer(&raw);
+  EXPECT_TRUE(sameGoods(inputs, sparse(dense_inputs)));
+  EXPECT_TRUE(sameGoods(raw, sparse(dense_raw)));
+  EXPECT_TRUE(sameGoods(output, sparse(dense_output)));
+  EXPECT_TRUE(sameGoods(used, sparse(dense_used)));
+  EXPECT_EQ(3750, market::GetAmount(output, kCloth));
+}
+
+TEST_F(CompiledProductionTest, StepPossible) {
+  Production production(proto_);
+  CompiledProduction compiled(production, &goods_);
+  auto progress = production.MakeProgress(micro::kOneInU);
+  std::vector<micro::Measure> fixcap(goods_.size());
+  std::vector<micro::Measure> inputs(goods_.size());
+  std::vector<micro::Measure> raw(goods_.size());
+
+  auto status = compiled.StepPossible(fixcap.data(), inputs.data(), raw.data(),
+                                      progress, 0, 0);
+  EXPECT_THAT(status.ToString(), testing::HasSubstr("fixed capital"));
+  fixcap[goods_.Find(kMules)] = 1000;
+  status = compiled.StepPossible(fixcap.data(), inputs.data(), raw.data(),
+                                 progress, 0, 0);
+  EXPECT_THAT(status.ToString(), testing::HasSubstr("raw materials"));
+  raw[goods_.Find(kFlax)] = 2000;
+  status = compiled.StepPossible(fixcap.data(), inputs.data(), raw.data(),
+                                 progress, 0, 0);
+  EXPECT_THAT(status.ToString(), testing::HasSubstr("input materials"));
+  inputs[goods_.Find(kWool)] = 1499;
+  inputs[goods_.Find(kDogs)] = 1000;
+  status = compiled.StepPossible(fixcap.data(), inputs.data(), raw.data(),
+                                 progress, 0, 0);
+  EXPECT_THAT(status.ToString(), testing::HasSubstr("input materials"));
+  inputs[goods_.Find(kWool)] = 1500;
+  status = compiled.StepPossible(fixcap.data(), inputs.data(), raw.data(),
+                                 progress, 0, 0);
+  EXPECT_TRUE(status.ok()) << status.ToString();
+
+  progress.set_name("weaving");
+  status = compiled.StepPossible(fixcap.data(), inputs.data(), raw.data(),
+                                 progress, 0, 0);
+  EXPECT_THAT(status.ToString(), testing::HasSubstr("cannot advance"));
+}
+
+} // namespace industry
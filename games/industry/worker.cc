@@ -1,5 +1,7 @@
 #include "games/industry/worker.h"
 
+#include <algorithm>
+
 #include "absl/strings/substitute.h"
 #include "games/market/goods_utils.h"
 #include "util/arithmetic/microunits.h"
@@ -145,8 +147,258 @@ micro::Measure CalculatePossibleScale(micro::Measure available_A_u,
   return scale_u;
 }
 
+// Returns the index of the first smallest of the n values, or -1 if n is zero.
+int argMin(const micro::Measure* values, int n) {
+  int best = -1;
+  micro::Measure lowest = micro::kMaxU;
+  for (int i = 0; i < n; ++i) {
+    if (values[i] < lowest) {
+      lowest = values[i];
+      best = i;
+    }
+  }
+  return best;
+}
+
+// Returns the entry for good in row ahead of a table with n goods per row,
+// calling lookup to fill it in if its stamp is not the current one.
+template <typename F>
+micro::Measure lazyEntry(int ahead, int good, int n, uint64 stamp,
+                         std::vector<micro::Measure>* values,
+                         std::vector<uint64>* stamps, const F& lookup) {
+  const int idx = ahead * n + good;
+  if (values->size() <= idx) {
+    values->resize((ahead + 1) * n);
+    stamps->resize((ahead + 1) * n, 0);
+  }
+  if ((*stamps)[idx] != stamp) {
+    (*values)[idx] = lookup();
+    (*stamps)[idx] = stamp;
+  }
+  return (*values)[idx];
+}
+
 } // namespace
 
+BatchEvaluator::BatchEvaluator(
+    const std::unordered_map<std::string, const Production*>& chains)
+    : available_stamp_(0), price_stamp_(0) {
+  for (const auto& chain : chains) {
+    compiled_.emplace(chain.first, std::make_unique<CompiledProduction>(
+                                       *chain.second, &goods_));
+  }
+  wealth_.resize(goods_.size());
+  fixcap_.resize(goods_.size());
+  resources_.resize(goods_.size());
+  ratios_.resize(goods_.size());
+}
+
+const CompiledProduction*
+BatchEvaluator::find(const std::string& name) const {
+  auto it = compiled_.find(name);
+  if (it == compiled_.end()) {
+    return nullptr;
+  }
+  return it->second.get();
+}
+
+micro::Measure BatchEvaluator::available(int ahead, int good,
+                                         const market::Market& market) {
+  return lazyEntry(ahead, good, goods_.size(), available_stamp_, &available_,
+                   &available_stamps_, [&]() {
+                     return market.Available(goods_.Name(good), ahead) +
+                            wealth_[good];
+                   });
+}
+
+micro::Measure BatchEvaluator::price(int ahead, int good,
+                                     const market::PriceEstimator& prices) {
+  return lazyEntry(ahead, good, goods_.size(), price_stamp_, &prices_,
+                   &price_stamps_, [&]() {
+                     return prices.GetPriceU(goods_.Name(good), ahead);
+                   });
+}
+
+void BatchEvaluator::CalculateProductionScale(
+    const market::proto::Container& wealth,
+    decisions::ProductionContext* context, geography::proto::Field* field) {
+  goods_.ToDense(wealth, wealth_.data());
+  goods_.ToDense(field->fixed_capital(), fixcap_.data());
+  goods_.ToDense(field->resources(), resources_.data());
+  ++available_stamp_;
+  ++price_stamp_;
+  const micro::Measure* existing_Ce_u = fixcap_.data();
+
+  for (auto& cand : context->fields.at(field).candidates) {
+    const CompiledProduction* compiled = find(cand->name());
+    if (compiled == nullptr) {
+      continue;
+    }
+    auto overall_scale = compiled->chain().MaxScaleU();
+    int first_step = 0;
+    if (field->has_progress() && field->progress().name() == cand->name()) {
+      first_step = field->progress().step();
+    }
+    for (int step = first_step; step < compiled->num_steps(); ++step) {
+      const int ahead = step - first_step;
+      if (ahead >= cand->step_info_size()) {
+        // This should never happen.
+        break;
+      }
+
+      decisions::proto::StepInfo* step_info = cand->mutable_step_info(ahead);
+      micro::Measure step_scale = 0;
+      for (int var = 0; var < step_info->variant_size(); ++var) {
+        const auto& variant = compiled->variant(step, var);
+        const auto* res_begin = compiled->begin_resources(variant.resources);
+        const int num_res = variant.resources.end - variant.resources.begin;
+        decisions::proto::VariantInfo* var_info =
+            step_info->mutable_variant(var);
+        var_info->clear_bottleneck();
+
+        // The cost of installed capital is the cost of the smallest installed
+        // resource.
+        micro::Measure least_capital_scale_u = overall_scale;
+        for (int r = 0; r < num_res; ++r) {
+          const auto& res = res_begin[r];
+          if (res.capital_u == 0) {
+            continue;
+          }
+          uint64 overflow = 0;
+          micro::Measure installed_units_u = micro::DivideU(
+              existing_Ce_u[res.good], res.capital_u, &overflow);
+          if (overflow != 0) {
+            continue;
+          }
+          least_capital_scale_u =
+              std::min(least_capital_scale_u, installed_units_u);
+        }
+
+        for (int r = 0; r < num_res; ++r) {
+          const auto& res = res_begin[r];
+          ratios_[r] = CalculatePossibleScale(
+              available(ahead, res.good, *context->market), res.capital_u, res.consumed_u,
+              res.install_u, existing_Ce_u[res.good],
+              micro::MultiplyU(res.install_u, least_capital_scale_u));
+        }
+        micro::Measure variant_scale_u = overall_scale;
+        // Good limiting the scale, if any, and whether it is a raw material.
+        int bottleneck_good = -1;
+        bool raw_bottleneck = false;
+        int bottleneck = argMin(ratios_.data(), num_res);
+        if (bottleneck >= 0 && ratios_[bottleneck] < variant_scale_u) {
+          variant_scale_u = ratios_[bottleneck];
+          bottleneck_good = res_begin[bottleneck].good;
+        }
+
+        const auto* raw_begin = compiled->begin(variant.raw_materials);
+        const int num_raw =
+            variant.raw_materials.end - variant.raw_materials.begin;
+        for (int r = 0; r < num_raw; ++r) {
+          ratios_[r] = micro::DivideU(resources_[raw_begin[r].good],
+                                      raw_begin[r].amount_u);
+        }
+        bottleneck = argMin(ratios_.data(), num_raw);
+        if (bottleneck >= 0 && ratios_[bottleneck] < variant_scale_u) {
+          variant_scale_u = ratios_[bottleneck];
+          bottleneck_good = raw_begin[bottleneck].good;
+          raw_bottleneck = true;
+        }
+        // As in the single-chain function, only the final bottleneck is
+        // named.
+        if (raw_bottleneck) {
+          var_info->set_bottleneck(
+              absl::Substitute("Resource $0", goods_.Name(bottleneck_good)));
+        } else if (bottleneck_good >= 0) {
+          var_info->set_bottleneck(goods_.Name(bottleneck_good));
+        }
+        var_info->set_possible_scale_u(variant_scale_u);
+
+        // Capital cost at this scale; see CalculateCapCostU.
+        micro::Measure least_install_scale_u = variant_scale_u;
+        for (int r = 0; r < num_res; ++r) {
+          const auto& res = res_begin[r];
+          micro::Measure to_install_u =
+              micro::MultiplyU(res.capital_u, variant_scale_u) -
+              existing_Ce_u[res.good];
+          if (to_install_u <= 0) {
+            continue;
+          }
+          least_install_scale_u =
+              std::min(least_install_scale_u,
+                       AvailableUnits(existing_Ce_u[res.good], res.capital_u));
+        }
+        micro::Measure cap_cost_u = 0;
+        for (int r = 0; r < num_res; ++r) {
+          const auto& res = res_begin[r];
+          micro::Measure amount_u =
+              std::max<micro::Measure>(
+                  0, micro::MultiplyU(res.capital_u, variant_scale_u) -
+                         existing_Ce_u[res.good]) +
+              micro::MultiplyU(res.install_u,
+                               variant_scale_u - least_install_scale_u);
+          if (amount_u == 0) {
+            continue;
+          }
+          micro::Measure price_u = micro::MultiplyU(
+              price(ahead, res.good, *context->market), amount_u);
+          if (price_u >= 0) {
+            cap_cost_u += price_u;
+          }
+        }
+        var_info->set_cap_cost_u(cap_cost_u);
+
+        step_scale = std::max(step_scale, variant_scale_u);
+      }
+      overall_scale = std::min(overall_scale, step_scale);
+    }
+
+    cand->set_max_scale_u(overall_scale);
+  }
+}
+
+void BatchEvaluator::CalculateProductionCosts(
+    const market::PriceEstimator& prices, const geography::proto::Field& field,
+    std::vector<std::unique_ptr<decisions::proto::ProductionInfo>>*
+        candidates) {
+  ++price_stamp_;
+  for (auto& cand : *candidates) {
+    const CompiledProduction* compiled = find(cand->name());
+    if (compiled == nullptr) {
+      continue;
+    }
+    const Production& chain = compiled->chain();
+    proto::Progress progress;
+    if (field.has_progress()) {
+      progress = field.progress();
+    } else {
+      progress = chain.MakeProgress(chain.MaxScaleU());
+    }
+
+    *cand->mutable_expected_output() = chain.ExpectedOutput(progress);
+    for (int step = progress.step(); step < compiled->num_steps(); ++step) {
+      const int ahead = step - progress.step();
+      auto* step_info = cand->add_step_info();
+      for (int var = 0; var < compiled->num_variants(step); ++var) {
+        const auto& inputs = compiled->variant(step, var).inputs;
+        micro::Measure unit_cost_u = 0;
+        for (const auto* t = compiled->begin_inputs(inputs);
+             t != compiled->end_inputs(inputs); ++t) {
+          if (t->consumed_u == 0) {
+            continue;
+          }
+          micro::Measure price_u = micro::MultiplyU(
+              price(ahead, t->good, prices), t->consumed_u);
+          if (price_u >= 0) {
+            unit_cost_u += price_u;
+          }
+        }
+        step_info->add_variant()->set_unit_cost_u(unit_cost_u);
+      }
+    }
+  }
+}
+
 void CalculateProductionScale(const market::proto::Container& wealth,
                               decisions::ProductionContext* context,
                               geography::proto::Field* field) {
@@ -175,6 +427,8 @@ void CalculateProductionScale(const market::proto::Container& wealth,
         const proto::Input& input = prod_step.variants(var);
         decisions::proto::VariantInfo* var_info =
             step_info->mutable_variant(var);
+        // Candidates may be reused between turns; forget the old bottleneck.
+        var_info->clear_bottleneck();
         auto variant_scale_u = overall_scale;
         market::proto::Container fixcap = input.fixed_capital();
         // Movable capital can be treated as "consumed" for purposes of the
@@ -209,6 +463,7 @@ void CalculateProductionScale(const market::proto::Container& wealth,
         market::proto::Container existing_Ie_u = install;
         market::MultiplyU(existing_Ie_u, least_capital_scale_u);
 
+        const std::string* bottleneck = nullptr;
         for (const auto& good : total.quantities()) {
           micro::Measure available_u =
               context->market->Available(good.first, ahead) +
@@ -221,18 +476,26 @@ void CalculateProductionScale(const market::proto::Container& wealth,
               market::GetAmount(existing_Ie_u, good.first));
           if (ratio_u < variant_scale_u) {
             variant_scale_u = ratio_u;
-            var_info->set_bottleneck(good.first);
+            bottleneck = &good.first;
           }
         }
+        bool raw_bottleneck = false;
         for (const auto& good : input.raw_materials().quantities()) {
           micro::Measure ratio_u = micro::DivideU(
               market::GetAmount(field->resources(), good.first), good.second);
           if (ratio_u < variant_scale_u) {
             variant_scale_u = ratio_u;
-            var_info->set_bottleneck(
-                absl::Substitute("Resource $0", good.first));
+            bottleneck = &good.first;
+            raw_bottleneck = true;
           }
         }
+        // Only the final bottleneck is named, so that the name is built at
+        // most once per variant.
+        if (raw_bottleneck) {
+          var_info->set_bottleneck(absl::Substitute("Resource $0", *bottleneck));
+        } else if (bottleneck != nullptr) {
+          var_info->set_bottleneck(*bottleneck);
+        }
 
         var_info->set_possible_scale_u(variant_scale_u);
         var_info->set_cap_cost_u(CalculateCapCostU(
@@ -2,11 +2,18 @@
 #ifndef BASE_INDUSTRY_WORKER_H
 #define BASE_INDUSTRY_WORKER_H
 
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 #include "games/geography/proto/geography.pb.h"
+#include "games/industry/compiled_production.h"
 #include "games/industry/decisions/production_evaluator.h"
 #include "games/industry/industry.h"
 #include "games/market/market.h"
 #include "games/market/proto/goods.pb.h"
+#include "util/headers/int_types.h"
 #include "util/status/status.h"
 
 namespace industry {
@@ -31,6 +38,61 @@ void CalculateProductionCosts(
     const geography::proto::Field& field,
     industry::decisions::proto::ProductionInfo* production_info);
 
+// Batch form of CalculateProductionScale and CalculateProductionCosts. The
+// chains are compiled once, and each call evaluates every variant of every
+// candidate of a field in one pass over packed per-good arrays, reusing its
+// buffers between calls. Scales, capital costs and unit costs are the same as
+// the single-chain functions give; prices are summed good by good, as Market
+// does.
+class BatchEvaluator {
+public:
+  // Compiles the chains, which must outlive the evaluator.
+  explicit BatchEvaluator(
+      const std::unordered_map<std::string, const Production*>& chains);
+
+  // As the free function; candidates not compiled here are skipped.
+  void CalculateProductionScale(const market::proto::Container& wealth,
+                                decisions::ProductionContext* context,
+                                geography::proto::Field* field);
+
+  // Fills in the step and variant costs of each candidate, which must have
+  // its name set and no step information.
+  void CalculateProductionCosts(
+      const market::PriceEstimator& prices,
+      const geography::proto::Field& field,
+      std::vector<std::unique_ptr<decisions::proto::ProductionInfo>>*
+          candidates);
+
+private:
+  // Returns the compiled chain with the given name, or null.
+  const CompiledProduction* find(const std::string& name) const;
+
+  // Return the value for good the given number of turns ahead, asking the
+  // market on its first use since the last reset. Goods that no candidate
+  // uses are never looked up.
+  micro::Measure available(int ahead, int good, const market::Market& market);
+  micro::Measure price(int ahead, int good,
+                       const market::PriceEstimator& prices);
+
+  GoodsIndex goods_;
+  std::unordered_map<std::string, std::unique_ptr<CompiledProduction>>
+      compiled_;
+
+  // Per-call buffers, indexed by good.
+  std::vector<micro::Measure> wealth_;
+  std::vector<micro::Measure> fixcap_;
+  std::vector<micro::Measure> resources_;
+  std::vector<micro::Measure> ratios_;
+  // Rows of goods, one per turn ahead. An entry is current if its stamp
+  // equals the table's; bumping that resets the whole table.
+  std::vector<micro::Measure> available_;
+  std::vector<uint64> available_stamps_;
+  std::vector<micro::Measure> prices_;
+  std::vector<uint64> price_stamps_;
+  uint64 available_stamp_;
+  uint64 price_stamp_;
+};
+
 // Uses evaluator to select a production chain for the field.
 // DEPRECATED. Use the evaluator's SelectCandidate method directly instead.
 void SelectProduction(const decisions::ProductionEvaluator& evaluator,
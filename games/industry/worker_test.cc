@@ -2,6 +2,9 @@
 #include "games/industry/worker.h"
 
 #include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "games/geography/proto/geography.pb.h"
 #include "games/industry/industry.h"
@@ -258,6 +261,136 @@ TEST_F(WorkerTest, DistinctInputs) {
             labour_info->step_info(0).variant(0).cap_cost_u());
 }
 
+// Check that the batch evaluator agrees with the single-chain functions.
+TEST_F(WorkerTest, BatchEvaluator) {
+  proto::Production prod_proto;
+  prod_proto.set_name(kLabourToGrain);
+  auto* input = prod_proto.add_steps()->add_variants();
+  market::SetAmount(grain_.kind(), micro::kOneInU,
+                    input->mutable_consumables());
+  market::SetAmount(capital_.kind(), micro::kOneInU,
+                    input->mutable_fixed_capital());
+  market::SetAmount(labour_.kind(), micro::kOneInU,
+                    input->mutable_install_cost());
+  input = prod_proto.mutable_steps(0)->add_variants();
+  market::SetAmount(labour_.kind(), micro::kOneInU,
+                    input->mutable_consumables());
+  market::SetAmount(labour_.kind(), micro::kHalfInU,
+                    input->mutable_fixed_capital());
+  input = prod_proto.add_steps()->add_variants();
+  market::SetAmount(grain_.kind(), micro::kOneFourthInU,
+                    input->mutable_consumables());
+  market::SetAmount(grain_.kind(), micro::kOneInU,
+                    input->mutable_raw_materials());
+  market::SetAmount(grain_.kind(), micro::kOneInU, prod_proto.mutable_outputs());
+
+  const Production labour(prod_proto);
+  const Production capital = CapitalToGrain();
+  std::unordered_map<std::string, const Production*> prod_map = {
+      {kLabourToGrain, &labour}, {kCapitalToGrain, &capital}};
+  BatchEvaluator batch(prod_map);
+
+  decisions::ProductionContext single = {&prod_map, {}, &market_};
+  decisions::ProductionContext batched = {&prod_map, {}, &market_};
+  auto& single_cands = single.fields[&field_].candidates;
+  auto& batch_cands = batched.fields[&field_].candidates;
+  for (const auto& chain : {&labour, &capital}) {
+    single_cands.emplace_back(
+        std::make_unique<decisions::proto::ProductionInfo>());
+    single_cands.back()->set_name(chain->get_name());
+    CalculateProductionCosts(*chain, market_, field_,
+                             single_cands.back().get());
+    batch_cands.emplace_back(
+        std::make_unique<decisions::proto::ProductionInfo>());
+    batch_cands.back()->set_name(chain->get_name());
+  }
+  batch.CalculateProductionCosts(market_, field_, &batch_cands);
+
+  market::SetAmount(grain_.kind(), micro::kHalfInU,
+                    field_.mutable_resources());
+  market::SetAmount(capital_.kind(), micro::kOneFourthInU,
+                    field_.mutable_fixed_capital());
+  std::vector<market::proto::Container> wealths(3);
+  market::SetAmount(labour_.kind(), micro::kHalfInU, &wealths[1]);
+  market::SetAmount(grain_.kind(), micro::kHundredInU, &wealths[1]);
+  market::SetAmount(capital_.kind(), micro::kHundredInU, &wealths[1]);
+  market::SetAmount(labour_.kind(), micro::kHundredInU, &wealths[2]);
+  market::SetAmount(grain_.kind(), micro::kOneFourthInU, &wealths[2]);
+  market::SetAmount(capital_.kind(), micro::kThreeFourthsInU, &wealths[2]);
+  for (const auto& wealth : wealths) {
+    CalculateProductionScale(wealth, &single, &field_);
+    batch.CalculateProductionScale(wealth, &batched, &field_);
+    for (int c = 0; c < single_cands.size(); ++c) {
+      const auto& one = *single_cands[c];
+      const auto& two = *batch_cands[c];
+      EXPECT_EQ(one.max_scale_u(), two.max_scale_u()) << one.name();
+      ASSERT_EQ(one.step_info_size(), two.step_info_size());
+      for (int step = 0; step < one.step_info_size(); ++step) {
+        ASSERT_EQ(one.step_info(step).variant_size(),
+                  two.step_info(step).variant_size());
+        for (int var = 0; var < one.step_info(step).variant_size(); ++var) {
+          const auto& v1 = one.step_info(step).variant(var);
+          const auto& v2 = two.step_info(step).variant(var);
+          EXPECT_EQ(v1.unit_cost_u(), v2.unit_cost_u());
+          EXPECT_EQ(v1.possible_scale_u(), v2.possible_scale_u());
+          EXPECT_EQ(v1.cap_cost_u(), v2.cap_cost_u());
+        }
+      }
+    }
+  }
+  EXPECT_EQ("Resource grain",
+            batch_cands[0]->step_info(1).variant(0).bottleneck());
+}
+
+// Price estimator that counts the goods it is asked about.
+class CountingPrices : public market::PriceEstimator {
+public:
+  explicit CountingPrices(const market::PriceEstimator& prices)
+      : prices_(prices) {}
+
+  micro::Measure GetPriceU(const std::string& name, int turns) const override {
+    ++lookups_[name];
+    return prices_.GetPriceU(name, turns);
+  }
+  micro::Measure GetPriceU(const market::proto::Quantity& quantity,
+                           int turns) const override {
+    return prices_.GetPriceU(quantity, turns);
+  }
+  micro::Measure GetPriceU(const market::proto::Container& basket,
+                           int turns) const override {
+    return prices_.GetPriceU(basket, turns);
+  }
+
+  mutable std::unordered_map<std::string, int> lookups_;
+
+private:
+  const market::PriceEstimator& prices_;
+};
+
+// Check that the batch evaluator only prices the goods its candidates use.
+TEST_F(WorkerTest, BatchEvaluatorLooksUpUsedGoods) {
+  const Production labour = LabourToGrain();
+  const Production capital = CapitalToGrain();
+  std::unordered_map<std::string, const Production*> prod_map = {
+      {kLabourToGrain, &labour}, {kCapitalToGrain, &capital}};
+  BatchEvaluator batch(prod_map);
+
+  std::vector<std::unique_ptr<decisions::proto::ProductionInfo>> cands;
+  cands.emplace_back(std::make_unique<decisions::proto::ProductionInfo>());
+  cands.back()->set_name(kLabourToGrain);
+  CountingPrices prices(market_);
+  batch.CalculateProductionCosts(prices, field_, &cands);
+  ASSERT_EQ(1, prices.lookups_.size());
+  EXPECT_EQ(1, prices.lookups_[labour_.kind()]);
+  EXPECT_EQ(market_.GetPriceU(labour.get_step(0).variants(0).consumables()),
+            cands[0]->step_info(0).variant(0).unit_cost_u());
+
+  // Each call looks prices up afresh.
+  cands[0]->clear_step_info();
+  batch.CalculateProductionCosts(prices, field_, &cands);
+  EXPECT_EQ(2, prices.lookups_[labour_.kind()]);
+}
+
 // Sanity-check unit-cost calculation.
 TEST_F(WorkerTest, CalculateProductionCosts) {
   const Production labour = LabourToGrain();
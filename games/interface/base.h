@@ -1,9 +1,14 @@
 #ifndef GAMES_INTERFACE_INTERFACE_H
 #define GAMES_INTERFACE_INTERFACE_H
 
+#include <memory>
+#include <vector>
+
 #include "games/interface/proto/config.pb.h"
 #include "SDL_keyboard.h"
+#include "src/google/protobuf/descriptor.h"
 #include "src/google/protobuf/message.h"
+#include "util/headers/int_types.h"
 #include "util/status/status.h"
 #include "util/proto/object_id.pb.h"
 
@@ -48,15 +53,39 @@ class Receiver {
   virtual void SelectObject(const util::proto::ObjectId& object_id) = 0;
 };
 
+// Read-only view of the state of one object. The state it points to stays
+// alive, and does not change, for as long as the view is held.
+typedef std::shared_ptr<const google::protobuf::Message> StateView;
+
 // StateFetcher is an abstract class for getting game-state information in
-// protobuf format.
+// protobuf format. The state is versioned by generation, which goes up
+// whenever any object changes.
 class StateFetcher {
 public:
   StateFetcher() = default;
   ~StateFetcher() = default;
 
+  // Copies the state of object_id into proto.
   virtual void Fetch(const util::proto::ObjectId& object_id,
                      google::protobuf::Message* proto) = 0;
+
+  // Returns the current generation.
+  virtual uint64 Generation() const = 0;
+
+  // Stores in views one entry for each of object_ids: a view of the state of
+  // that object as a message of type, or null if there is none. All views
+  // are from the same generation, which is returned. Nothing is copied.
+  virtual uint64
+  FetchBatch(const std::vector<util::proto::ObjectId>& object_ids,
+             const google::protobuf::Descriptor* type,
+             std::vector<StateView>* views) = 0;
+
+  // Adds to object_ids the objects that appeared or changed after
+  // generation, and returns the generation that is relative to. Objects
+  // that went away are not listed; FetchBatch returns null for them.
+  virtual uint64
+  ChangedSince(uint64 generation,
+               std::vector<util::proto::ObjectId>* object_ids) = 0;
 };
 
 // Base is an abstract class exposing a minimal set of interactions.
@@ -69,7 +98,11 @@ public:
   virtual util::Status
   Initialise(const games::interface::proto::Config& config) = 0;
   virtual void Cleanup() = 0;
-  virtual void DisplayUnits(const std::vector<util::proto::ObjectId>& ids) = 0;
+  // Shows the units in ids. Their states are looked up in frame, which
+  // serves the same generation as ids for the whole call; unlike the
+  // fetcher, it cannot move on to a newer one halfway through.
+  virtual void DisplayUnits(const std::vector<util::proto::ObjectId>& ids,
+                            StateFetcher* frame) = 0;
   virtual void EventLoop() = 0;
   void GetState(const util::proto::ObjectId& object_id,
                 google::protobuf::Message* proto);
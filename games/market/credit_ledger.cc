@@ -0,0 +1,73 @@
+#include "games/market/credit_ledger.h"
+
+#include <algorithm>
+
+#include "games/market/goods_utils.h"
+
+namespace market {
+
+int CreditLedger::index(market::proto::Container* participant) {
+  auto it = indices_.find(participant);
+  if (it != indices_.end()) {
+    return it->second;
+  }
+  const int idx = participants_.size();
+  participants_.push_back(participant);
+  net_.push_back(0);
+  indices_[participant] = idx;
+  return idx;
+}
+
+void CreditLedger::Record(market::proto::Container* debtor,
+                          market::proto::Container* creditor,
+                          micro::Measure amount) {
+  if (amount <= 0) {
+    return;
+  }
+  Entry entry;
+  entry.debtor = index(debtor);
+  entry.creditor = index(creditor);
+  entry.amount = amount;
+  net_[entry.debtor] -= amount;
+  net_[entry.creditor] += amount;
+  entries_.push_back(entry);
+}
+
+bool CreditLedger::Contains(
+    const market::proto::Container& participant) const {
+  return indices_.find(&participant) != indices_.end();
+}
+
+micro::Measure
+CreditLedger::Pending(const market::proto::Container& participant) const {
+  auto it = indices_.find(&participant);
+  if (it == indices_.end()) {
+    return 0;
+  }
+  return net_[it->second];
+}
+
+micro::Measure CreditLedger::Exposure() const {
+  micro::Measure total = 0;
+  for (const auto& entry : entries_) {
+    total += entry.amount;
+  }
+  return total;
+}
+
+void CreditLedger::Settle(const std::string& credit_token,
+                          const std::string& debt_token) {
+  for (int i = 0; i < participants_.size(); ++i) {
+    market::proto::Container* participant = participants_[i];
+    const micro::Measure net = GetAmount(*participant, credit_token) -
+                               GetAmount(*participant, debt_token) + net_[i];
+    SetAmount(credit_token, std::max<micro::Measure>(net, 0), participant);
+    SetAmount(debt_token, std::max<micro::Measure>(-net, 0), participant);
+  }
+  entries_.clear();
+  participants_.clear();
+  net_.clear();
+  indices_.clear();
+}
+
+} // namespace market
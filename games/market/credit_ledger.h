@@ -0,0 +1,63 @@
+// Record of short-term credit obligations between market participants.
+
+#ifndef GAMES_MARKET_CREDIT_LEDGER_H
+#define GAMES_MARKET_CREDIT_LEDGER_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "games/market/proto/goods.pb.h"
+#include "util/arithmetic/microunits.h"
+
+namespace market {
+
+// Collects (debtor, creditor, amount) entries during a turn and keeps a
+// running net position for each participant, so that credit can be checked
+// without touching the participants' Containers. Settle writes the net
+// positions back as credit and debt tokens in one pass.
+class CreditLedger {
+public:
+  struct Entry {
+    // Indices into the participant list.
+    int debtor;
+    int creditor;
+    micro::Measure amount;
+  };
+
+  // Records that debtor owes creditor amount. Nonpositive amounts are
+  // ignored.
+  void Record(market::proto::Container* debtor,
+              market::proto::Container* creditor, micro::Measure amount);
+
+  // Returns true if participant has entries not yet settled.
+  bool Contains(const market::proto::Container& participant) const;
+
+  // Returns the net unsettled position of participant; positive if it is
+  // owed money.
+  micro::Measure Pending(const market::proto::Container& participant) const;
+
+  // Returns the sum of all unsettled entries.
+  micro::Measure Exposure() const;
+
+  // Adds each participant's net position to its credit and debt tokens,
+  // leaving at most one of them nonzero, and clears the ledger.
+  void Settle(const std::string& credit_token, const std::string& debt_token);
+
+  const std::vector<Entry>& entries() const { return entries_; }
+  const std::vector<market::proto::Container*>& participants() const {
+    return participants_;
+  }
+
+private:
+  int index(market::proto::Container* participant);
+
+  std::vector<Entry> entries_;
+  std::vector<market::proto::Container*> participants_;
+  std::vector<micro::Measure> net_;
+  std::unordered_map<const market::proto::Container*, int> indices_;
+};
+
+} // namespace market
+
+#endif
@@ -0,0 +1,52 @@
+#include "games/market/credit_ledger.h"
+
+#include "games/market/goods_utils.h"
+#include "games/market/proto/goods.pb.h"
+#include "gtest/gtest.h"
+
+namespace market {
+
+namespace {
+using proto::Container;
+
+constexpr char kCredit[] = "market_short_term_credit";
+constexpr char kDebt[] = "market_short_term_debt";
+
+} // namespace
+
+TEST(CreditLedgerTest, Netting) {
+  CreditLedger ledger;
+  Container alice;
+  Container bob;
+  Container carol;
+
+  // A cycle nets to nothing except the difference.
+  ledger.Record(&alice, &bob, 10);
+  ledger.Record(&bob, &carol, 10);
+  ledger.Record(&carol, &alice, 7);
+  ledger.Record(&alice, &bob, 0);
+  EXPECT_EQ(3, ledger.entries().size());
+  EXPECT_EQ(3, ledger.participants().size());
+  EXPECT_EQ(27, ledger.Exposure());
+  EXPECT_EQ(-3, ledger.Pending(alice));
+  EXPECT_EQ(0, ledger.Pending(bob));
+  EXPECT_EQ(3, ledger.Pending(carol));
+  EXPECT_TRUE(ledger.Contains(bob));
+
+  SetAmount(kCredit, 5, &alice);
+  SetAmount(kDebt, 4, &carol);
+  ledger.Settle(kCredit, kDebt);
+  EXPECT_EQ(2, GetAmount(alice, kCredit));
+  EXPECT_EQ(0, GetAmount(alice, kDebt));
+  EXPECT_EQ(0, GetAmount(bob, kCredit));
+  EXPECT_EQ(0, GetAmount(bob, kDebt));
+  EXPECT_EQ(0, GetAmount(carol, kCredit));
+  EXPECT_EQ(1, GetAmount(carol, kDebt));
+
+  EXPECT_TRUE(ledger.entries().empty());
+  EXPECT_FALSE(ledger.Contains(bob));
+  EXPECT_EQ(0, ledger.Pending(alice));
+  EXPECT_EQ(0, ledger.Exposure());
+}
+
+} // namespace market
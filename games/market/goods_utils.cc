@@ -8,28 +8,40 @@
 #include "absl/strings/str_join.h"
 #include "games/market/proto/goods.pb.h"
 #include "util/arithmetic/microunits.h"
-
-std::unordered_map<std::string, market::proto::TradeGood> goods_map_;
-std::vector<std::string> goods_names_;
+#include "util/context/context.h"
 
 namespace market {
+namespace {
+
+struct GoodsRegistry {
+  std::unordered_map<std::string, market::proto::TradeGood> goods;
+  std::vector<std::string> names;
+};
+
+// Returns the goods of the current simulation context.
+GoodsRegistry& registry() {
+  return util::Context::Current().Get<GoodsRegistry>();
+}
+
+}  // namespace
 
 using market::proto::Quantity;
 using market::proto::Container;
 
-void ClearGoods() { goods_map_.clear(); }
+void ClearGoods() { registry().goods.clear(); }
 
 void CreateTradeGood(const market::proto::TradeGood& good) {
   // TODO: Handle these errors.
   if (good.name() == "") {
     return;
   }
-  if (goods_map_.find(good.name()) != goods_map_.end()) {
+  auto& goods = registry();
+  if (goods.goods.find(good.name()) != goods.goods.end()) {
     return;
   }
 
-  goods_map_[good.name()] = good;
-  market::proto::TradeGood& copy = goods_map_[good.name()];
+  goods.goods[good.name()] = good;
+  market::proto::TradeGood& copy = goods.goods[good.name()];
   if (copy.transport_type() != market::proto::TradeGood::TTT_IMMOBILE) {
     if (copy.bulk_u() < 1) {
       copy.set_bulk_u(1);
@@ -39,13 +51,14 @@ void CreateTradeGood(const market::proto::TradeGood& good) {
     }
   }
 
-  goods_names_.push_back(good.name());
+  goods.names.push_back(good.name());
 }
 
-const std::vector<std::string>& ListGoods() { return goods_names_; }
+const std::vector<std::string>& ListGoods() { return registry().names; }
 
 bool Exists(const std::string& name) {
-  return goods_map_.find(name) != goods_map_.end();
+  const auto& goods = registry().goods;
+  return goods.find(name) != goods.end();
 }
 bool Exists(const market::proto::TradeGood& good) {
   return Exists(good.name());
@@ -60,19 +73,19 @@ bool AllGoodsExist(const market::proto::Container& con) {
 }
 
 micro::Measure BulkU(const std::string& name) {
-  return goods_map_[name].bulk_u();
+  return registry().goods[name].bulk_u();
 }
 
 micro::Measure DecayU(const std::string& name) {
-  return goods_map_[name].decay_rate_u();
+  return registry().goods[name].decay_rate_u();
 }
 
 micro::Measure WeightU(const std::string& name) {
-  return goods_map_[name].weight_u();
+  return registry().goods[name].weight_u();
 }
 
 proto::TradeGood::TransportType TransportType(const std::string& name) {
-  return goods_map_[name].transport_type();
+  return registry().goods[name].transport_type();
 }
 
 void Add(const std::string& name, const micro::Measure amount, Container* con) {
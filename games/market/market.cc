@@ -63,7 +63,10 @@ void Market::DecayGoods(const market::proto::Container& decay_rates_u) {
   MultiplyU(*proto_.mutable_warehouse(), decay_rates_u);
 }
 
+void Market::SettleCredit() { ledger_.Settle(credit_token(), debt_token()); }
+
 void Market::FindPrices() {
+  SettleCredit();
   for (const auto& good : proto_.prices_u().quantities()) {
     const std::string& name = good.first;
     micro::Measure matched = GetAmount(proto_.volume(), name);
@@ -94,13 +97,33 @@ void Market::FindPrices() {
   Clear(&flow_tracker_);
 }
 
+micro::Measure Market::creditOf(const Container& participant) const {
+  if (!ledger_.Contains(participant)) {
+    return GetAmount(participant, credit_token());
+  }
+  return std::max<micro::Measure>(
+      0, GetAmount(participant, credit_token()) -
+             GetAmount(participant, debt_token()) +
+             ledger_.Pending(participant));
+}
+
+micro::Measure Market::debtOf(const Container& participant) const {
+  if (!ledger_.Contains(participant)) {
+    return GetAmount(participant, debt_token());
+  }
+  return std::max<micro::Measure>(
+      0, GetAmount(participant, debt_token()) -
+             GetAmount(participant, credit_token()) -
+             ledger_.Pending(participant));
+}
+
 micro::Measure Market::MaxCredit(const Container& borrower) const {
-  return proto_.credit_limit() - GetAmount(borrower, debt_token());
+  return proto_.credit_limit() - debtOf(borrower);
 }
 
 micro::Measure Market::MaxMoney(const Container& buyer) const {
-  return GetAmount(buyer, credit_token()) +
-         GetAmount(buyer, proto_.legal_tender()) + MaxCredit(buyer);
+  return creditOf(buyer) + GetAmount(buyer, proto_.legal_tender()) +
+         MaxCredit(buyer);
 }
 
 void CancelDebt(const std::string& credit_token, const std::string& debt_token,
@@ -158,6 +181,19 @@ void Market::TransferMoney(micro::Measure amount, Container* from,
   Add(credit_token(), amount, to);
 }
 
+void Market::deferMoney(micro::Measure amount, Container* from,
+                        Container* to) {
+  micro::Measure credit = std::min(amount, creditOf(*from));
+  ledger_.Record(from, to, credit);
+  amount -= credit;
+
+  credit = std::min(amount, GetAmount(*from, proto_.legal_tender()));
+  Move(proto_.legal_tender(), credit, from, to);
+  amount -= credit;
+
+  ledger_.Record(from, to, std::min(MaxCredit(*from), amount));
+}
+
 micro::Measure Market::TryToBuy(const Quantity& bid, Container* recipient) {
   return TryToBuy(bid.kind(), bid.amount(), recipient);
 }
@@ -236,8 +272,13 @@ micro::Measure Market::TryToSell(const Quantity& offer, Container* source) {
 
       Move(transfer, source, buyer.target);
       buyer.amount -= transfer.amount();
-      TransferMoney(micro::MultiplyU(transfer.amount(), unit_price_u),
-                    buyer.target, source);
+      const micro::Measure price_u =
+          micro::MultiplyU(transfer.amount(), unit_price_u);
+      if (defer_credit_) {
+        deferMoney(price_u, buyer.target, source);
+      } else {
+        TransferMoney(price_u, buyer.target, source);
+      }
       amount_sold += transfer.amount();
       *proto_.mutable_volume() += transfer;
     }
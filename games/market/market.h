@@ -7,6 +7,7 @@
 #include <string>
 #include <vector>
 
+#include "games/market/credit_ledger.h"
 #include "games/market/proto/goods.pb.h"
 #include "games/market/proto/market.pb.h"
 #include "util/arithmetic/microunits.h"
@@ -52,8 +53,9 @@ public:
 // price, and AvailabilityEstimator, returning the current availability.
 class Market : public PriceEstimator, public AvailabilityEstimator {
 public:
-  Market() = default;
-  Market(const proto::MarketProto& proto) : proto_(proto) {}
+  Market() : defer_credit_(false) {}
+  Market(const proto::MarketProto& proto)
+      : defer_credit_(false), proto_(proto) {}
   ~Market() = default;
 
   micro::Measure Available(const std::string& name,
@@ -73,9 +75,18 @@ public:
   // Make goods stored in warehouse decay at the given rates.
   void DecayGoods(const market::proto::Container& rates);
 
-  // Balances current bids and offers to find new prices. Surplus offers cause
-  // the price to go down, unmatched bids cause it to go up. Also clears
-  // existing buy and sell offers since the prices change.
+  // If defer is true, credit between traders is recorded in the ledger
+  // instead of being moved at once, and the owner of the market must call
+  // SettleCredit at a fixed point each round. Off by default.
+  void DeferCredit(bool defer) { defer_credit_ = defer; }
+
+  // Writes the credit ledger back to the traders as credit and debt tokens.
+  void SettleCredit();
+
+  // Settles the credit ledger, then balances current bids and offers to find
+  // new prices. Surplus offers cause the price to go down, unmatched bids
+  // cause it to go up. Also clears existing buy and sell offers since the
+  // prices change.
   void FindPrices();
 
   // Returns the maximum amount the supplicant can borrow.
@@ -90,6 +101,9 @@ public:
   // Returns true if the market trades in the good.
   bool TradesIn(const std::string& name) const;
 
+  // Credit obligations between traders not yet settled.
+  const CreditLedger& Ledger() const { return ledger_; }
+
   // Moves money, either legal tender or short-term credit, from from to to.
   void TransferMoney(micro::Measure amount, market::proto::Container* from,
                      market::proto::Container* to) const;
@@ -147,8 +161,23 @@ private:
     return proto_.name() + "_short_term_credit";
   }
 
+  // Credit and debt of participant, including unsettled ledger entries.
+  micro::Measure creditOf(const market::proto::Container& participant) const;
+  micro::Measure debtOf(const market::proto::Container& participant) const;
+
+  // Like TransferMoney, but legal tender is the only thing moved at once;
+  // credit is recorded in the ledger.
+  void deferMoney(micro::Measure amount, market::proto::Container* from,
+                  market::proto::Container* to);
+
   std::unordered_map<std::string, std::vector<Offer>> buy_offers_;
 
+  // Credit between traders matched in TryToSell, if defer_credit_. Transfers
+  // involving the warehouse are settled at once, since the per-good market
+  // debt is derived from the warehouse's tokens.
+  bool defer_credit_;
+  CreditLedger ledger_;
+
   proto::MarketProto proto_;
 
   // Stores how much has flowed into or out of the warehouse this turn.
@@ -218,6 +218,69 @@ TEST_F(MarketTest, TransferMoney) {
   EXPECT_EQ(GetAmount(poor, kDebt), 0);
 }
 
+TEST_F(MarketTest, DeferredCredit) {
+  market_.DeferCredit(true);
+  market_.RegisterGood(kTestGood1);
+  SetPrice(kTestGood1, micro::kOneInU);
+  Container seller;
+  SetAmount(kTestGood1, 2 * micro::kOneInU, &seller);
+  SetAmount(kSilver, micro::kOneInU / 2, &buyer_);
+
+  // Nothing in the warehouse, so the bid waits for the seller.
+  EXPECT_EQ(0, market_.TryToBuy(kTestGood1, micro::kOneInU, &buyer_));
+  EXPECT_EQ(micro::kOneInU,
+            market_.TryToSell(kTestGood1, micro::kOneInU, &seller));
+
+  // Silver moves at once; the credit is only in the ledger.
+  EXPECT_EQ(0, GetAmount(buyer_, kSilver));
+  EXPECT_EQ(micro::kOneInU / 2, GetAmount(seller, kSilver));
+  EXPECT_EQ(0, GetAmount(buyer_, kDebt));
+  EXPECT_EQ(0, GetAmount(seller, kCredit));
+  EXPECT_EQ(micro::kOneInU / 2, market_.Ledger().Exposure());
+  EXPECT_EQ(micro::kHundredInU - micro::kOneInU / 2,
+            market_.MaxCredit(buyer_));
+  EXPECT_EQ(micro::kHundredInU + micro::kOneInU,
+            market_.MaxMoney(seller));
+
+  market_.FindPrices();
+  EXPECT_EQ(0, market_.Ledger().Exposure());
+  EXPECT_EQ(micro::kOneInU / 2, GetAmount(buyer_, kDebt));
+  EXPECT_EQ(0, GetAmount(buyer_, kCredit));
+  EXPECT_EQ(micro::kOneInU / 2, GetAmount(seller, kCredit));
+  EXPECT_EQ(0, GetAmount(seller, kDebt));
+  EXPECT_EQ(micro::kHundredInU - micro::kOneInU / 2,
+            market_.MaxCredit(buyer_));
+}
+
+TEST_F(MarketTest, ImmediateCredit) {
+  market_.RegisterGood(kTestGood1);
+  SetPrice(kTestGood1, micro::kOneInU);
+  Container seller;
+  SetAmount(kTestGood1, 2 * micro::kOneInU, &seller);
+  SetAmount(kSilver, micro::kOneInU / 2, &buyer_);
+
+  // Unless deferral is asked for, credit moves with the goods, so a market
+  // that is never settled loses nothing.
+  EXPECT_EQ(0, market_.TryToBuy(kTestGood1, micro::kOneInU, &buyer_));
+  EXPECT_EQ(micro::kOneInU,
+            market_.TryToSell(kTestGood1, micro::kOneInU, &seller));
+  EXPECT_EQ(0, market_.Ledger().Exposure());
+  EXPECT_EQ(micro::kOneInU / 2, GetAmount(buyer_, kDebt));
+  EXPECT_EQ(micro::kOneInU / 2, GetAmount(seller, kCredit));
+
+  // Deferred credit is settled on request, not only by FindPrices.
+  market_.DeferCredit(true);
+  EXPECT_EQ(0, market_.TryToBuy(kTestGood1, micro::kOneInU, &buyer_));
+  EXPECT_EQ(micro::kOneInU,
+            market_.TryToSell(kTestGood1, micro::kOneInU, &seller));
+  EXPECT_EQ(micro::kOneInU, market_.Ledger().Exposure());
+  EXPECT_EQ(micro::kOneInU / 2, GetAmount(buyer_, kDebt));
+  market_.SettleCredit();
+  EXPECT_EQ(0, market_.Ledger().Exposure());
+  EXPECT_EQ(micro::kOneInU * 3 / 2, GetAmount(buyer_, kDebt));
+  EXPECT_EQ(micro::kOneInU * 3 / 2, GetAmount(seller, kCredit));
+}
+
 TEST_F(MarketTest, Available) {
   Market market;
   market.Proto()->set_legal_tender(kSilver);
@@ -1,5 +1,7 @@
 #include "games/population/consumption.h"
 
+#include <algorithm>
+
 #include "absl/strings/substitute.h"
 #include "games/market/goods_utils.h"
 #include "games/market/proto/goods.pb.h"
@@ -11,158 +13,314 @@
 
 namespace consumption {
 
-const int kMaxSubstitutables = 3;
-uint64 overflow;
+namespace {
 
-util::Status calcX(int64 a, int64 b, int64 px, int64 py, int64 dsquared_u,
-                   int64 offset_u, int64* value) {
+SolveCode calcX(int64 a, int64 b, int64 px, int64 py, int64 dsquared_u,
+                int64 offset_u, int64* value) {
+  uint64 overflow = 0;
   int64 aC = micro::MultiplyU(py, dsquared_u);
   aC = micro::MultiplyU(aC, a);
   aC = micro::DivideU(aC, micro::MultiplyU(b, px), &overflow);
   if (overflow != 0) {
-    return util::InvalidArgumentError(absl::Substitute(
-        "Division overflow with a=$0, b=$1, px=$2, py = $3, aC = $4", a, b, px,
-        py, aC));
+    return SOLVE_OVERFLOW;
   }
-  VLOGF(5, "Coefficients %d, %d => aC = %d", a, b, aC);
-
   int64 radical = micro::SqrtU(aC);
-  VLOGF(5, "Square root %d", radical);
   *value = micro::DivideU(radical - offset_u, a, &overflow);
   if (overflow != 0) {
-    return util::InvalidArgumentError(absl::Substitute(
-        "Division overflow with radical=$0, offset = $1, a = $2", radical,
-        offset_u, a));
+    return SOLVE_OVERFLOW;
   }
-  return util::OkStatus();
+  return SOLVE_OK;
 }
 
-util::Status internal_optimum_1(const market::proto::Quantity& good,
-                                const market::proto::Container& coefs,
-                                const market::proto::Container& prices,
-                                int64 offset_u, int64 dsquared_u,
-                                market::proto::Container* result) {
-  result->Clear();
-  auto coef = market::GetAmount(coefs, good.kind());
-  VLOGF(3, "D^2 %d, offset %d, coef %d", dsquared_u, offset_u, coef);
-  micro::Measure amount = dsquared_u - offset_u;
-  amount = micro::DivideU(amount, coef);
-  market::Add(good.kind(), amount, result);
-  return util::OkStatus();
+// The closed-form solutions below work on the goods listed in scratch->free,
+// and shrink that list when they clamp a good to zero.
+void dense_optimum_1(const Problem& problem, int64 dsquared_u, Scratch* scratch,
+                     Amounts* result) {
+  result->fill(0);
+  const int good = scratch->free[0];
+  scratch->num_free = 1;
+  micro::Measure amount = dsquared_u - problem.offset_u;
+  (*result)[good] = micro::DivideU(amount, problem.coefs_u[good]);
 }
 
-util::Status
-internal_optimum_2(const std::vector<market::proto::Quantity>& goods,
-                   const market::proto::Container& coefs,
-                   const market::proto::Container& prices, int64 offset_u,
-                   int64 dsquared_u, market::proto::Container* result) {
-  if (goods.size() != 2) {
-    return util::InvalidArgumentError(
-        absl::Substitute("Optimum expected 2 goods, got $0", goods.size()));
-  }
-
-  result->Clear();
-  market::proto::Container coeffs;
-  int64 a = market::GetAmount(coefs, goods[0].kind());
-  int64 b = market::GetAmount(coefs, goods[1].kind());
-  int64 px = market::GetAmount(prices, goods[0].kind());
-  int64 py = market::GetAmount(prices, goods[1].kind());
-  VLOGF(5, "Calculating %s/%s with prices %d, %d", goods[0].kind(),
-        goods[1].kind(), px, py);
+SolveCode dense_optimum_2(const Problem& problem, int64 dsquared_u,
+                          Scratch* scratch, Amounts* result) {
+  result->fill(0);
+  const int x = scratch->free[0];
+  const int y = scratch->free[1];
+  const int64 a = problem.coefs_u[x];
+  const int64 b = problem.coefs_u[y];
+  const int64 px = problem.prices_u[x];
+  const int64 py = problem.prices_u[y];
 
   int64 xValue = 0;
   int64 yValue = 0;
-  auto status = calcX(a, b, px, py, dsquared_u, offset_u, &xValue);
-  if (!status.ok()) {
-    return status;
+  SolveCode code =
+      calcX(a, b, px, py, dsquared_u, problem.offset_u, &xValue);
+  if (code != SOLVE_OK) {
+    return code;
   }
-  status = calcX(b, a, py, px, dsquared_u, offset_u, &yValue);
-  if (!status.ok()) {
-    return status;
+  code = calcX(b, a, py, px, dsquared_u, problem.offset_u, &yValue);
+  if (code != SOLVE_OK) {
+    return code;
   }
 
   if (xValue < 0 && yValue < 0) {
     // This should never happen.
-    return util::InvalidArgumentError(
-        absl::Substitute("Two negative amounts for $0 and $1", goods[0].kind(),
-                         goods[1].kind()));
+    return SOLVE_NEGATIVE;
   }
   if (xValue < 0) {
-    return internal_optimum_1(goods[1], coefs, prices, offset_u, dsquared_u,
-                              result);
+    scratch->free[0] = y;
+    dense_optimum_1(problem, dsquared_u, scratch, result);
+    return SOLVE_OK;
   }
   if (yValue < 0) {
-    return internal_optimum_1(goods[0], coefs, prices, offset_u, dsquared_u,
-                              result);
+    dense_optimum_1(problem, dsquared_u, scratch, result);
+    return SOLVE_OK;
   }
 
-  market::SetAmount(goods[0].kind(), xValue, result);
-  market::SetAmount(goods[1].kind(), yValue, result);
-
-  return util::OkStatus();
+  (*result)[x] = xValue;
+  (*result)[y] = yValue;
+  return SOLVE_OK;
 }
 
-util::Status
-internal_optimum_3(const std::vector<market::proto::Quantity>& goods,
-                   const market::proto::Container& coefs,
-                   const market::proto::Container& prices, int64 offset_u,
-                   int64 dsquared_u, market::proto::Container* result) {
-  if (goods.size() != 3) {
-    return util::InvalidArgumentError(
-        absl::Substitute("Optimum expected 3 goods, got $0", goods.size()));
-  }
-
-  result->Clear();
-  int64 coefficients[3];
-  for (int i = 0; i < 3; ++i) {
-    coefficients[i] = market::GetAmount(coefs, goods[i].kind());
-  }
-
+SolveCode dense_optimum_3(const Problem& problem, int64 dsquared_u,
+                          Scratch* scratch, Amounts* result) {
+  result->fill(0);
+  const int goods[3] = {scratch->free[0], scratch->free[1], scratch->free[2]};
+  uint64 overflow = 0;
   for (int i = 0; i < 3; ++i) {
-    int j = (i + 1) % 3;
-    int k = (i + 2) % 3;
-    int64 priceI = market::GetAmount(prices, goods[i].kind());
-    int64 priceJ = market::GetAmount(prices, goods[j].kind());
-    int64 priceK = market::GetAmount(prices, goods[k].kind());
-    int64 priceFrac = micro::MultiplyU(priceJ, priceK);
-    priceFrac = micro::DivideU(priceFrac, micro::SquareU(priceI), &overflow);
+    const int gi = goods[i];
+    const int gj = goods[(i + 1) % 3];
+    const int gk = goods[(i + 2) % 3];
+    const int64 coefI = problem.coefs_u[gi];
+    int64 priceFrac = micro::MultiplyU(problem.prices_u[gj], problem.prices_u[gk]);
+    priceFrac = micro::DivideU(
+        priceFrac, micro::SquareU(problem.prices_u[gi]), &overflow);
     if (overflow != 0) {
-      return util::InvalidArgumentError(
-          absl::Substitute("Overflow in price-ratio calculation $0: $1, $2, $3",
-                           i, priceI, priceJ, priceK));
+      return SOLVE_OVERFLOW;
     }
-    int64 coefFrac =
-        micro::MultiplyU(dsquared_u, micro::SquareU(coefficients[i]));
+    int64 coefFrac = micro::MultiplyU(dsquared_u, micro::SquareU(coefI));
     coefFrac = micro::DivideU(
-        coefFrac, micro::MultiplyU(coefficients[j], coefficients[k]),
+        coefFrac, micro::MultiplyU(problem.coefs_u[gj], problem.coefs_u[gk]),
         &overflow);
     if (overflow != 0) {
-      return util::InvalidArgumentError(absl::Substitute(
-          "Overflow in coefficient-ratio calculation $0: $1, $2, $3", i,
-          coefficients[i], coefficients[j], coefficients[k]));
+      return SOLVE_OVERFLOW;
     }
     int64 root = micro::NRootU(3, micro::MultiplyU(coefFrac, priceFrac));
-    root -= offset_u;
-    int64 xValue = micro::DivideU(root, coefficients[i], &overflow);
+    root -= problem.offset_u;
+    int64 xValue = micro::DivideU(root, coefI, &overflow);
     if (overflow != 0) {
-      return util::InvalidArgumentError(absl::Substitute(
-          "Overflow in final division $0: $1 / $2", i, root, coefficients[i]));
+      return SOLVE_OVERFLOW;
     }
 
     if (xValue < 0) {
       // Clamp this good to zero, recalculating D^2 for the reduced call.
-      auto reduced_dsquared_u = micro::DivideU(dsquared_u, offset_u);
-      std::vector<market::proto::Quantity> copy;
-      copy.push_back(goods[j]);
-      copy.push_back(goods[k]);
-      return internal_optimum_2(copy, coefs, prices, offset_u,
-                                reduced_dsquared_u, result);
+      scratch->free[0] = gj;
+      scratch->free[1] = gk;
+      scratch->num_free = 2;
+      return dense_optimum_2(problem,
+                             micro::DivideU(dsquared_u, problem.offset_u),
+                             scratch, result);
     }
 
-    market::SetAmount(goods[i].kind(), xValue, result);
+    (*result)[gi] = xValue;
   }
 
-  return util::OkStatus();
+  return SOLVE_OK;
+}
+
+// General solution for any number of goods, see the doc: each free good has
+// c_i x_i + o proportional to c_i / p_i, with the product over all goods equal
+// to D^2. Goods that fall below their lower bound are clamped there and the
+// rest recalculated; clamping only lowers the others, so this stops after at
+// most num_goods rounds.
+SolveCode dense_optimum_n(const Problem& problem, Scratch* scratch,
+                          Amounts* result) {
+  result->fill(0);
+  const int num = problem.num_goods;
+  uint64 overflow = 0;
+  for (int i = 0; i < num; ++i) {
+    scratch->lower_u[i] =
+        micro::MultiplyU(problem.coefs_u[i], problem.minima_u[i]) +
+        problem.offset_u;
+  }
+
+  int64 dsquared_u = problem.dsquared_u;
+  while (scratch->num_free > 0) {
+    const int free = scratch->num_free;
+    for (int f = 0; f < free; ++f) {
+      const int i = scratch->free[f];
+      int64 value_u = dsquared_u;
+      for (int g = 0; g < free; ++g) {
+        if (g == f) {
+          continue;
+        }
+        const int j = scratch->free[g];
+        value_u = micro::MultiplyU(value_u, problem.coefs_u[i]);
+        value_u = micro::DivideU(value_u, problem.coefs_u[j], &overflow);
+        if (overflow != 0) {
+          return SOLVE_OVERFLOW;
+        }
+        value_u = micro::MultiplyU(value_u, problem.prices_u[j]);
+        value_u = micro::DivideU(value_u, problem.prices_u[i], &overflow);
+        if (overflow != 0) {
+          return SOLVE_OVERFLOW;
+        }
+      }
+      scratch->terms_u[i] = value_u > 0 ? micro::NRootU(free, value_u) : 0;
+    }
+
+    int kept = 0;
+    for (int f = 0; f < free; ++f) {
+      const int i = scratch->free[f];
+      if (scratch->terms_u[i] >= scratch->lower_u[i]) {
+        scratch->free[kept++] = i;
+        continue;
+      }
+      scratch->terms_u[i] = scratch->lower_u[i];
+      dsquared_u = micro::DivideU(dsquared_u, scratch->lower_u[i], &overflow);
+      if (overflow != 0) {
+        return SOLVE_OVERFLOW;
+      }
+    }
+    if (kept == free) {
+      break;
+    }
+    scratch->num_free = kept;
+  }
+
+  for (int i = 0; i < num; ++i) {
+    (*result)[i] = micro::DivideU(scratch->terms_u[i] - problem.offset_u,
+                                  problem.coefs_u[i], &overflow);
+    if (overflow != 0) {
+      return SOLVE_OVERFLOW;
+    }
+  }
+  return SOLVE_OK;
+}
+
+// Calculates the coefficient of a good with the given crossing point.
+SolveCode coefficient(int64 crossing_u, int64 dsquared_u, int64 offset_u,
+                      int numGoods, int64* coef_u) {
+  uint64 overflow = 0;
+  int64 nom = dsquared_u - micro::PowU(offset_u, numGoods);
+  int64 denom = micro::MultiplyU(crossing_u, micro::PowU(offset_u, numGoods - 1));
+  *coef_u = micro::DivideU(nom, denom, &overflow);
+  return overflow != 0 ? SOLVE_OVERFLOW : SOLVE_OK;
+}
+
+// Fills in the goods and prices of problem, with goods in name order so that
+// clamping is deterministic.
+SolveCode fillProblem(const market::proto::Container& goods,
+                      const market::proto::Container& prices,
+                      Problem* problem) {
+  problem->num_goods = goods.quantities().size();
+  if (problem->num_goods < 1 || problem->num_goods > kMaxSubstitutables) {
+    return SOLVE_GOOD_COUNT;
+  }
+  int idx = 0;
+  for (const auto& good : goods.quantities()) {
+    problem->goods[idx++] = &good.first;
+  }
+  std::sort(problem->goods.begin(),
+            problem->goods.begin() + problem->num_goods,
+            [](const std::string* one, const std::string* two) {
+              return *one < *two;
+            });
+  for (int i = 0; i < problem->num_goods; ++i) {
+    problem->prices_u[i] = market::GetAmount(prices, *problem->goods[i]);
+    problem->minima_u[i] = 0;
+  }
+  return SOLVE_OK;
+}
+
+util::Status toStatus(SolveCode code, const Problem& problem) {
+  switch (code) {
+  case SOLVE_OK:
+    return util::OkStatus();
+  case SOLVE_OVERFLOW:
+    return util::InvalidArgumentError(absl::Substitute(
+        "Overflow in optimum for $0 goods, D^2 = $1, offset = $2",
+        problem.num_goods, problem.dsquared_u, problem.offset_u));
+  case SOLVE_NEGATIVE:
+    return util::InvalidArgumentError(absl::Substitute(
+        "Negative amounts for all of $0 goods", problem.num_goods));
+  case SOLVE_GOOD_COUNT:
+    return util::InvalidArgumentError(
+        absl::Substitute("Optimum for $0 goods, can handle at most $1",
+                         problem.num_goods, kMaxSubstitutables));
+  }
+  return util::InvalidArgumentError("Unknown solver error");
+}
+
+// Writes the goods the solver left unclamped, or clamped to a nonzero
+// minimum, into result.
+void storeResult(const Problem& problem, const Scratch& scratch,
+                 const Amounts& amounts, market::proto::Container* result) {
+  result->Clear();
+  for (int i = 0; i < problem.num_goods; ++i) {
+    if (amounts[i] != 0) {
+      market::SetAmount(*problem.goods[i], amounts[i], result);
+    }
+  }
+  for (int i = 0; i < scratch.num_free; ++i) {
+    const int good = scratch.free[i];
+    market::SetAmount(*problem.goods[good], amounts[good], result);
+  }
+}
+
+} // namespace
+
+SolveCode DenseOptimum(const Problem& problem, Scratch* scratch,
+                       Amounts* result) {
+  result->fill(0);
+  if (problem.num_goods < 1 || problem.num_goods > kMaxSubstitutables) {
+    return SOLVE_GOOD_COUNT;
+  }
+  scratch->num_free = problem.num_goods;
+  for (int i = 0; i < problem.num_goods; ++i) {
+    scratch->free[i] = i;
+  }
+  bool minima = false;
+  for (int i = 0; i < problem.num_goods; ++i) {
+    minima = minima || problem.minima_u[i] > 0;
+  }
+  if (minima) {
+    return dense_optimum_n(problem, scratch, result);
+  }
+  switch (problem.num_goods) {
+  case 1:
+    dense_optimum_1(problem, problem.dsquared_u, scratch, result);
+    return SOLVE_OK;
+  case 2:
+    return dense_optimum_2(problem, problem.dsquared_u, scratch, result);
+  case 3:
+    return dense_optimum_3(problem, problem.dsquared_u, scratch, result);
+  }
+  return dense_optimum_n(problem, scratch, result);
+}
+
+SolveCode MakeProblem(const proto::Substitutes& subs,
+                      const market::proto::Container& prices,
+                      Problem* problem) {
+  problem->offset_u = subs.offset_u();
+  problem->dsquared_u = subs.min_amount_square_u();
+  SolveCode code = fillProblem(subs.consumed(), prices, problem);
+  if (code != SOLVE_OK) {
+    return code;
+  }
+  for (int i = 0; i < problem->num_goods; ++i) {
+    problem->minima_u[i] =
+        market::GetAmount(subs.minimum(), *problem->goods[i]);
+    code = coefficient(market::GetAmount(subs.consumed(), *problem->goods[i]),
+                       problem->dsquared_u, problem->offset_u,
+                       problem->num_goods, &problem->coefs_u[i]);
+    if (code != SOLVE_OK) {
+      return code;
+    }
+  }
+  return SOLVE_OK;
 }
 
 namespace {
@@ -171,22 +329,23 @@ util::Status internal_optimum(const market::proto::Container& goods,
                               const market::proto::Container& prices,
                               int64 offset_u, int64 dsquared_u,
                               market::proto::Container* result) {
-  auto expanded = market::Expand(goods);
-  switch (expanded.size()) {
-  case 1:
-    return internal_optimum_1(expanded[0], coefs, prices, offset_u, dsquared_u,
-                              result);
-  case 2:
-    return internal_optimum_2(expanded, coefs, prices, offset_u, dsquared_u,
-                              result);
-  case 3:
-    return internal_optimum_3(expanded, coefs, prices, offset_u, dsquared_u,
-                              result);
-  default:
-    return util::InvalidArgumentError(
-        absl::Substitute("Optimum for $0 goods, can handle at most $1",
-                         goods.quantities().size(), kMaxSubstitutables));
-  }
+  Problem problem;
+  problem.offset_u = offset_u;
+  problem.dsquared_u = dsquared_u;
+  SolveCode code = fillProblem(goods, prices, &problem);
+  if (code != SOLVE_OK) {
+    return toStatus(code, problem);
+  }
+  for (int i = 0; i < problem.num_goods; ++i) {
+    problem.coefs_u[i] = market::GetAmount(coefs, *problem.goods[i]);
+  }
+  Scratch scratch;
+  Amounts amounts;
+  code = DenseOptimum(problem, &scratch, &amounts);
+  if (code != SOLVE_OK) {
+    return toStatus(code, problem);
+  }
+  storeResult(problem, scratch, amounts, result);
   return util::OkStatus();
 }
 
@@ -330,17 +489,12 @@ util::Status coefficients(const proto::Substitutes& subs,
   int64 dsquared_u = subs.min_amount_square_u();
   int64 offset_u = subs.offset_u();
   int numGoods = subs.consumed().quantities().size();
-  int64 nom = dsquared_u - micro::PowU(offset_u, numGoods);
-
   for (const auto& good : subs.consumed().quantities()) {
-    int64 crossing_u = good.second;
-    int64 denom =
-        micro::MultiplyU(crossing_u, micro::PowU(offset_u, numGoods - 1));
-    int64 coef_u = micro::DivideU(nom, denom, &overflow);
-    if (overflow != 0) {
+    int64 coef_u = 0;
+    if (coefficient(good.second, dsquared_u, offset_u, numGoods, &coef_u) !=
+        SOLVE_OK) {
       return util::InvalidArgumentError(absl::Substitute(
-          "Division overflow in coefficient of $0 with nom = $1, denom = $2",
-          good.first, nom, denom));
+          "Division overflow in coefficient of $0", good.first));
     }
     market::SetAmount(good.first, coef_u, coefs);
   }
@@ -359,10 +513,19 @@ util::Status Optimum(const proto::Substitutes& subs,
                            subs.name(), price.second, price.first));
     }
   }
-  market::proto::Container coefs;
-  coefficients(subs, &coefs);
-  return internal_optimum(subs.consumed(), coefs, prices, subs.offset_u(),
-                          subs.min_amount_square_u(), result);
+  Problem problem;
+  SolveCode code = MakeProblem(subs, prices, &problem);
+  if (code != SOLVE_OK) {
+    return toStatus(code, problem);
+  }
+  Scratch scratch;
+  Amounts amounts;
+  code = DenseOptimum(problem, &scratch, &amounts);
+  if (code != SOLVE_OK) {
+    return toStatus(code, problem);
+  }
+  storeResult(problem, scratch, amounts, result);
+  return util::OkStatus();
 }
 
 util::Status Consumption(const proto::Substitutes& subs,
@@ -484,6 +647,7 @@ util::Status Validate(const proto::Substitutes& subs) {
   for (const auto& good : subs.consumed().quantities()) {
     auto nom = dsquared_u - micro::MultiplyU(offset_u, offset_u);
     auto denom = micro::MultiplyU(good.second, offset_u);
+    uint64 overflow = 0;
     auto ratio = micro::DivideU(nom, denom, &overflow);
     if (overflow != 0) {
       return util::InvalidArgumentError(absl::Substitute(
@@ -503,6 +667,7 @@ util::Status Validate(const proto::Substitutes& subs) {
   for (const auto& good : subs.movable_capital().quantities()) {
     auto nom = dsquared_u - micro::MultiplyU(offset_u, offset_u);
     auto denom = micro::MultiplyU(good.second, offset_u);
+    uint64 overflow = 0;
     auto ratio = micro::DivideU(nom, denom, &overflow);
     if (overflow != 0) {
       return util::InvalidArgumentError(absl::Substitute(
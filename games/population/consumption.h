@@ -1,16 +1,72 @@
 #ifndef BASE_POPULATION_CONSUMPTION_H
 #define BASE_POPULATION_CONSUMPTION_H
 
+#include <array>
+#include <string>
+
 #include "games/market/market.h"
 #include "games/market/proto/goods.pb.h"
 #include "games/population/proto/consumption.pb.h"
+#include "util/arithmetic/microunits.h"
 #include "util/headers/int_types.h"
 #include "util/status/status.h"
 
 
 namespace consumption {
 
-extern const int kMaxSubstitutables;
+constexpr int kMaxSubstitutables = 8;
+
+// Outcome of DenseOptimum. A plain code rather than a Status, so that failures
+// in the solver do not build strings; Optimum and Consumption convert it.
+enum SolveCode {
+  SOLVE_OK = 0,
+  SOLVE_OVERFLOW,
+  // No good has a nonnegative optimum.
+  SOLVE_NEGATIVE,
+  // The number of goods is zero or above kMaxSubstitutables.
+  SOLVE_GOOD_COUNT,
+};
+
+// Per-good values, indexed like Problem::goods.
+typedef std::array<micro::Measure, kMaxSubstitutables> Amounts;
+
+// Dense form of the optimisation problem for one Substitutes block.
+struct Problem {
+  int num_goods;
+  // Names of the goods, pointing into the proto the problem was made from.
+  std::array<const std::string*, kMaxSubstitutables> goods;
+  Amounts coefs_u;
+  Amounts prices_u;
+  // Lower bounds on the amounts; zero for goods with no minimum.
+  Amounts minima_u;
+  micro::Measure offset_u;
+  micro::Measure dsquared_u;
+};
+
+// Caller-owned working memory for DenseOptimum.
+struct Scratch {
+  // Indices of the goods not clamped to their lower bound.
+  std::array<int, kMaxSubstitutables> free;
+  int num_free;
+  // Per-good c_i x_i + o, and its lower bound c_i m_i + o.
+  Amounts terms_u;
+  Amounts lower_u;
+};
+
+// Fills in problem from subs and prices, including the minima. The goods are
+// sorted by name.
+SolveCode MakeProblem(const proto::Substitutes& subs,
+                      const market::proto::Container& prices,
+                      Problem* problem);
+
+// Calculates the optimum of problem into result; on return scratch lists the
+// goods that were not clamped to their lower bound. Up to three goods with no
+// minima use the closed forms from the doc, anything else the general
+// n-dimensional solution with clamping. Does not allocate, log, or touch any
+// shared state, so it may be called concurrently from several threads as long
+// as each has its own scratch and result.
+SolveCode DenseOptimum(const Problem& problem, Scratch* scratch,
+                       Amounts* result);
 
 // Calculates the optimum consumption point given the prices, as shown in the
 // doc, and stores it in result. Exposed for testing; to get a result suitable
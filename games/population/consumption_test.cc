@@ -2,6 +2,8 @@
 #include "games/population/consumption.h"
 
 #include <functional>
+#include <string>
+#include <vector>
 
 #include "games/market/goods_utils.h"
 #include "games/population/proto/consumption.pb.h"
@@ -9,6 +11,7 @@
 #include "gtest/gtest.h"
 #include "util/arithmetic/microunits.h"
 #include "util/logging/logging.h"
+#include "util/threads/parallel.h"
 
 namespace consumption {
 namespace {
@@ -157,10 +160,13 @@ TEST(ConsumptionTest, Validation) {
   status = Validate(subs);
   EXPECT_TRUE(status.ok()) << status.message();
 
-  market::Add("pears", 3*micro::kOneInU, subs.mutable_consumed());
+  for (const char* extra : {"pears", "plums", "figs", "dates", "limes",
+                            "kiwis"}) {
+    market::Add(extra, 3*micro::kOneInU, subs.mutable_consumed());
+  }
   status = Validate(subs);
   EXPECT_THAT(status.ToString(), testing::HasSubstr("handle at most"));
-  EXPECT_THAT(status.ToString(), testing::HasSubstr("found 4"));
+  EXPECT_THAT(status.ToString(), testing::HasSubstr("found 9"));
 }
 
 struct FakeMarket : public market::AvailabilityEstimator {
@@ -403,4 +409,124 @@ TEST(ConsumptionTest, Minima) {
   EXPECT_EQ(153741, market::GetAmount(result, kBananas));
 }
 
+TEST(ConsumptionTest, ManyGoods) {
+  proto::Substitutes subs;
+  market::proto::Container result;
+  market::proto::Container prices;
+  const std::vector<std::string> goods = {"a", "b", "c", "d", "e"};
+  for (const auto& good : goods) {
+    market::Add(good, 3*micro::kOneInU, subs.mutable_consumed());
+    market::SetAmount(good, micro::kOneInU, &prices);
+  }
+  EXPECT_TRUE(Validate(subs).ok());
+  EXPECT_TRUE(Optimum(subs, prices, &result).ok());
+  // Each term is the fifth root of D^2, so x = (1 - 1/2) / c, with
+  // c = 31/6.
+  for (const auto& good : goods) {
+    EXPECT_NEAR(96774, market::GetAmount(result, good), 2) << good;
+  }
+
+  // Prices 1 to 6 give f the smallest term, k/6 with k = 720^{1/6}, which
+  // is below the offset; it is clamped to zero, doubling D^2 for the other
+  // five, which get k/p - o over c = 21/2 with k = 240^{1/5}.
+  market::Add("f", 3*micro::kOneInU, subs.mutable_consumed());
+  const std::vector<micro::Measure> expected = {237386, 94884, 47383, 23632,
+                                                9382};
+  for (int i = 0; i < 6; ++i) {
+    market::SetAmount(std::string(1, 'a' + i), (i + 1) * micro::kOneInU,
+                      &prices);
+  }
+  EXPECT_TRUE(Validate(subs).ok());
+  EXPECT_TRUE(Optimum(subs, prices, &result).ok());
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_NEAR(expected[i], market::GetAmount(result, goods[i]), 5)
+        << goods[i];
+  }
+  EXPECT_FALSE(market::Contains(result, "f"));
+}
+
+TEST(ConsumptionTest, OptimumMinima) {
+  proto::Substitutes subs;
+  market::proto::Container result;
+  market::proto::Container prices;
+  market::Add(kApples, 3*micro::kOneInU, subs.mutable_consumed());
+  market::Add(kOranges, 3*micro::kOneInU, subs.mutable_consumed());
+  market::SetAmount(kApples, 2*micro::kOneInU, &prices);
+  market::SetAmount(kOranges, micro::kOneInU, &prices);
+
+  // The unconstrained optimum has sqrt{2} - 1 apples; forcing one whole
+  // apple leaves c x + o = 1 for it, so oranges also come out at one.
+  market::SetAmount(kApples, micro::kOneInU, subs.mutable_minimum());
+  EXPECT_TRUE(Optimum(subs, prices, &result).ok());
+  EXPECT_EQ(micro::kOneInU, market::GetAmount(result, kApples));
+  EXPECT_EQ(micro::kOneInU, market::GetAmount(result, kOranges));
+
+  // A negligible minimum goes through the general solution, which must agree
+  // with the closed form.
+  market::SetAmount(kApples, 1, subs.mutable_minimum());
+  EXPECT_TRUE(Optimum(subs, prices, &result).ok());
+  EXPECT_NEAR(414214, market::GetAmount(result, kApples), 2);
+  EXPECT_NEAR(1828428, market::GetAmount(result, kOranges), 2);
+
+  market::SetAmount(kApples, 3*micro::kOneInU, subs.mutable_consumed());
+  market::SetAmount(kOranges, 1*micro::kOneInU, subs.mutable_consumed());
+  market::Add(kBananas, 3*micro::kOneInU, subs.mutable_consumed());
+  market::SetAmount(kApples, micro::kOneInU, &prices);
+  market::SetAmount(kBananas, micro::kOneInU, &prices);
+  EXPECT_TRUE(Optimum(subs, prices, &result).ok());
+  EXPECT_NEAR(165738, market::GetAmount(result, kApples), 2);
+  EXPECT_NEAR(451452, market::GetAmount(result, kOranges), 2);
+  EXPECT_NEAR(165738, market::GetAmount(result, kBananas), 2);
+}
+
+TEST(ConsumptionTest, DenseOptimum) {
+  proto::Substitutes subs;
+  market::proto::Container prices;
+  market::SetAmount(kApples, 3*micro::kOneInU, subs.mutable_consumed());
+  market::SetAmount(kOranges, 1*micro::kOneInU, subs.mutable_consumed());
+  market::SetAmount(kBananas, 3*micro::kOneInU, subs.mutable_consumed());
+  market::SetAmount(kApples, micro::kOneInU, &prices);
+  market::SetAmount(kOranges, micro::kOneInU, &prices);
+  market::SetAmount(kBananas, micro::kOneInU, &prices);
+
+  Problem problem;
+  ASSERT_EQ(SOLVE_OK, MakeProblem(subs, prices, &problem));
+  ASSERT_EQ(3, problem.num_goods);
+  EXPECT_EQ(kApples, *problem.goods[0]);
+  EXPECT_EQ(kBananas, *problem.goods[1]);
+  EXPECT_EQ(kOranges, *problem.goods[2]);
+
+  // Many solvers at once must agree with each other and with Optimum.
+  constexpr int kRuns = 64;
+  std::vector<Amounts> results(kRuns);
+  std::vector<SolveCode> codes(kRuns);
+  threads::ParallelFor(kRuns, [&](int i) {
+    Scratch scratch;
+    codes[i] = DenseOptimum(problem, &scratch, &results[i]);
+  });
+  for (int i = 0; i < kRuns; ++i) {
+    EXPECT_EQ(SOLVE_OK, codes[i]);
+    EXPECT_EQ(165738, results[i][0]);
+    EXPECT_EQ(165738, results[i][1]);
+    EXPECT_EQ(451452, results[i][2]);
+  }
+
+  // Clamped goods are dropped from the free list.
+  market::SetAmount(kOranges, 3*micro::kOneInU, subs.mutable_consumed());
+  market::SetAmount(kOranges, 3*micro::kOneInU, &prices);
+  ASSERT_EQ(SOLVE_OK, MakeProblem(subs, prices, &problem));
+  Scratch scratch;
+  Amounts amounts;
+  EXPECT_EQ(SOLVE_OK, DenseOptimum(problem, &scratch, &amounts));
+  ASSERT_EQ(2, scratch.num_free);
+  EXPECT_EQ(0, scratch.free[0]);
+  EXPECT_EQ(1, scratch.free[1]);
+  EXPECT_EQ(783612, amounts[0]);
+  EXPECT_EQ(783612, amounts[1]);
+  EXPECT_EQ(0, amounts[2]);
+
+  problem.num_goods = 0;
+  EXPECT_EQ(SOLVE_GOOD_COUNT, DenseOptimum(problem, &scratch, &amounts));
+}
+
 } // namespace consumption
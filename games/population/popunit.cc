@@ -10,6 +10,7 @@
 #include "games/industry/industry.h"
 #include "games/market/goods_utils.h"
 #include "util/arithmetic/microunits.h"
+#include "util/context/context.h"
 #include "util/keywords/keywords.h"
 
 namespace population {
@@ -17,7 +18,6 @@ namespace population {
 using industry::proto::Production;
 
 namespace {
-uint64 unused_pop_id = 1;
 constexpr int kNumAgeGroups = 7;
 constexpr char kExpectedProfit[] = "expected_profit";
 constexpr char kStandardDeviation[] = "standard_deviation";
@@ -40,7 +40,14 @@ void BuyPackage(const proto::ConsumptionPackage& package, int size,
 
 } // namespace
 
-std::unordered_map<uint64, PopUnit*> PopUnit::id_to_pop_map_;
+struct PopUnit::Registry {
+  uint64 unused_pop_id = 1;
+  std::unordered_map<uint64, PopUnit*> pops;
+};
+
+PopUnit::Registry& PopUnit::registry() {
+  return util::Context::Current().Get<Registry>();
+}
 
 PopUnit::PopUnit() : packages_ordered_(0) {
   proto_.set_pop_id(NewPopId());
@@ -48,14 +55,15 @@ PopUnit::PopUnit() : packages_ordered_(0) {
     proto_.add_males(0);
     proto_.add_women(0);
   }
-  id_to_pop_map_[proto_.pop_id()] = this;
+  registry().pops[proto_.pop_id()] = this;
 }
 
 PopUnit::PopUnit(const proto::PopUnit& proto) : proto_(proto) {
-  if (id_to_pop_map_[proto_.pop_id()] != nullptr) {
+  auto& pops = registry().pops;
+  if (pops[proto_.pop_id()] != nullptr) {
     // TODO: Error here.
   }
-  id_to_pop_map_[proto_.pop_id()] = this;
+  pops[proto_.pop_id()] = this;
 }
 
 void PopUnit::AutoProduce(const std::vector<proto::AutoProduction>& production,
@@ -227,6 +235,15 @@ void PopUnit::SellSurplus(market::Market* market) {
   }
 }
 
-uint64 PopUnit::NewPopId() { return ++unused_pop_id; }
+PopUnit* PopUnit::GetPopId(uint64 id) {
+  const auto& pops = registry().pops;
+  auto found = pops.find(id);
+  if (found == pops.end()) {
+    return nullptr;
+  }
+  return found->second;
+}
+
+uint64 PopUnit::NewPopId() { return ++registry().unused_pop_id; }
 
 } // namespace population
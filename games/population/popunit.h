@@ -52,7 +52,7 @@ public:
   void StartTurn(const std::vector<proto::ConsumptionLevel>& levels,
                  market::Market* market);
 
-  static PopUnit* GetPopId(uint64 id) { return id_to_pop_map_[id]; }
+  static PopUnit* GetPopId(uint64 id);
 
   static uint64 NewPopId();
 
@@ -69,7 +69,9 @@ public:
   uint64 pop_id() const { return proto_.pop_id(); }
 
 private:
-  static std::unordered_map<uint64, PopUnit*> id_to_pop_map_;
+  // Pops and pop IDs of one simulation context.
+  struct Registry;
+  static Registry& registry();
 
   // The underlying data in wire format.
   proto::PopUnit proto_;
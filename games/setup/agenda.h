@@ -0,0 +1,82 @@
+// Schedule of when simulated entities next need attention.
+#ifndef GAMES_SETUP_AGENDA_H
+#define GAMES_SETUP_AGENDA_H
+
+#include <functional>
+#include <limits>
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "util/headers/int_types.h"
+
+namespace games {
+namespace setup {
+
+// Records, for entities that have nothing to do for a while, the turn at
+// which each next needs to be processed, so that a turn loop can skip the
+// rest. Entities that were never put to sleep are always due, so callers can
+// adopt this one entity type and one condition at a time. Sleeping until
+// kNever means waiting for an explicit Wake, for example when a condition the
+// entity depends on changes.
+template <typename Key, typename Hash = std::hash<Key>>
+class Agenda {
+public:
+  static constexpr uint64 kNever = std::numeric_limits<uint64>::max();
+
+  // Marks key as not needing attention before turn.
+  void SleepUntil(const Key& key, uint64 turn) {
+    wake_turns_[key] = turn;
+    if (turn != kNever) {
+      by_turn_.emplace(turn, key);
+    }
+  }
+
+  // Marks key as needing attention from now on.
+  void Wake(const Key& key) { wake_turns_.erase(key); }
+
+  // Returns true if key should be processed on turn.
+  bool Due(const Key& key, uint64 turn) const {
+    auto it = wake_turns_.find(key);
+    return it == wake_turns_.end() || it->second <= turn;
+  }
+
+  // Wakes the entities whose sleep ends at or before turn, appending them to
+  // woken if it is not null.
+  void Advance(uint64 turn, std::vector<Key>* woken) {
+    auto end = by_turn_.upper_bound(turn);
+    for (auto it = by_turn_.begin(); it != end; ++it) {
+      // Skip entries superseded by a later SleepUntil or Wake.
+      auto current = wake_turns_.find(it->second);
+      if (current == wake_turns_.end() || current->second != it->first) {
+        continue;
+      }
+      wake_turns_.erase(current);
+      if (woken != nullptr) {
+        woken->push_back(it->second);
+      }
+    }
+    by_turn_.erase(by_turn_.begin(), end);
+  }
+
+  // Returns the number of entities currently asleep.
+  int sleeping() const { return wake_turns_.size(); }
+
+  void Clear() {
+    wake_turns_.clear();
+    by_turn_.clear();
+  }
+
+private:
+  std::unordered_map<Key, uint64, Hash> wake_turns_;
+  std::multimap<uint64, Key> by_turn_;
+};
+
+template <typename Key, typename Hash>
+constexpr uint64 Agenda<Key, Hash>::kNever;
+
+}  // namespace setup
+}  // namespace games
+
+#endif
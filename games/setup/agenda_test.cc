@@ -0,0 +1,51 @@
+#include "games/setup/agenda.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace games {
+namespace setup {
+
+TEST(AgendaTest, SleepAndWake) {
+  Agenda<int> agenda;
+  EXPECT_TRUE(agenda.Due(1, 0));
+
+  agenda.SleepUntil(1, 5);
+  agenda.SleepUntil(2, Agenda<int>::kNever);
+  EXPECT_EQ(2, agenda.sleeping());
+  EXPECT_FALSE(agenda.Due(1, 4));
+  EXPECT_TRUE(agenda.Due(1, 5));
+  EXPECT_FALSE(agenda.Due(2, 1000));
+
+  agenda.Wake(2);
+  EXPECT_TRUE(agenda.Due(2, 0));
+  EXPECT_EQ(1, agenda.sleeping());
+}
+
+TEST(AgendaTest, Advance) {
+  Agenda<int> agenda;
+  agenda.SleepUntil(1, 3);
+  agenda.SleepUntil(2, 5);
+  agenda.SleepUntil(3, 4);
+  // Rescheduled; the earlier entry is stale.
+  agenda.SleepUntil(3, 10);
+  agenda.SleepUntil(4, 2);
+  agenda.Wake(4);
+
+  std::vector<int> woken;
+  agenda.Advance(2, &woken);
+  EXPECT_TRUE(woken.empty());
+  agenda.Advance(5, &woken);
+  EXPECT_EQ(std::vector<int>({1, 2}), woken);
+  EXPECT_EQ(1, agenda.sleeping());
+  EXPECT_FALSE(agenda.Due(3, 9));
+
+  woken.clear();
+  agenda.Advance(20, &woken);
+  EXPECT_EQ(std::vector<int>({3}), woken);
+  EXPECT_EQ(0, agenda.sleeping());
+}
+
+}  // namespace setup
+}  // namespace games
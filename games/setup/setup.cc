@@ -3,7 +3,13 @@
 // TODO: Upgrade to C++17
 #define _SILENCE_EXPERIMENTAL_FILESYSTEM_DEPRECATION_WARNING
 #include <experimental/filesystem>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
+#include "games/actions/plan.h"
 #include "games/actions/strategy.h"
 #include "games/factions/proto/factions.pb.h"
 #include "games/geography/connection.h"
@@ -14,13 +20,150 @@
 #include "games/setup/validation/validation.h"
 #include "games/units/unit.h"
 #include "util/arithmetic/microunits.h"
+#include "util/headers/int_types.h"
 #include "util/keywords/keywords.h"
 #include "util/logging/logging.h"
 #include "util/proto/file.h"
 #include "util/status/status.h"
+#include "util/threads/parallel.h"
 
 namespace games {
 namespace setup {
+namespace {
+
+// Changed whenever the cache layout, or what goes into a cache key, changes,
+// so that old caches are ignored.
+constexpr uint64 kCacheVersion = 1;
+
+// A text-format file to be parsed into part of a proto.
+struct Input {
+  std::string filename;
+  std::string text;
+};
+
+// Adds the files in filenames, relative to the root path of config.
+void addInputs(const proto::ScenarioFiles& config,
+               const google::protobuf::RepeatedPtrField<std::string>& filenames,
+               std::vector<Input>* inputs) {
+  std::experimental::filesystem::path base_path = config.root_path();
+  for (const auto& filename : filenames) {
+    inputs->push_back({(base_path / filename).string(), ""});
+  }
+}
+
+// Reads the text of each input, several at a time.
+util::Status readInputs(std::vector<Input>* inputs) {
+  std::vector<util::Status> statuses(inputs->size());
+  threads::ParallelFor(inputs->size(), [inputs, &statuses](int i) {
+    auto& input = (*inputs)[i];
+    statuses[i] = util::proto::ReadFile(input.filename, &input.text);
+  });
+  for (const auto& status : statuses) {
+    if (!status.ok()) {
+      return status;
+    }
+  }
+  return util::OkStatus();
+}
+
+// Parses each input into a proto of its own, several at a time, then merges
+// them into proto in order. This gives the same result as merging the files
+// into proto one after another.
+util::Status parseInputs(const std::vector<Input>& inputs,
+                         google::protobuf::Message* proto) {
+  std::vector<std::unique_ptr<google::protobuf::Message>> parts(inputs.size());
+  std::vector<util::Status> statuses(inputs.size());
+  threads::ParallelFor(inputs.size(), [&](int i) {
+    parts[i].reset(proto->New());
+    statuses[i] = util::proto::MergeProtoText(inputs[i].text,
+                                              inputs[i].filename,
+                                              parts[i].get());
+  });
+  for (int i = 0; i < inputs.size(); ++i) {
+    if (!statuses[i].ok()) {
+      return statuses[i];
+    }
+    proto->MergeFrom(*parts[i]);
+  }
+  return util::OkStatus();
+}
+
+// 64-bit FNV-1a, which unlike std::hash is the same in every build.
+void hashBytes(const std::string& bytes, uint64* hash) {
+  for (const unsigned char byte : bytes) {
+    *hash ^= byte;
+    *hash *= 1099511628211ull;
+  }
+}
+
+// Hashes the definition of file and, depth first, of every file it imports,
+// each once.
+void hashProtoFile(const google::protobuf::FileDescriptor& file,
+                   std::unordered_set<std::string>* seen, uint64* hash) {
+  if (!seen->insert(file.name()).second) {
+    return;
+  }
+  for (int i = 0; i < file.dependency_count(); ++i) {
+    hashProtoFile(*file.dependency(i), seen, hash);
+  }
+  hashBytes(file.DebugString(), hash);
+}
+
+// Returns a key that changes if any input's name or text changes, or the
+// definition of the proto they are parsed into or of any message it uses.
+uint64 inputKey(const std::vector<Input>& inputs,
+                const google::protobuf::Descriptor& type) {
+  uint64 hash = 14695981039346656037ull;
+  hashBytes(std::to_string(kCacheVersion), &hash);
+  std::unordered_set<std::string> seen;
+  hashProtoFile(*type.file(), &seen, &hash);
+  for (const auto& input : inputs) {
+    // Sizes first, so that moving text from one file to the next counts as a
+    // change.
+    hashBytes(std::to_string(input.filename.size()), &hash);
+    hashBytes(input.filename, &hash);
+    hashBytes(std::to_string(input.text.size()), &hash);
+    hashBytes(input.text, &hash);
+  }
+  return hash;
+}
+
+std::string cachePath(const proto::ScenarioFiles& config) {
+  // The filesystem TS appends absolute paths rather than replacing the base.
+  std::experimental::filesystem::path cache_path = config.compiled_cache();
+  if (cache_path.is_absolute()) {
+    return cache_path.string();
+  }
+  std::experimental::filesystem::path base_path = config.root_path();
+  return (base_path / cache_path).string();
+}
+
+// Reads the cache at path into cache, leaving it empty if there is none or
+// it cannot be read; the caller then parses the text files instead.
+void readCache(const std::string& path, proto::CompiledScenario* cache) {
+  if (!std::experimental::filesystem::exists(path)) {
+    return;
+  }
+  std::string contents;
+  auto status = util::proto::ReadFile(path, &contents);
+  if (!status.ok() || !cache->ParseFromString(contents)) {
+    Log::Warnf("Ignoring unreadable scenario cache %s", path);
+    cache->Clear();
+  }
+}
+
+// Writes cache to path. Failing to is not an error, since the cache only
+// saves time.
+void writeCache(const std::string& path,
+                const proto::CompiledScenario& cache) {
+  auto status = util::proto::WriteFile(path, cache.SerializeAsString());
+  if (!status.ok()) {
+    Log::Warnf("Could not write scenario cache: %s", status.message());
+  }
+}
+
+} // namespace
+
 
 Constants::Constants(const games::setup::proto::Scenario& proto) {
   for (const auto& good : proto.trade_goods()) {
@@ -176,6 +319,9 @@ util::Status World::ToProto(proto::GameWorld* proto) {
     market::CleanContainer(unit->mutable_resources());
     auto& unit_proto = *proto->add_units();
     unit_proto = unit->Proto();
+    if (unit_proto.has_plan()) {
+      actions::CompactPlan(unit_proto.mutable_plan());
+    }
     if (unit_proto.has_faction_id()) {
       util::objectid::UnCanonicalise(unit_proto.mutable_faction_id());
     }
@@ -191,62 +337,70 @@ util::Status World::ToProto(proto::GameWorld* proto) {
 
 util::Status LoadScenario(const proto::ScenarioFiles& config,
                           proto::Scenario* scenario) {
-  std::experimental::filesystem::path base_path = config.root_path();
-  for (const auto& filename : config.auto_production()) {
-    std::experimental::filesystem::path full_path = base_path / filename;
-    auto status = util::proto::MergeProtoFile(full_path.string(), scenario);
-    if (!status.ok()) {
-      return status;
-    }
-  }
-  for (const auto& filename : config.production_chains()) {
-    std::experimental::filesystem::path full_path = base_path / filename;
-    auto status = util::proto::MergeProtoFile(full_path.string(), scenario);
-    if (!status.ok()) {
-      return status;
-    }
+  std::vector<Input> inputs;
+  addInputs(config, config.auto_production(), &inputs);
+  addInputs(config, config.production_chains(), &inputs);
+  addInputs(config, config.trade_goods(), &inputs);
+  addInputs(config, config.consumption(), &inputs);
+  addInputs(config, config.unit_templates(), &inputs);
+  auto status = readInputs(&inputs);
+  if (!status.ok()) {
+    return status;
   }
-  for (const auto& filename : config.trade_goods()) {
-    std::experimental::filesystem::path full_path = base_path / filename;
-    auto status = util::proto::MergeProtoFile(full_path.string(), scenario);
-    if (!status.ok()) {
-      return status;
-    }
+  if (!config.has_compiled_cache()) {
+    return parseInputs(inputs, scenario);
   }
-  for (const auto& filename : config.consumption()) {
-    std::experimental::filesystem::path full_path = base_path / filename;
-    auto status = util::proto::MergeProtoFile(full_path.string(), scenario);
-    if (!status.ok()) {
-      return status;
-    }
+
+  const std::string cache_path = cachePath(config);
+  const uint64 key = inputKey(inputs, *proto::Scenario::descriptor());
+  proto::CompiledScenario cache;
+  readCache(cache_path, &cache);
+  if (cache.has_scenario_key() && cache.scenario_key() == key) {
+    scenario->MergeFrom(cache.scenario());
+    return util::OkStatus();
   }
-  for (const auto& filename : config.unit_templates()) {
-    std::experimental::filesystem::path full_path = base_path / filename;
-    auto status = util::proto::MergeProtoFile(full_path.string(), scenario);
-    if (!status.ok()) {
-      return status;
-    }
+  proto::Scenario parsed;
+  status = parseInputs(inputs, &parsed);
+  if (!status.ok()) {
+    return status;
   }
+  scenario->MergeFrom(parsed);
+  *cache.mutable_scenario() = std::move(parsed);
+  cache.set_scenario_key(key);
+  writeCache(cache_path, cache);
   return util::OkStatus();
 }
 
 util::Status LoadWorld(const proto::ScenarioFiles& config,
                        proto::GameWorld* world) {
+  world->Clear();
   std::experimental::filesystem::path base_path = config.root_path();
-  std::experimental::filesystem::path world_path =
-      base_path / config.world_file();
-  auto status = util::proto::ParseProtoFile(world_path.string(), world);
+  std::vector<Input> inputs;
+  inputs.push_back({(base_path / config.world_file()).string(), ""});
+  addInputs(config, config.factions(), &inputs);
+  auto status = readInputs(&inputs);
   if (!status.ok()) {
     return status;
   }
-  for (const auto& filename : config.factions()) {
-    std::experimental::filesystem::path full_path = base_path / filename;
-    auto status = util::proto::MergeProtoFile(full_path.string(), world);
-    if (!status.ok()) {
-      return status;
-    }
+  if (!config.has_compiled_cache()) {
+    return parseInputs(inputs, world);
   }
 
+  const std::string cache_path = cachePath(config);
+  const uint64 key = inputKey(inputs, *proto::GameWorld::descriptor());
+  proto::CompiledScenario cache;
+  readCache(cache_path, &cache);
+  if (cache.has_world_key() && cache.world_key() == key) {
+    *world = cache.world();
+    return util::OkStatus();
+  }
+  status = parseInputs(inputs, world);
+  if (!status.ok()) {
+    return status;
+  }
+  *cache.mutable_world() = *world;
+  cache.set_world_key(key);
+  writeCache(cache_path, cache);
   return util::OkStatus();
 }
 
@@ -255,6 +409,7 @@ LoadExtras(const proto::ScenarioFiles& config,
            std::unordered_map<std::string, google::protobuf::Message*> extras) {
   std::experimental::filesystem::path base_path = config.root_path();
   const auto& locations = config.extras();
+  std::vector<std::pair<std::string, google::protobuf::Message*>> found;
   for (auto& extra : extras) {
     const std::string& key = extra.first;
     if (locations.find(key) == locations.end()) {
@@ -265,8 +420,16 @@ LoadExtras(const proto::ScenarioFiles& config,
     }
     std::experimental::filesystem::path extra_path =
         base_path / locations.at(key);
-    auto status =
-        util::proto::MergeProtoFile(extra_path.string(), extra.second);
+    found.emplace_back(extra_path.string(), extra.second);
+  }
+
+  // Each extra has its own proto, so they can be parsed at the same time.
+  std::vector<util::Status> statuses(found.size());
+  threads::ParallelFor(found.size(), [&found, &statuses](int i) {
+    statuses[i] =
+        util::proto::MergeProtoFile(found[i].first, found[i].second);
+  });
+  for (const auto& status : statuses) {
     if (!status.ok()) {
       return status;
     }
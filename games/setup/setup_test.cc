@@ -1,9 +1,14 @@
 #include "games/setup/setup.h"
 
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
 #include "absl/strings/str_join.h"
 #include "gtest/gtest.h"
 #include "src/google/protobuf/util/message_differencer.h"
 #include "util/logging/logging.h"
+#include "util/proto/file.h"
 
 const std::string kTestDataLocation = "games/setup/test_data";
 const std::string kWorld = "world.pb.txt";
@@ -199,3 +204,72 @@ TEST(SetupTest, TestLoadExtras) {
   EXPECT_TRUE(status.ok()) << status.ToString();
   EXPECT_GT(scenario.production_chains().size(), 0);
 }
+
+TEST(SetupTest, TestCompiledCache) {
+  games::setup::proto::ScenarioFiles config;
+  google::protobuf::util::MessageDifferencer differ;
+  const std::string kTestDir = std::getenv("TEST_SRCDIR");
+  const std::string kWorkdir = std::getenv("TEST_WORKSPACE");
+
+  const std::string kBase =
+      absl::StrJoin({kTestDir, kWorkdir, kTestDataLocation}, "/");
+  config.set_root_path(kBase);
+  config.add_auto_production(kAutoProd);
+  config.add_production_chains(kChains);
+  config.add_trade_goods(kTradeGoods);
+  config.add_consumption(kConsumption);
+  config.add_unit_templates(kUnits);
+  config.set_world_file(kWorld);
+
+  games::setup::proto::Scenario parsed;
+  auto status = games::setup::LoadScenario(config, &parsed);
+  ASSERT_TRUE(status.ok()) << status.ToString();
+  games::setup::proto::GameWorld parsed_world;
+  status = games::setup::LoadWorld(config, &parsed_world);
+  ASSERT_TRUE(status.ok()) << status.ToString();
+
+  // The test data is read-only, so the cache goes elsewhere.
+  const char* tmp = std::getenv("TEST_TMPDIR");
+  const std::string cache =
+      std::string(tmp == nullptr ? "/tmp" : tmp) + "/setup_test.cache";
+  std::remove(cache.c_str());
+  config.set_compiled_cache(cache);
+
+  // First to write the cache, then to read it.
+  for (int i = 0; i < 2; ++i) {
+    games::setup::proto::Scenario scenario;
+    status = games::setup::LoadScenario(config, &scenario);
+    EXPECT_TRUE(status.ok()) << status.ToString();
+    EXPECT_TRUE(differ.Equals(parsed, scenario))
+        << parsed.DebugString() << "\n\ndiffers from\n"
+        << scenario.DebugString();
+    games::setup::proto::GameWorld world;
+    status = games::setup::LoadWorld(config, &world);
+    EXPECT_TRUE(status.ok()) << status.ToString();
+    EXPECT_TRUE(differ.Equals(parsed_world, world))
+        << parsed_world.DebugString() << "\n\ndiffers from\n"
+        << world.DebugString();
+  }
+
+  games::setup::proto::CompiledScenario compiled;
+  status = util::proto::ParseProtoFile(cache, &compiled);
+  EXPECT_FALSE(status.ok()) << "Cache should be binary, not text";
+  std::ifstream input(cache, std::ios::binary);
+  ASSERT_TRUE(compiled.ParseFromIstream(&input));
+  EXPECT_TRUE(compiled.has_scenario_key());
+  EXPECT_TRUE(compiled.has_world_key());
+  EXPECT_NE(compiled.scenario_key(), compiled.world_key());
+
+  // A cache from other files is ignored, not used.
+  compiled.set_scenario_key(compiled.scenario_key() + 1);
+  compiled.mutable_scenario()->clear_production_chains();
+  {
+    std::ofstream output(cache, std::ios::binary | std::ios::trunc);
+    ASSERT_TRUE(compiled.SerializeToOstream(&output));
+  }
+  games::setup::proto::Scenario scenario;
+  status = games::setup::LoadScenario(config, &scenario);
+  EXPECT_TRUE(status.ok()) << status.ToString();
+  EXPECT_TRUE(differ.Equals(parsed, scenario));
+  std::remove(cache.c_str());
+}
@@ -6,19 +6,24 @@
 
 #include "absl/strings/substitute.h"
 #include "games/market/proto/goods.pb.h"
+#include "util/context/context.h"
 #include "util/headers/int_types.h"
 #include "util/proto/object_id.h"
 
-std::unordered_map<std::string, market::proto::TradeGood> goods;
-std::unordered_map<util::proto::ObjectId, geography::proto::Area> areas;
-std::unordered_map<uint64, units::proto::Template> templates;
-std::unordered_map<std::string, units::proto::Template> template_map;
-std::unordered_map<util::proto::ObjectId, geography::proto::Connection>
+// Scratch space for one call to Validate; per thread, so that simulations on
+// different threads can load at the same time.
+thread_local std::unordered_map<std::string, market::proto::TradeGood> goods;
+thread_local std::unordered_map<util::proto::ObjectId, geography::proto::Area>
+    areas;
+thread_local std::unordered_map<uint64, units::proto::Template> templates;
+thread_local std::unordered_map<std::string, units::proto::Template>
+    template_map;
+thread_local std::unordered_map<util::proto::ObjectId,
+                                geography::proto::Connection>
     connections;
-std::unordered_map<uint64, population::proto::PopUnit> pops;
-std::unordered_map<util::proto::ObjectId, units::proto::Unit> unit_map;
-std::unordered_map<std::string, games::setup::validation::Validator>
-    validator_map;
+thread_local std::unordered_map<uint64, population::proto::PopUnit> pops;
+thread_local std::unordered_map<util::proto::ObjectId, units::proto::Unit>
+    unit_map;
 
 namespace games {
 namespace setup {
@@ -328,6 +333,15 @@ void validateUnits(const games::setup::proto::GameWorld& world,
   }
 }
 
+// Validators registered in one simulation context.
+struct Validators {
+  std::unordered_map<std::string, Validator> validator_map;
+};
+
+std::unordered_map<std::string, Validator>& validatorMap() {
+  return util::Context::Current().Get<Validators>().validator_map;
+}
+
 void clear() {
   goods.clear();
   areas.clear();
@@ -341,7 +355,7 @@ void clear() {
 } // namespace
 
 void RegisterValidator(const std::string& key, Validator v) {
-  validator_map[key] = v;
+  validatorMap()[key] = v;
 }
 
 std::vector<std::string> Validate(const games::setup::proto::Scenario& scenario,
@@ -359,7 +373,7 @@ std::vector<std::string> Validate(const games::setup::proto::Scenario& scenario,
   validateConnections(world, &errors);
   validateUnits(world, &errors);
 
-  for (const auto& it : validator_map) {
+  for (const auto& it : validatorMap()) {
     const auto& key = it.first;
     auto extra_errors = it.second(world);
     for (const auto& extra : extra_errors) {
@@ -1,5 +1,6 @@
 #include "games/sevenyears/ai_state_handlers.h"
 
+#include "games/actions/plan.h"
 #include "games/actions/proto/plan.pb.h"
 #include "games/ai/executer.h"
 #include "games/ai/impl/ai_utils.h"
@@ -42,7 +43,7 @@ void CreateExpectedArrivals(const units::Unit& unit,
   micro::uMeasure current_action_points_u = unit.action_points_u();
   market::proto::Container projected_cargo;
   market::Copy(unit.resources(), unit.resources(), &projected_cargo);
-  for (int idx = 0; idx < plan.steps_size(); ++idx) {
+  for (int idx = plan.next_step(); idx < plan.steps_size(); ++idx) {
     // Special case for movement.
     std::vector<geography::Connection::IdType> path_ids;
     while (idx < plan.steps_size() &&
@@ -82,11 +83,13 @@ void CreateExpectedArrivals(const units::Unit& unit,
             break;
           }
           auto* state = world_state->mutable_area_state(current_area_id);
-          auto* lfi = FindLocalFactionInfo(faction_id, state);
-          auto* arrival = lfi->add_arrivals();
-          arrival->set_timestamp(expected_time);
-          *arrival->mutable_cargo() << projected_cargo;
-          *arrival->mutable_unit_id() = unit.unit_id();
+          FindLocalFactionInfo(faction_id, state);
+          proto::ExpectedArrival arrival;
+          arrival.set_timestamp(expected_time);
+          *arrival.mutable_cargo() << projected_cargo;
+          *arrival.mutable_unit_id() = unit.unit_id();
+          world_state->mutable_arrivals()->Add(current_area_id, faction_id,
+                                               arrival);
         } else if (step.key() == constants::LoadShip()) {
           auto good = step.good();
           if (good.empty()) {
@@ -111,23 +114,9 @@ void RegisterArrival(const units::Unit& unit,
   }
   auto* state = world_state->mutable_area_state(area_id);
   const util::proto::ObjectId& faction_id = unit.faction_id();
-  auto* lfi = FindLocalFactionInfo(faction_id, state);
-  const util::proto::ObjectId& unit_id = unit.unit_id();
-  auto* arrivals = lfi->mutable_arrivals();
-
-  for (auto& curr = arrivals->begin(); curr != arrivals->end(); ++curr) {
-    if (curr->unit_id() != unit_id) {
-      continue;
-    }
-    if (loaded >= curr->cargo()) {
-      curr = arrivals->erase(curr);
-    } else {
-      *(curr->mutable_cargo()) =
-          market::SubtractFloor(curr->cargo(), loaded, 0);
-    }
-    // Affects only the first expected arrival.
-    break;
-  }
+  FindLocalFactionInfo(faction_id, state);
+  world_state->mutable_arrivals()->Register(area_id, faction_id,
+                                            unit.unit_id(), loaded);
 }
 
 } // namespace sevenyears
@@ -10,7 +10,8 @@
 
 namespace sevenyears {
 
-// Creates ExpectedArrival objects in ports the unit plans to arrive at.
+// Adds ExpectedArrival objects to the calendar for the ports the unit plans to
+// arrive at.
 void CreateExpectedArrivals(const units::Unit& unit,
                             const actions::proto::Plan& plan,
                             SevenYearsState* world_state);
@@ -106,7 +106,7 @@ TEST_F(SevenYearsMerchantTest, TestEuropeanTrade) {
   for (auto& unit : world_state_->World().units_) {
     CreateExpectedArrivals(*unit, unit->plan(), world_state_.get());
   }
-  CheckAreaStatesForStage(*world_state_, golds, 0);
+  CheckAreaStatesForStage(world_state_.get(), golds, 0);
 
   for (auto& unit : world_state_->World().units_) {
     util::proto::ObjectId area_id = unit->location().a_area_id();
@@ -123,7 +123,7 @@ TEST_F(SevenYearsMerchantTest, TestEuropeanTrade) {
       }
     }
   }
-  CheckAreaStatesForStage(*world_state_, golds, 1);
+  CheckAreaStatesForStage(world_state_.get(), golds, 1);
 }
 
 TEST_F(SevenYearsMerchantTest, TestRegisterArrival) {
@@ -140,7 +140,7 @@ TEST_F(SevenYearsMerchantTest, TestRegisterArrival) {
     util::proto::ObjectId area_id = unit->location().z_area_id();
     RegisterArrival(*unit, area_id, unit->resources(), world_state_.get());
   }
-  CheckAreaStatesForStage(*world_state_, golds, 0);
+  CheckAreaStatesForStage(world_state_.get(), golds, 0);
 }
 
 }  // namespace sevenyears
@@ -1,5 +1,6 @@
 #include "games/sevenyears/army_ai.h"
 
+#include "games/actions/plan.h"
 #include "games/ai/planner.h"
 
 namespace sevenyears {
@@ -11,7 +12,7 @@ SevenYearsArmyAi::AddStepsToPlan(const units::Unit& unit,
   if (!strategy.has_seven_years_army()) {
     return util::NotFoundError("No SevenYearsArmy strategy");
   }
-  if (plan->steps_size() > 0) {
+  if (actions::StepsLeft(*plan) > 0) {
     return util::OkStatus();
   }
 
@@ -0,0 +1,256 @@
+#include "games/sevenyears/arrival_calendar.h"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+#include "games/market/goods_utils.h"
+
+namespace sevenyears {
+
+constexpr int ArrivalCalendar::kSlots;
+
+void ArrivalCalendar::add(const proto::ExpectedArrival& arrival, Lane* lane) {
+  int index;
+  if (lane->free_entries.empty()) {
+    index = lane->entries.size();
+    lane->entries.emplace_back();
+  } else {
+    index = lane->free_entries.back();
+    lane->free_entries.pop_back();
+  }
+  Entry& entry = lane->entries[index];
+  entry.arrival = arrival;
+  entry.sequence = next_sequence_++;
+  entry.live = true;
+
+  const uint64 timestamp = arrival.timestamp();
+  auto& bucket = lane->wheel[timestamp % kSlots];
+  entry.bucket_index = bucket.size();
+  bucket.push_back(index);
+  lane->by_unit[arrival.unit_id()].push_back(index);
+  if (lane->live == 0 || timestamp < lane->earliest) {
+    lane->earliest = timestamp;
+  }
+  lane->live++;
+}
+
+void ArrivalCalendar::remove(int index, Lane* lane) {
+  Entry& entry = lane->entries[index];
+  const uint64 timestamp = entry.arrival.timestamp();
+  auto& bucket = lane->wheel[timestamp % kSlots];
+  const int moved = bucket.back();
+  bucket[entry.bucket_index] = moved;
+  lane->entries[moved].bucket_index = entry.bucket_index;
+  bucket.pop_back();
+
+  entry.live = false;
+  entry.arrival.Clear();
+  lane->free_entries.push_back(index);
+  lane->live--;
+  if (lane->live > 0 && timestamp == lane->earliest) {
+    advance(lane);
+  }
+}
+
+void ArrivalCalendar::advance(Lane* lane) {
+  // Usually the next arrival is within a turn of the wheel.
+  const uint64 limit = lane->earliest + kSlots;
+  for (uint64 time = lane->earliest; time < limit; ++time) {
+    for (int index : lane->wheel[time % kSlots]) {
+      if (lane->entries[index].arrival.timestamp() == time) {
+        lane->earliest = time;
+        return;
+      }
+    }
+  }
+
+  uint64 earliest = std::numeric_limits<uint64>::max();
+  for (const auto& bucket : lane->wheel) {
+    for (int index : bucket) {
+      earliest = std::min(earliest, lane->entries[index].arrival.timestamp());
+    }
+  }
+  lane->earliest = earliest;
+}
+
+void ArrivalCalendar::Add(const util::proto::ObjectId& area_id,
+                          const util::proto::ObjectId& faction_id,
+                          const proto::ExpectedArrival& arrival) {
+  auto& area = areas_[area_id];
+  add(arrival, &area.factions[faction_id]);
+  area.dirty = true;
+}
+
+void ArrivalCalendar::Register(const util::proto::ObjectId& area_id,
+                               const util::proto::ObjectId& faction_id,
+                               const util::proto::ObjectId& unit_id,
+                               const market::proto::Container& loaded) {
+  auto area = areas_.find(area_id);
+  if (area == areas_.end()) {
+    return;
+  }
+  auto lane = area->second.factions.find(faction_id);
+  if (lane == area->second.factions.end()) {
+    return;
+  }
+  auto unit = lane->second.by_unit.find(unit_id);
+  if (unit == lane->second.by_unit.end() || unit->second.empty()) {
+    return;
+  }
+
+  const int index = unit->second.front();
+  auto& arrival = lane->second.entries[index].arrival;
+  if (loaded >= arrival.cargo()) {
+    unit->second.pop_front();
+    if (unit->second.empty()) {
+      lane->second.by_unit.erase(unit);
+    }
+    remove(index, &lane->second);
+  } else {
+    *arrival.mutable_cargo() = market::SubtractFloor(arrival.cargo(), loaded, 0);
+  }
+  area->second.dirty = true;
+}
+
+const ArrivalCalendar::Lane*
+ArrivalCalendar::findLane(const util::proto::ObjectId& area_id,
+                          const util::proto::ObjectId& faction_id) const {
+  auto area = areas_.find(area_id);
+  if (area == areas_.end()) {
+    return nullptr;
+  }
+  auto lane = area->second.factions.find(faction_id);
+  if (lane == area->second.factions.end()) {
+    return nullptr;
+  }
+  return &lane->second;
+}
+
+micro::Measure ArrivalCalendar::Expected(
+    const util::proto::ObjectId& area_id,
+    const util::proto::ObjectId& faction_id, const std::string& good,
+    uint64 timestamp) const {
+  const Lane* lane = findLane(area_id, faction_id);
+  if (lane == nullptr || lane->live == 0 || timestamp < lane->earliest) {
+    return 0;
+  }
+
+  micro::Measure amount = 0;
+  if (timestamp - lane->earliest < kSlots) {
+    // Each bucket in the window holds exactly one of the timestamps asked
+    // about, plus possibly later ones that wrapped around.
+    for (uint64 time = lane->earliest; time <= timestamp; ++time) {
+      for (int index : lane->wheel[time % kSlots]) {
+        const auto& arrival = lane->entries[index].arrival;
+        if (arrival.timestamp() != time) {
+          continue;
+        }
+        amount += market::GetAmount(arrival.cargo(), good);
+      }
+    }
+    return amount;
+  }
+
+  for (const auto& bucket : lane->wheel) {
+    for (int index : bucket) {
+      const auto& arrival = lane->entries[index].arrival;
+      if (arrival.timestamp() > timestamp) {
+        continue;
+      }
+      amount += market::GetAmount(arrival.cargo(), good);
+    }
+  }
+  return amount;
+}
+
+uint64 ArrivalCalendar::earliest(
+    const util::proto::ObjectId& area_id,
+    const util::proto::ObjectId& faction_id) const {
+  const Lane* lane = findLane(area_id, faction_id);
+  if (lane == nullptr || lane->live == 0) {
+    return 0;
+  }
+  return lane->earliest;
+}
+
+int ArrivalCalendar::size(const util::proto::ObjectId& area_id,
+                          const util::proto::ObjectId& faction_id) const {
+  const Lane* lane = findLane(area_id, faction_id);
+  if (lane == nullptr) {
+    return 0;
+  }
+  return lane->live;
+}
+
+void ArrivalCalendar::Load(const proto::AreaState& state) {
+  auto& area = areas_[state.area_id()];
+  area.factions.clear();
+  area.dirty = false;
+  for (const auto& lfi : state.factions()) {
+    if (lfi.arrivals_size() == 0) {
+      continue;
+    }
+    auto& lane = area.factions[lfi.faction_id()];
+    for (const auto& arrival : lfi.arrivals()) {
+      add(arrival, &lane);
+    }
+  }
+}
+
+bool ArrivalCalendar::Dirty(const util::proto::ObjectId& area_id) const {
+  auto area = areas_.find(area_id);
+  if (area == areas_.end()) {
+    return false;
+  }
+  return area->second.dirty;
+}
+
+void ArrivalCalendar::Store(proto::AreaState* state) {
+  auto area = areas_.find(state->area_id());
+  if (area == areas_.end()) {
+    return;
+  }
+  auto& factions = area->second.factions;
+  for (auto& lfi : *state->mutable_factions()) {
+    lfi.clear_arrivals();
+  }
+
+  std::vector<const Entry*> live;
+  for (const auto& lane : factions) {
+    if (lane.second.live == 0) {
+      continue;
+    }
+    proto::LocalFactionInfo* lfi = nullptr;
+    for (auto& cand : *state->mutable_factions()) {
+      if (cand.faction_id() == lane.first) {
+        lfi = &cand;
+        break;
+      }
+    }
+    if (lfi == nullptr) {
+      lfi = state->add_factions();
+      *lfi->mutable_faction_id() = lane.first;
+    }
+
+    live.clear();
+    for (const auto& entry : lane.second.entries) {
+      if (entry.live) {
+        live.push_back(&entry);
+      }
+    }
+    std::sort(live.begin(), live.end(), [](const Entry* a, const Entry* b) {
+      return a->sequence < b->sequence;
+    });
+    for (const Entry* entry : live) {
+      *lfi->add_arrivals() = entry->arrival;
+    }
+  }
+  area->second.dirty = false;
+}
+
+void ArrivalCalendar::Clear() {
+  areas_.clear();
+}
+
+}  // namespace sevenyears
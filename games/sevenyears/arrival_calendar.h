@@ -0,0 +1,113 @@
+// Time-indexed store of expected cargo arrivals.
+#ifndef GAMES_SEVENYEARS_ARRIVAL_CALENDAR_H
+#define GAMES_SEVENYEARS_ARRIVAL_CALENDAR_H
+
+#include <array>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "games/market/proto/goods.pb.h"
+#include "games/sevenyears/proto/sevenyears.pb.h"
+#include "util/arithmetic/microunits.h"
+#include "util/headers/int_types.h"
+#include "util/proto/object_id.h"
+#include "util/proto/object_id.pb.h"
+
+namespace sevenyears {
+
+// Working copy of the ExpectedArrival lists in LocalFactionInfo, indexed by
+// area and faction, by unit, and by timestamp. Each (area, faction) pair has
+// a timing wheel of kSlots buckets, so that adding an arrival, removing the
+// next arrival of a unit, and summing the cargo due within a few turns do not
+// walk the whole list. The protos are only rewritten by Store.
+class ArrivalCalendar {
+public:
+  ArrivalCalendar() : next_sequence_(0) {}
+
+  // Adds an expected arrival for the faction in the area.
+  void Add(const util::proto::ObjectId& area_id,
+           const util::proto::ObjectId& faction_id,
+           const proto::ExpectedArrival& arrival);
+
+  // Applies cargo the unit actually delivered to its first expected arrival
+  // for the faction in the area, removing the arrival if loaded covers it and
+  // reducing it otherwise.
+  void Register(const util::proto::ObjectId& area_id,
+                const util::proto::ObjectId& faction_id,
+                const util::proto::ObjectId& unit_id,
+                const market::proto::Container& loaded);
+
+  // Returns the amount of good expected to arrive for the faction in the area
+  // at or before timestamp.
+  micro::Measure Expected(const util::proto::ObjectId& area_id,
+                          const util::proto::ObjectId& faction_id,
+                          const std::string& good, uint64 timestamp) const;
+
+  // Returns the timestamp of the earliest expected arrival for the faction in
+  // the area, or zero if there is none.
+  uint64 earliest(const util::proto::ObjectId& area_id,
+                  const util::proto::ObjectId& faction_id) const;
+
+  // Returns the number of expected arrivals for the faction in the area.
+  int size(const util::proto::ObjectId& area_id,
+           const util::proto::ObjectId& faction_id) const;
+
+  // Replaces the arrivals for the area with those in state.
+  void Load(const proto::AreaState& state);
+
+  // Returns true if the arrivals for the area have changed since it was last
+  // loaded or stored.
+  bool Dirty(const util::proto::ObjectId& area_id) const;
+
+  // Writes the arrivals for the area into state, in the order they were
+  // added.
+  void Store(proto::AreaState* state);
+
+  void Clear();
+
+private:
+  static constexpr int kSlots = 64;
+
+  struct Entry {
+    proto::ExpectedArrival arrival;
+    uint64 sequence;
+    // Position in the wheel bucket, for constant-time removal.
+    int bucket_index;
+    bool live;
+  };
+
+  struct Lane {
+    Lane() : earliest(0), live(0) {}
+    std::vector<Entry> entries;
+    std::vector<int> free_entries;
+    std::array<std::vector<int>, kSlots> wheel;
+    // Live entries of each unit, in the order they were added.
+    std::unordered_map<util::proto::ObjectId, std::deque<int>> by_unit;
+    // Timestamp of the earliest live entry.
+    uint64 earliest;
+    int live;
+  };
+
+  struct AreaLanes {
+    AreaLanes() : dirty(false) {}
+    std::unordered_map<util::proto::ObjectId, Lane> factions;
+    bool dirty;
+  };
+
+  const Lane* findLane(const util::proto::ObjectId& area_id,
+                       const util::proto::ObjectId& faction_id) const;
+  void add(const proto::ExpectedArrival& arrival, Lane* lane);
+  void remove(int index, Lane* lane);
+  // Moves earliest forward to the earliest live entry, after the entry it
+  // pointed at has been removed.
+  void advance(Lane* lane);
+
+  std::unordered_map<util::proto::ObjectId, AreaLanes> areas_;
+  uint64 next_sequence_;
+};
+
+}  // namespace sevenyears
+
+#endif
@@ -0,0 +1,146 @@
+#include "games/sevenyears/arrival_calendar.h"
+
+#include "games/market/goods_utils.h"
+#include "games/sevenyears/proto/sevenyears.pb.h"
+#include "gtest/gtest.h"
+#include "util/proto/object_id.h"
+
+namespace sevenyears {
+namespace {
+constexpr char kSupplies[] = "supplies";
+
+proto::ExpectedArrival makeArrival(int unit, uint64 timestamp,
+                                   micro::Measure amount) {
+  proto::ExpectedArrival arrival;
+  arrival.set_timestamp(timestamp);
+  *arrival.mutable_unit_id() = util::objectid::New("unit", unit);
+  market::SetAmount(kSupplies, amount, arrival.mutable_cargo());
+  return arrival;
+}
+
+} // namespace
+
+class ArrivalCalendarTest : public testing::Test {
+protected:
+  void SetUp() override {
+    area_id_ = util::objectid::New("area", 1);
+    faction_id_ = util::objectid::New("faction", 1);
+  }
+
+  micro::Measure expected(uint64 timestamp) {
+    return calendar_.Expected(area_id_, faction_id_, kSupplies, timestamp);
+  }
+
+  ArrivalCalendar calendar_;
+  util::proto::ObjectId area_id_;
+  util::proto::ObjectId faction_id_;
+};
+
+TEST_F(ArrivalCalendarTest, Expected) {
+  calendar_.Add(area_id_, faction_id_, makeArrival(1, 3, 10));
+  calendar_.Add(area_id_, faction_id_, makeArrival(2, 5, 20));
+  // Same bucket as timestamp 3.
+  calendar_.Add(area_id_, faction_id_, makeArrival(3, 67, 40));
+  EXPECT_EQ(3, calendar_.size(area_id_, faction_id_));
+
+  EXPECT_EQ(0, expected(2));
+  EXPECT_EQ(10, expected(3));
+  EXPECT_EQ(30, expected(10));
+  EXPECT_EQ(30, expected(66));
+  EXPECT_EQ(70, expected(67));
+  EXPECT_EQ(70, expected(1000));
+  EXPECT_EQ(0, calendar_.Expected(area_id_, faction_id_, "wool", 1000));
+  EXPECT_EQ(0, calendar_.Expected(util::objectid::New("area", 2), faction_id_,
+                                  kSupplies, 1000));
+}
+
+TEST_F(ArrivalCalendarTest, Register) {
+  calendar_.Add(area_id_, faction_id_, makeArrival(1, 3, 10));
+  calendar_.Add(area_id_, faction_id_, makeArrival(1, 8, 15));
+  calendar_.Add(area_id_, faction_id_, makeArrival(2, 4, 20));
+  const auto unit_id = util::objectid::New("unit", 1);
+
+  // Partial delivery reduces the first arrival only.
+  market::proto::Container loaded;
+  market::SetAmount(kSupplies, 4, &loaded);
+  calendar_.Register(area_id_, faction_id_, unit_id, loaded);
+  EXPECT_EQ(3, calendar_.size(area_id_, faction_id_));
+  EXPECT_EQ(6, expected(3));
+
+  market::SetAmount(kSupplies, 6, &loaded);
+  calendar_.Register(area_id_, faction_id_, unit_id, loaded);
+  EXPECT_EQ(2, calendar_.size(area_id_, faction_id_));
+  EXPECT_EQ(0, expected(3));
+  EXPECT_EQ(35, expected(8));
+
+  // Unknown units and areas are ignored.
+  calendar_.Register(area_id_, faction_id_, util::objectid::New("unit", 9),
+                     loaded);
+  calendar_.Register(util::objectid::New("area", 2), faction_id_, unit_id,
+                     loaded);
+  EXPECT_EQ(2, calendar_.size(area_id_, faction_id_));
+}
+
+TEST_F(ArrivalCalendarTest, EarliestAdvances) {
+  calendar_.Add(area_id_, faction_id_, makeArrival(1, 3, 10));
+  calendar_.Add(area_id_, faction_id_, makeArrival(2, 5, 20));
+  calendar_.Add(area_id_, faction_id_, makeArrival(3, 200, 40));
+  EXPECT_EQ(3, calendar_.earliest(area_id_, faction_id_));
+
+  market::proto::Container loaded;
+  market::SetAmount(kSupplies, 100, &loaded);
+  calendar_.Register(area_id_, faction_id_, util::objectid::New("unit", 1),
+                     loaded);
+  EXPECT_EQ(5, calendar_.earliest(area_id_, faction_id_));
+  EXPECT_EQ(20, expected(5));
+
+  // The next arrival is more than a turn of the wheel away.
+  calendar_.Register(area_id_, faction_id_, util::objectid::New("unit", 2),
+                     loaded);
+  EXPECT_EQ(200, calendar_.earliest(area_id_, faction_id_));
+  EXPECT_EQ(0, expected(199));
+  EXPECT_EQ(40, expected(200));
+
+  calendar_.Register(area_id_, faction_id_, util::objectid::New("unit", 3),
+                     loaded);
+  EXPECT_EQ(0, calendar_.earliest(area_id_, faction_id_));
+  calendar_.Add(area_id_, faction_id_, makeArrival(4, 300, 1));
+  EXPECT_EQ(300, calendar_.earliest(area_id_, faction_id_));
+}
+
+TEST_F(ArrivalCalendarTest, LoadAndStore) {
+  proto::AreaState state;
+  *state.mutable_area_id() = area_id_;
+  auto* lfi = state.add_factions();
+  *lfi->mutable_faction_id() = faction_id_;
+  *lfi->add_arrivals() = makeArrival(1, 5, 10);
+  *lfi->add_arrivals() = makeArrival(2, 2, 20);
+  calendar_.Load(state);
+  EXPECT_FALSE(calendar_.Dirty(area_id_));
+  EXPECT_EQ(20, expected(2));
+
+  calendar_.Add(area_id_, faction_id_, makeArrival(3, 1, 30));
+  market::proto::Container loaded;
+  market::SetAmount(kSupplies, 10, &loaded);
+  calendar_.Register(area_id_, faction_id_, util::objectid::New("unit", 1),
+                     loaded);
+  EXPECT_TRUE(calendar_.Dirty(area_id_));
+
+  calendar_.Store(&state);
+  EXPECT_FALSE(calendar_.Dirty(area_id_));
+  ASSERT_EQ(1, state.factions_size());
+  // Insertion order, not time order.
+  ASSERT_EQ(2, state.factions(0).arrivals_size());
+  EXPECT_EQ(2, state.factions(0).arrivals(0).timestamp());
+  EXPECT_EQ(1, state.factions(0).arrivals(1).timestamp());
+
+  // A faction with no info yet gets one.
+  const auto other = util::objectid::New("faction", 2);
+  calendar_.Add(area_id_, other, makeArrival(4, 1, 1));
+  calendar_.Store(&state);
+  ASSERT_EQ(2, state.factions_size());
+  EXPECT_TRUE(other == state.factions(1).faction_id());
+  EXPECT_EQ(1, state.factions(1).arrivals_size());
+}
+
+} // namespace sevenyears
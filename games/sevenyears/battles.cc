@@ -41,7 +41,7 @@ sameDirectionInterception(const geography::Connection::Movement& movement,
 micro::Measure Interception(const geography::Connection::Movement& movement,
                             const geography::Connection::Movement& otherMove,
                             micro::Measure length_u) {
-  if (movement.base_area_id == otherMove.base_area_id) {
+  if (movement.from_a == otherMove.from_a) {
     return sameDirectionInterception(movement, otherMove);
   }
 
@@ -54,41 +54,39 @@ micro::Measure Interception(const geography::Connection::Movement& movement,
 }
 
 
-void SeaMoveObserver::Listen(const geography::Connection::Movement& movement) {}
+void SeaMoveObserver::Listen(
+    const geography::Connection& connection,
+    const std::vector<geography::Connection::Movement>& movements) {}
 
 void SeaMoveObserver::Battle(BattleResolver& resolver) {}
 
 void SeaMoveObserver::Clear() {}
 
-void LandMoveObserver::Listen(const geography::Connection::Movement& movement) {
-  const auto& conn_id = movement.connection_id;
-  traversals_[conn_id].push_back(movement);
+void LandMoveObserver::Listen(
+    const geography::Connection& connection,
+    const std::vector<geography::Connection::Movement>& movements) {
+  traversals_.emplace_back(&connection, &movements);
 }
 
 std::vector<BattleResult> LandMoveObserver::Battle(BattleResolver& resolver) {
   std::vector<BattleResult> results;
   for (const auto& it : traversals_) {
-    const auto& conn_id = it.first;
-    const auto* connection = geography::Connection::ById(conn_id);
-    const auto& a_area_id = connection->a_id();
-    const auto& z_area_id = connection->z_id();
+    const auto* connection = it.first;
+    const auto& conn_id = connection->connection_id();
     const auto length_u = connection->length_u();
 
     std::vector<Encounter> meetings;
     
     std::unordered_set<util::proto::ObjectId> faction_ids;
-    auto& movements = it.second;
+    const auto& movements = *it.second;
     for (unsigned int ii = 0; ii < movements.size(); ++ii) {
-      auto& movement = movements[ii];
-      auto* unit = units::Unit::ById(movement.object_id);
-      if (unit == nullptr) {
-        // This should never happen.
-        continue;
-      }
+      const auto& movement = movements[ii];
+      // Units are the only things that move in this game.
+      auto* unit = static_cast<units::Unit*>(movement.mobile);
 
       const auto& faction_id = unit->faction_id();
       // Check if this unit encounters any existing meeting.
-      bool forwards = movement.base_area_id == a_area_id;
+      bool forwards = movement.from_a;
       // pointA is the closest the unit gets to area A, whether
       // at the beginning or end of its move.
       micro::uMeasure pointA =
@@ -132,11 +130,7 @@ std::vector<BattleResult> LandMoveObserver::Battle(BattleResolver& resolver) {
       tempMeeting.point_u = micro::kMaxU;
       for (unsigned int jj = ii+1; jj < movements.size(); ++jj) {
         const auto& otherMove = movements[jj];
-        auto* cand = units::Unit::ById(otherMove.object_id);
-        if (cand == nullptr) {
-          // This should never happen.
-          continue;
-        }
+        auto* cand = static_cast<units::Unit*>(otherMove.mobile);
         if (util::objectid::Equal(faction_id, cand->faction_id())) {
           continue;
         }
@@ -173,41 +167,39 @@ void LandMoveObserver::Clear() {
   traversals_.clear();
 }
 
+// TODO: Insert actual alliance mechanics for the predicates.
+DefaultBattleResolver::DefaultBattleResolver()
+    : relations_(util::objectid::Equal, util::objectid::NotEqual) {}
+
 std::vector<BattleResult> DefaultBattleResolver::Resolve(Encounter& encounter) {
   std::vector<util::proto::ObjectId> faction_ids;
   for (const auto& army : encounter.armies) {
     faction_ids.push_back(army.first);
   }
-  // TODO: Insert actual alliance mechanics for the predicates.
-  auto conflicts = factions::Divide(faction_ids, util::objectid::Equal,
-                                    util::objectid::NotEqual);
-  // Do largest battles first.
-  std::sort(
-      conflicts.begin(), conflicts.end(),
-      [&encounter](const std::pair<std::vector<util::proto::ObjectId>,
-                                   std::vector<util::proto::ObjectId>>& one,
-                   const std::pair<std::vector<util::proto::ObjectId>,
-                                   std::vector<util::proto::ObjectId>>& two) {
-        // Just count the units involved.
-        int oneCount = 0;
-        int twoCount = 0;
-        for (const auto& faction : one.first) {
-          oneCount += encounter.armies[faction].size();
-        }
-        for (const auto& faction : one.second) {
-          oneCount += encounter.armies[faction].size();
-        }
-        for (const auto& faction : two.first) {
-          twoCount += encounter.armies[faction].size();
-        }
-        for (const auto& faction : two.second) {
-          twoCount += encounter.armies[faction].size();
-        }
-        return oneCount > twoCount;
-      });
+  const auto& divided = relations_.Divide(faction_ids);
+
+  // Do largest battles first, counting the units involved.
+  std::vector<int> sizes;
+  std::vector<int> order;
+  for (const auto& conflict : divided) {
+    int count = 0;
+    for (const auto& faction : conflict.first) {
+      count += encounter.armies[faction].size();
+    }
+    for (const auto& faction : conflict.second) {
+      count += encounter.armies[faction].size();
+    }
+    order.push_back(sizes.size());
+    sizes.push_back(count);
+  }
+  std::stable_sort(order.begin(), order.end(),
+                   [&sizes](int one, int two) {
+                     return sizes[one] > sizes[two];
+                   });
 
   std::vector<BattleResult> results;
-  for (const auto& conflict : conflicts) {
+  for (const int index : order) {
+    const auto& conflict = divided[index];
     std::vector<units::Unit*> armyOne;
     for (const auto& faction : conflict.first) {
       for (auto* unit : encounter.armies[faction]) {
@@ -2,8 +2,10 @@
 #define GAMES_SEVENYEARS_BATTLES_H
 
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "games/factions/factions.h"
 #include "games/geography/connection.h"
 #include "games/units/unit.h"
 #include "util/proto/object_id.pb.h"
@@ -35,9 +37,15 @@ class BattleResolver {
 // Default implementation.
 class DefaultBattleResolver : public BattleResolver {
 public:
+  DefaultBattleResolver();
+
    std::vector<BattleResult> Resolve(Encounter& encounter) override;
 
 private:
+  // Which factions fight which; kept between encounters so that divisions
+  // of the same factions are reused.
+  factions::Relations relations_;
+
   BattleResult fight(std::vector<units::Unit*> armyOne,
                      std::vector<units::Unit*> armyTwo);
 };
@@ -47,7 +55,9 @@ private:
 class SeaMoveObserver : public geography::Connection::Listener {
  public:
   // Check for interceptions by enemy warships.
-  void Listen(const geography::Connection::Movement& movement) override;
+  void Listen(const geography::Connection& connection,
+              const std::vector<geography::Connection::Movement>& movements)
+      override;
 
   // Resolve at-sea encounters.
   void Battle(BattleResolver& resolver);
@@ -60,7 +70,9 @@ class SeaMoveObserver : public geography::Connection::Listener {
 class LandMoveObserver : public geography::Connection::Listener {
  public:
   // Accumulate units for possible battle.
-  void Listen(const geography::Connection::Movement& movement) override;
+  void Listen(const geography::Connection& connection,
+              const std::vector<geography::Connection::Movement>& movements)
+      override;
 
   // Find and resolve battles.
    std::vector<BattleResult> Battle(BattleResolver& resolver);
@@ -69,10 +81,11 @@ class LandMoveObserver : public geography::Connection::Listener {
   void Clear();
   
  private:
-  // Map from connection IDs to movements.
-   std::unordered_map<util::proto::ObjectId,
-                      std::vector<geography::Connection::Movement>>
-       traversals_;
+  // Connections moved through this round, with their movements; these are
+  // the connections' own buffers, valid until they clear their movements.
+  std::vector<std::pair<const geography::Connection*,
+                        const std::vector<geography::Connection::Movement>*>>
+      traversals_;
 };
 
 // Retreats losing units and starts sieges.
@@ -24,15 +24,12 @@ class ObserverTest : public testing::Test, public TestState {
 
 TEST_F(ObserverTest, Interception) {
   struct testCase {
-    testCase(std::string d, const util::proto::ObjectId& area1,
-             micro::Measure s1_u, micro::Measure d1_u,
-             const util::proto::ObjectId& area2, micro::Measure s2_u,
-             micro::Measure d2_u, micro::Measure l_u, micro::Measure e_u)
-        : desc(d), movement(util::objectid::kNullId, util::objectid::kNullId,
-                            area1, s1_u, d1_u),
-          otherMove(util::objectid::kNullId, util::objectid::kNullId, area2,
-                    s2_u, d2_u),
-          length_u(l_u), expect_u(e_u) {}
+    testCase(std::string d, bool from_a1, micro::uMeasure s1_u,
+             micro::uMeasure d1_u, bool from_a2, micro::uMeasure s2_u,
+             micro::uMeasure d2_u, micro::Measure l_u, micro::Measure e_u)
+        : desc(d), movement{nullptr, s1_u, d1_u, from_a1},
+          otherMove{nullptr, s2_u, d2_u, from_a2}, length_u(l_u),
+          expect_u(e_u) {}
     std::string desc;
     geography::Connection::Movement movement;
     geography::Connection::Movement otherMove;
@@ -42,40 +39,40 @@ TEST_F(ObserverTest, Interception) {
 
   std::vector<testCase> cases = {
       {"opposite directions, interception at end",
-       util::objectid::New("area", 1), micro::kZeroInU, micro::kHalfInU,
-       util::objectid::New("area", 2), micro::kZeroInU, micro::kHalfInU,
+       true, micro::kZeroInU, micro::kHalfInU,
+       false, micro::kZeroInU, micro::kHalfInU,
        micro::kOneInU, micro::kHalfInU},
       {"opposite directions, interception at start",
-       util::objectid::New("area", 1), micro::kHalfInU, micro::kHalfInU,
-       util::objectid::New("area", 2), micro::kHalfInU, micro::kHalfInU,
+       true, micro::kHalfInU, micro::kHalfInU,
+       false, micro::kHalfInU, micro::kHalfInU,
        micro::kOneInU, micro::kHalfInU},
       {"opposite directions, different speeds, intercept in middle",
-       util::objectid::New("area", 1), micro::kZeroInU, micro::kHalfInU,
-       util::objectid::New("area", 2), micro::kZeroInU, micro::kOneInU,
+       true, micro::kZeroInU, micro::kHalfInU,
+       false, micro::kZeroInU, micro::kOneInU,
        micro::kOneInU, micro::kOneThirdInU},
       {"opposite directions, insufficient speeds, interception out of range",
-       util::objectid::New("area", 1), micro::kZeroInU, micro::kHalfInU,
-       util::objectid::New("area", 2), micro::kZeroInU, micro::kHalfInU,
+       true, micro::kZeroInU, micro::kHalfInU,
+       false, micro::kZeroInU, micro::kHalfInU,
        2 * micro::kOneInU, micro::kOneInU},
       {"opposite directions, start passed, negative interception",
-       util::objectid::New("area", 1), micro::kTwoThirdsInU, micro::kHalfInU,
-       util::objectid::New("area", 2), micro::kTwoThirdsInU, micro::kHalfInU,
+       true, micro::kTwoThirdsInU, micro::kHalfInU,
+       false, micro::kTwoThirdsInU, micro::kHalfInU,
        2 * micro::kOneInU, micro::kOneInU},
       {"same directions, equal speed, intercept at start",
-       util::objectid::New("area", 1), micro::kTwoThirdsInU, micro::kHalfInU,
-       util::objectid::New("area", 1), micro::kTwoThirdsInU, micro::kHalfInU,
+       true, micro::kTwoThirdsInU, micro::kHalfInU,
+       true, micro::kTwoThirdsInU, micro::kHalfInU,
        2 * micro::kOneInU, micro::kTwoThirdsInU},
       {"same directions, equal speed, no interception",
-       util::objectid::New("area", 1), micro::kTwoThirdsInU, micro::kHalfInU,
-       util::objectid::New("area", 1), micro::kTwoThirdsInU + 1,
+       true, micro::kTwoThirdsInU, micro::kHalfInU,
+       true, micro::kTwoThirdsInU + 1,
        micro::kHalfInU, 2 * micro::kOneInU, -1},
       {"same directions, double speed, interception in middle",
-       util::objectid::New("area", 1), micro::kZeroInU, micro::kOneInU,
-       util::objectid::New("area", 1), micro::kOneFourthInU, micro::kHalfInU,
+       true, micro::kZeroInU, micro::kOneInU,
+       true, micro::kOneFourthInU, micro::kHalfInU,
        micro::kOneInU, micro::kHalfInU},
       {"same directions, half speed, negative interception",
-       util::objectid::New("area", 1), micro::kZeroInU, micro::kHalfInU,
-       util::objectid::New("area", 1), micro::kOneFourthInU, micro::kOneInU,
+       true, micro::kZeroInU, micro::kHalfInU,
+       true, micro::kOneFourthInU, micro::kOneInU,
        micro::kOneInU, -micro::kOneFourthInU},
   };
 
@@ -94,10 +91,10 @@ TEST_F(ObserverTest, DetectMeetings) {
   ASSERT_EQ(world_proto_.connections_size(), 1);
 
   struct testCase {
-    std::vector<micro::Measure> start1_us;
-    std::vector<micro::Measure> dist1_us;
-    std::vector<micro::Measure> start2_us;
-    std::vector<micro::Measure> dist2_us;
+    std::vector<micro::uMeasure> start1_us;
+    std::vector<micro::uMeasure> dist1_us;
+    std::vector<micro::uMeasure> start2_us;
+    std::vector<micro::uMeasure> dist2_us;
     std::vector<micro::Measure> want_us;
     bool same;
   };
@@ -148,33 +145,28 @@ TEST_F(ObserverTest, DetectMeetings) {
 
   const auto connection =
       geography::Connection::FromProto(world_proto_.connections(0));
-  const auto connection_id = connection->connection_id();
   std::vector<std::unique_ptr<units::Unit>> units;
   for (const auto& proto : world_proto_.units()) {
     units.emplace_back(units::Unit::FromProto(proto));
   }
-  const auto area_1_id = util::objectid::New("area", 1);
-  const auto area_2_id = util::objectid::New("area", 2);
-  const auto& unit_1_id = world_proto_.units(0).unit_id();
-  const auto& unit_2_id = world_proto_.units(1).unit_id();
   LandMoveObserver observer;
+  connection->Register(util::objectid::New("listener", 1), &observer);
   TestResolver resolver;
   for (const auto& cc : cases) {
     observer.Clear();
     resolver.encounters.clear();
     for (unsigned int i = 0; i < cc.start1_us.size(); ++i) {
-      geography::Connection::Movement movement(
-          connection_id, unit_1_id, area_1_id, cc.start1_us[i], cc.dist1_us[i]);
-      observer.Listen(movement);
+      connection->Record(
+          {units[0].get(), cc.start1_us[i], cc.dist1_us[i], true});
     }
     for (unsigned int i = 0; i < cc.start2_us.size(); ++i) {
-      geography::Connection::Movement movement(connection_id, unit_2_id,
-                                               cc.same ? area_1_id : area_2_id,
-                                               cc.start2_us[i], cc.dist2_us[i]);
-      observer.Listen(movement);
+      connection->Record(
+          {units[1].get(), cc.start2_us[i], cc.dist2_us[i], cc.same});
     }
 
+    geography::Connection::DeliverMovements();
     observer.Battle(resolver);
+    geography::Connection::ClearMovements();
 
     if (resolver.encounters.size() != cc.want_us.size()) {
       EXPECT_EQ(cc.want_us.size(), resolver.encounters.size());
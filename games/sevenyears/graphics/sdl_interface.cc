@@ -1,6 +1,8 @@
 #include "games/sevenyears/graphics/sdl_interface.h"
 
+#include <algorithm>
 #include <experimental/filesystem>
+#include <unordered_set>
 #include <utility>
 
 #include "absl/strings/substitute.h"
@@ -9,8 +11,9 @@
 #include "games/sevenyears/proto/sevenyears.pb.h"
 #include "games/geography/connection.h"
 #include "games/geography/geography.h"
-#include "games/units/unit.h"
+#include "games/units/proto/units.pb.h"
 #include "util/logging/logging.h"
+#include "util/proto/object_id.h"
 #include "util/proto/object_id.pb.h"
 #include "util/status/status.h"
 
@@ -128,12 +131,15 @@ void SDLInterface::drawMap() {
   }
   const Map& currMap = maps_.at(current_map_);
   sprites_->DrawMap(currMap, &map_rectangle_);
-  sprites_->DrawSelectedUnit(selected_unit_id_, &unit_status_rectangle_);
+  units::proto::Unit unit;
+  GetState(selected_unit_id_, &unit);
+  sprites_->DrawSelectedUnit(unit, &unit_status_rectangle_);
 
+  geography::proto::Area area;
+  GetState(selected_area_id_, &area);
   sevenyears::proto::AreaState state;
   GetState(selected_area_id_, &state);
-  sprites_->DrawSelectedArea(selected_area_id_, state,
-                             &area_status_rectangle_);
+  sprites_->DrawSelectedArea(area, state, &area_status_rectangle_);
   sprites_->Update();
 }
 
@@ -230,62 +236,100 @@ util::Status SDLInterface::validate(const proto::Scenario& scenario) {
   return util::OkStatus();
 }
 
-void SDLInterface::DisplayUnits(const std::vector<util::proto::ObjectId>& ids) {
-  for (auto& cm : maps_) {
-    cm.second.unit_locations_.clear();
-    for (auto& area : cm.second.areas_) {
-      area.unit_numbers_.clear();
+void SDLInterface::placeUnit(const units::proto::Unit& unit) {
+  const auto& unit_id = unit.unit_id();
+  const auto& location = unit.location();
+  if (location.has_connection_id()) {
+    const auto* connection =
+        geography::Connection::ById(location.connection_id());
+    if (connection == NULL) {
+      return;
     }
-  }
-  for (const auto& unit_id : ids) {
-    units::Unit* unit = units::Unit::ById(unit_id);
-    if (unit == NULL) {
-      continue;
+    const util::proto::ObjectId& a_id = location.a_area_id();
+    const util::proto::ObjectId& z_id = connection->OtherSide(a_id);
+    double a_weight = location.progress_u();
+    a_weight /= connection->length_u();
+    // TODO: Handle connections between different maps.
+    if (area_map_[a_id].first != area_map_[z_id].first) {
+      return;
     }
-    const auto& location = unit->location();
-    if (location.has_connection_id()) {
-      const auto* connection =
-          geography::Connection::ById(location.connection_id());
-      if (connection == NULL) {
-        continue;
-      }
-      const util::proto::ObjectId& a_id = location.a_area_id();
-      const util::proto::ObjectId& z_id = connection->OtherSide(a_id);
-      double a_weight = location.progress_u();
-      a_weight /= connection->length_u();
-      // TODO: Handle connections between different maps.
-      if (area_map_[a_id].first != area_map_[z_id].first) {
-        continue;
-      }
-      if (maps_.find(area_map_[a_id].first) == maps_.end()) {
-        Log::Debugf("Could not find area %d: %s", a_id.DebugString(),
-                    area_map_[a_id].first);
-        continue;
-      }
-      Map& currMap = maps_.at(area_map_[a_id].first);
-      double xpos = 0;
-      double ypos = 0;
-      for (const auto& area : currMap.areas_) {
-        if (area.area_id_ == a_id) {
-          xpos += area.xpos_ * a_weight;
-          ypos += area.ypos_ * a_weight;
-        } else if (area.area_id_ == z_id) {
-          xpos += area.xpos_ * (1 - a_weight);
-          ypos += area.ypos_ * (1 - a_weight);
-        }
-      }
-      currMap.unit_locations_[unit_id] = {(int)floor(xpos + 0.5),
-                                          (int)floor(ypos + 0.5), 16, 16};
-    } else {
-      if (area_map_.find(location.a_area_id()) == area_map_.end()) {
-        continue;
+    if (maps_.find(area_map_[a_id].first) == maps_.end()) {
+      Log::Debugf("Could not find area %d: %s", a_id.DebugString(),
+                  area_map_[a_id].first);
+      return;
+    }
+    Map& currMap = maps_.at(area_map_[a_id].first);
+    double xpos = 0;
+    double ypos = 0;
+    for (const auto& area : currMap.areas_) {
+      if (area.area_id_ == a_id) {
+        xpos += area.xpos_ * a_weight;
+        ypos += area.ypos_ * a_weight;
+      } else if (area.area_id_ == z_id) {
+        xpos += area.xpos_ * (1 - a_weight);
+        ypos += area.ypos_ * (1 - a_weight);
       }
-      Area& area = getAreaById(location.a_area_id());
-      area.unit_numbers_[unit->template_kind()]++;
     }
+    currMap.unit_locations_[unit_id] = {(int)floor(xpos + 0.5),
+                                        (int)floor(ypos + 0.5), 16, 16};
+    placements_[unit_id] = {area_map_[a_id].first, util::objectid::kNullId};
+  } else {
+    if (area_map_.find(location.a_area_id()) == area_map_.end()) {
+      return;
+    }
+    Area& area = getAreaById(location.a_area_id());
+    area.unit_numbers_[unit_id.kind()]++;
+    placements_[unit_id] = {"", location.a_area_id()};
   }
 }
 
+void SDLInterface::removeUnit(const util::proto::ObjectId& unit_id) {
+  auto placement = placements_.find(unit_id);
+  if (placement == placements_.end()) {
+    return;
+  }
+  const auto& area_id = placement->second.area_id;
+  if (util::objectid::IsNull(area_id)) {
+    maps_.at(placement->second.map).unit_locations_.erase(unit_id);
+  } else {
+    getAreaById(area_id).unit_numbers_[unit_id.kind()]--;
+  }
+  placements_.erase(placement);
+}
+
+void SDLInterface::DisplayUnits(const std::vector<util::proto::ObjectId>& ids,
+                                interface::StateFetcher* frame) {
+  std::unordered_set<util::proto::ObjectId> current(ids.begin(), ids.end());
+  std::vector<util::proto::ObjectId> gone;
+  for (const auto& placement : placements_) {
+    if (current.count(placement.first) == 0) {
+      gone.push_back(placement.first);
+    }
+  }
+  for (const auto& unit_id : gone) {
+    removeUnit(unit_id);
+  }
+
+  // Units that have not changed since they were last placed stay where they
+  // are; only the changed ones are fetched.
+  std::vector<util::proto::ObjectId> changed;
+  const uint64 generation = frame->ChangedSince(displayed_generation_, &changed);
+  changed.erase(std::remove_if(changed.begin(), changed.end(),
+                               [&current](const util::proto::ObjectId& id) {
+                                 return current.count(id) == 0;
+                               }),
+                changed.end());
+  std::vector<interface::StateView> views;
+  frame->FetchBatch(changed, units::proto::Unit::descriptor(), &views);
+  for (int i = 0; i < changed.size(); ++i) {
+    removeUnit(changed[i]);
+    if (views[i]) {
+      placeUnit(static_cast<const units::proto::Unit&>(*views[i]));
+    }
+  }
+  displayed_generation_ = generation;
+}
+
 Area& SDLInterface::getAreaById(const util::proto::ObjectId& area_id) {
   const auto& area_idx = area_map_[area_id];
   return maps_.at(area_idx.first).areas_[area_idx.second];
@@ -345,10 +389,10 @@ void SDLInterface::EventLoop() {
         } else if (e.type == SDL_MOUSEBUTTONUP) {
           if (e.button.button == SDL_BUTTON_LEFT) {
             receiver_->SelectObject(clicked_id);
-            if (units::ById(clicked_id) != nullptr) {
-              selected_unit_id_ = clicked_id;
-            } else if (geography::Area::GetById(clicked_id) != nullptr) {
+            if (area_map_.find(clicked_id) != area_map_.end()) {
               selected_area_id_ = clicked_id;
+            } else {
+              selected_unit_id_ = clicked_id;
             }
           }
         }
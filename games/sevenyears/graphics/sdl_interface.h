@@ -10,7 +10,7 @@
 #include "games/sevenyears/graphics/proto/graphics.pb.h"
 #include "games/sevenyears/graphics/sdl_sprites.h"
 #include "games/sevenyears/graphics/sevenyears_interface.h"
-#include "games/units/unit.h"
+#include "games/units/proto/units.pb.h"
 #include "util/headers/int_types.h"
 #include "util/proto/object_id.pb.h"
 #include "util/proto/object_id.h"
@@ -22,6 +22,8 @@ namespace graphics {
 
 class SDLInterface : public SevenYearsInterface {
 public:
+  SDLInterface() : displayed_generation_(0) {}
+
   util::Status
   Initialise(const games::interface::proto::Config& config) override;
   void Cleanup() override;
@@ -29,10 +31,22 @@ public:
 
   util::Status ScenarioGraphics(
       const sevenyears::graphics::proto::Scenario& scenario) override;
-  void DisplayUnits(const std::vector<util::proto::ObjectId>& ids) override;
+  // Updates the units drawn to those in ids, refetching only the ones that
+  // changed since the last call.
+  void DisplayUnits(const std::vector<util::proto::ObjectId>& ids,
+                    interface::StateFetcher* frame) override;
 
 private:
+  // Where a unit is drawn: at a point on a map if it is travelling, or
+  // counted in an area otherwise.
+  struct Placement {
+    std::string map;
+    util::proto::ObjectId area_id;
+  };
+
   Area& getAreaById(const util::proto::ObjectId& area_id);
+  void placeUnit(const units::proto::Unit& unit);
+  void removeUnit(const util::proto::ObjectId& unit_id);
   void drawMap();
   util::Status validate(const sevenyears::graphics::proto::Scenario& scenario);
 
@@ -46,6 +60,8 @@ private:
   SDL_Rect area_status_rectangle_;
   util::proto::ObjectId selected_unit_id_;
   util::proto::ObjectId selected_area_id_;
+  std::unordered_map<util::proto::ObjectId, Placement> placements_;
+  uint64 displayed_generation_;
 };
 
 }  // namespace graphics
@@ -1,6 +1,7 @@
 #include "games/sevenyears/graphics/sdl_sprites.h"
 
 #include "absl/strings/substitute.h"
+#include "games/actions/plan.h"
 #include "games/geography/geography.h"
 #include "games/geography/connection.h"
 #include "games/interface/proto/config.pb.h"
@@ -8,7 +9,7 @@
 #include "games/market/proto/goods.pb.h"
 #include "games/sevenyears/constants.h"
 #include "games/sevenyears/graphics/bitmap.h"
-#include "games/units/unit.h"
+#include "games/units/proto/units.pb.h"
 #include "util/logging/logging.h"
 #include "util/proto/object_id.pb.h"
 #include "util/proto/object_id.h"
@@ -22,8 +23,6 @@ namespace sevenyears {
 namespace graphics {
 namespace {
 
-constexpr char kUnknownString[] = "UNKNOWN_STRING_WANTED";
-
 const SDL_Color kWhite = {255, 255, 255, 0};
 const SDL_Color kGold = {198, 165, 48, 0};
 
@@ -72,12 +71,12 @@ SpriteDrawer::LoadFonts(const std::experimental::filesystem::path& base_path,
       "LoadFonts not implemented in this sprite class.");
 }
 
-void SpriteDrawer::DrawSelectedUnit(const util::proto::ObjectId& unit_id,
+void SpriteDrawer::DrawSelectedUnit(const units::proto::Unit& unit,
                                     SDL_Rect* unit_rect) {
   // Do nothing.
 }
 
-void SpriteDrawer::DrawSelectedArea(const util::proto::ObjectId& area_id,
+void SpriteDrawer::DrawSelectedArea(const geography::proto::Area& area,
                                     const sevenyears::proto::AreaState& state,
                                     SDL_Rect* area_rect) {
   // Do nothing.
@@ -98,6 +97,12 @@ util::Status SDLSpriteDrawer::Init(int width, int height) {
   }
   renderer_.reset(
       SDL_CreateRenderer(window_.get(), -1, SDL_RENDERER_ACCELERATED));
+  if (!renderer_) {
+    // For example with the dummy video driver; text is drawn from the glyph
+    // atlas, which needs nothing the software renderer lacks.
+    renderer_.reset(
+        SDL_CreateRenderer(window_.get(), -1, SDL_RENDERER_SOFTWARE));
+  }
   if (!renderer_) {
     return util::FailedPreconditionError(
         absl::Substitute("Could not create renderer: $0", SDL_GetError()));
@@ -107,6 +112,8 @@ util::Status SDLSpriteDrawer::Init(int width, int height) {
 }
 
 void SDLSpriteDrawer::Cleanup() {
+  // Before the fonts and renderer it uses.
+  text_.reset();
   for (TTF_Font* font : fonts_) {
     TTF_CloseFont(font);
   }
@@ -167,38 +174,9 @@ void SDLSpriteDrawer::drawArea(const Area& area) {
   }
 }
 
-util::Status SDLSpriteDrawer::createText(const std::string& str, const SDL_Color& c) {
-  TextKey key = {str, c};
-  if (display_texts_.find(key) != display_texts_.end()) {
-    return util::OkStatus();
-  }
-  SDL_Surface* nameSurface =
-      TTF_RenderText_Solid(fonts_[0], str.c_str(), c);
-  if (nameSurface == NULL) {
-    return util::InvalidArgumentError(
-        absl::Substitute("Could not create surface for $0", str));
-  }
-  SDL_Texture* nameTexture =
-      SDL_CreateTextureFromSurface(renderer_.get(), nameSurface);
-  if (nameTexture == NULL) {
-    return util::InvalidArgumentError(
-        absl::Substitute("Could not create texture for $0", str));
-  }
-  display_texts_[key] = {nameTexture, nameSurface->w, nameSurface->h};
-  SDL_FreeSurface(nameSurface);
-  return util::OkStatus();
-}
-
-SDL_Point SDLSpriteDrawer::displayText(Text& text, int x, int y) {
-  SDL_Rect target = {x, y, text.width, text.height};
-  SDL_RenderCopy(renderer_.get(), text.letters, NULL, &target);
-  return {x + text.width, y + text.height};
-}
-
 SDL_Point SDLSpriteDrawer::displayString(const std::string& str,
                                          const SDL_Color& c, int x, int y) {
-  auto& text = getOrCreate(str, c);
-  return displayText(text, x, y);
+  return text_->Draw(str, c, x, y);
 }
 
 SDL_Point
@@ -209,10 +187,9 @@ SDLSpriteDrawer::displayResources(const market::proto::Container& resources,
     if (q.second < 1) {
       continue;
     }
-    auto& nameText = getOrCreate(goods_string(q.first), c);
-    auto next = displayText(nameText, current.x, current.y);
-    auto& amountText = getOrCreate(micro::DisplayString(q.second, 2), c);
-    next = displayText(amountText, next.x + 3, current.y);
+    auto next = displayString(goods_string(q.first), c, current.x, current.y);
+    next = displayString(micro::DisplayString(q.second, 2), c, next.x + 3,
+                         current.y);
     current.y = next.y + 3;
   }
   return current;
@@ -275,23 +252,22 @@ SDL_Point SDLSpriteDrawer::displayLine(const std::vector<std::string>& texts,
     return next;
   }
   for (const auto& text : texts) {
-    auto& texture = getOrCreate(text, c);
-    next = displayText(texture, next.x, y);
+    next = displayString(text, c, next.x, y);
   }
   return next;
 }
 
-SDL_Point SDLSpriteDrawer::displayPlan(const units::Unit& unit,
+SDL_Point SDLSpriteDrawer::displayPlan(const units::proto::Unit& unit,
                                        const SDL_Color& c, int x, int y) {
   const actions::proto::Plan& plan = unit.plan();
-  if (plan.steps().empty()) {
+  if (actions::StepsLeft(plan) == 0) {
     return displayString("No current plan", c, x, y);
   }
   const auto& location = unit.location();
   auto area_id = location.a_area_id();
   SDL_Point current = {x, y};
-  for (const auto& step : plan.steps()) {
-    auto texts = stepToStrings(step, location, &area_id);
+  for (int idx = plan.next_step(); idx < plan.steps_size(); ++idx) {
+    auto texts = stepToStrings(plan.steps(idx), location, &area_id);
     auto next = displayLine(texts, c, current.x, current.y);
     current.y = next.y + 3;
   }
@@ -313,53 +289,38 @@ void SDLSpriteDrawer::DrawMap(const Map& map, SDL_Rect* rect) {
   displayString(map.name_, kWhite, 5, 5);
 }
 
-Text& SDLSpriteDrawer::getOrCreate(const std::string& str, const SDL_Color& c) {
-  TextKey key = {str, c};
-  if (display_texts_.find(key) != display_texts_.end()) {
-    return display_texts_.at(key);
-  }
-  auto status = createText(str, c);
-  if (status.ok()) {
-    return display_texts_.at(key);
-  }
-  display_texts_[key] = display_texts_[{kUnknownString, c}];
-  return display_texts_.at(key);
-}
-
-void SDLSpriteDrawer::DrawSelectedUnit(const util::proto::ObjectId& unit_id,
+void SDLSpriteDrawer::DrawSelectedUnit(const units::proto::Unit& unit,
                                        SDL_Rect* unit_rect) {
   SDL_SetRenderDrawColor(renderer_.get(), 0x00, 0x00, 0x00, 0xFF);
   SDL_RenderFillRect(renderer_.get(), unit_rect);
-  const units::Unit* unit = units::ById(unit_id);
-  if (unit == nullptr) {
+  if (!unit.has_unit_id()) {
     return;
   }
 
-  auto& nameText = getOrCreate(unit_string(unit_id), kGold);
-  auto next = displayText(nameText, unit_rect->x + 5, unit_rect->y + 5);
-  next = displayResources(unit->resources(), kGold, unit_rect->x + 5,
+  auto next = displayString(unit_string(unit.unit_id()), kGold,
+                            unit_rect->x + 5, unit_rect->y + 5);
+  next = displayResources(unit.resources(), kGold, unit_rect->x + 5,
                           next.y + 3);
-  next = displayPlan(*unit, kGold, unit_rect->x + 5, next.y + 3);
+  next = displayPlan(unit, kGold, unit_rect->x + 5, next.y + 3);
 }
 
 void SDLSpriteDrawer::DrawSelectedArea(
-    const util::proto::ObjectId& area_id,
+    const geography::proto::Area& area,
     const sevenyears::proto::AreaState& state, SDL_Rect* area_rect) {
   SDL_SetRenderDrawColor(renderer_.get(), 0x00, 0x00, 0x00, 0xFF);
   SDL_RenderFillRect(renderer_.get(), area_rect);
-  geography::Area* area = geography::ById(area_id);
-  if (area == nullptr) {
+  if (!area.has_area_id()) {
     return;
   }
   int baseX = area_rect->x + 5;
-  auto& nameText = getOrCreate(area_string(area_id), kGold);
-  auto next = displayText(nameText, baseX, area_rect->y + 5);
-  auto& ownerText = getOrCreate(faction_string(state.owner_id()), kGold);
-  next = displayText(ownerText, baseX, next.y + 3);
+  auto next =
+      displayString(area_string(area.area_id()), kGold, baseX, area_rect->y + 5);
+  next = displayString(faction_string(state.owner_id()), kGold, baseX,
+                       next.y + 3);
   uint64 importCap = 0;
-  for (int i = 0; i < area->num_fields(); ++i) {
-    importCap += market::GetAmount(area->field(i)->resources(),
-                                   constants::ImportCapacity());
+  for (const auto& field : area.fields()) {
+    importCap +=
+        market::GetAmount(field.resources(), constants::ImportCapacity());
   }
   if (importCap > 0) {
     std::vector<std::string> importLine = {"Import capacity ",
@@ -391,8 +352,8 @@ void SDLSpriteDrawer::DrawSelectedArea(
       continue;
     }
     if (showFactions) {
-      auto& factionText = getOrCreate(faction_string(lfi.faction_id()), kGold);
-      next = displayText(factionText, baseX, next.y + 3);
+      next = displayString(faction_string(lfi.faction_id()), kGold, baseX,
+                           next.y + 3);
     }
     next = displayResources(lfi.warehouse(), kGold,
                             baseX + (showFactions ? 5 : 0), next.y + 3);
@@ -416,12 +377,12 @@ SDLSpriteDrawer::LoadFonts(const std::experimental::filesystem::path& base_path,
     }
     fonts_.push_back(font);
   }
-  auto status = createText(kUnknownString, kWhite);
-  if (!status.ok()) {
-    return status;
+  if (fonts_.empty()) {
+    return util::InvalidArgumentError("No fonts in scenario");
   }
-
-  return util::OkStatus();
+  text_.reset(new GlyphAtlas(renderer_.get(),
+                             GlyphAtlas::FontGlyphs(fonts_[0])));
+  return text_->Init();
 }
 
 util::Status SDLSpriteDrawer::UnitGraphics(
@@ -453,12 +414,6 @@ SDLSpriteDrawer::MapGraphics(const std::experimental::filesystem::path& path,
     return status;
   }
   map_backgrounds_[map->name_] = bkg;
-
-  status = createText(map->name_, kWhite);
-  if (!status.ok()) {
-    return status;
-  }
-  
   return util::OkStatus();
 }
 
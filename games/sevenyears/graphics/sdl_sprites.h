@@ -9,56 +9,19 @@
 #include <unordered_map>
 
 #include "games/actions/proto/plan.pb.h"
+#include "games/geography/proto/geography.pb.h"
 #include "games/interface/proto/config.pb.h"
 #include "games/market/proto/goods.pb.h"
 #include "games/sevenyears/graphics/proto/graphics.pb.h"
+#include "games/sevenyears/graphics/text_atlas.h"
 #include "games/sevenyears/proto/sevenyears.pb.h"
-#include "games/units/unit.h"
+#include "games/units/proto/units.pb.h"
 #include "util/proto/object_id.pb.h"
 #include "util/proto/object_id.h"
 #include "util/status/status.h"
 #include "SDL.h"
 #include "SDL_ttf.h"
 
-struct TextKey {
-  std::string str_;
-  SDL_Color color_;
-};
-
-namespace std {
-template <> class hash<TextKey> {
-public:
-  size_t operator()(const TextKey& key) const {
-    static hash<int> hasher;
-    static hash<std::string> str_hasher;
-    int total = (key.color_.r << 24) + (key.color_.g << 16) +
-                (key.color_.b << 8) + key.color_.a;
-    return 31*str_hasher(key.str_) + hasher(total);
-  }
-};
-
-template <> struct equal_to<TextKey> {
-  bool operator()(const TextKey& lhs,
-                  const TextKey& rhs) const {
-    if (lhs.color_.r != rhs.color_.r) {
-      return false;
-    }
-    if (lhs.color_.g != rhs.color_.g) {
-      return false;
-    }
-    if (lhs.color_.b != rhs.color_.b) {
-      return false;
-    }
-    if (lhs.color_.a != rhs.color_.a) {
-      return false;
-    }
-    return lhs.str_ == rhs.str_;
-  }
-};
-
-} // namespace std
-
-
 namespace sevenyears {
 namespace graphics {
 
@@ -96,9 +59,9 @@ class SpriteDrawer {
   virtual const util::proto::ObjectId& ClickedObject(const Map& map, int x,
                                                      int y);
   virtual void DrawMap(const Map& map, SDL_Rect* rect) = 0;
-  virtual void DrawSelectedUnit(const util::proto::ObjectId& unit_id,
+  virtual void DrawSelectedUnit(const units::proto::Unit& unit,
                                 SDL_Rect* unit_rect);
-  virtual void DrawSelectedArea(const util::proto::ObjectId& area_id,
+  virtual void DrawSelectedArea(const geography::proto::Area& area,
                                 const sevenyears::proto::AreaState& state,
                                 SDL_Rect* area_rect);
   virtual util::Status Init(int width, int height) = 0;
@@ -113,13 +76,6 @@ class SpriteDrawer {
   virtual void Update() = 0;
 };
 
-// Wrapper for SDL texture.
-struct Text {
-  SDL_Texture* letters;
-  int width;
-  int height;
-};
-
 class SDLSpriteDrawer : public SpriteDrawer {
 public:
   void Cleanup() override;
@@ -127,9 +83,9 @@ public:
   const util::proto::ObjectId& ClickedObject(const Map& map, int x,
                                              int y) override;
   void DrawMap(const Map& map, SDL_Rect* rect) override;
-  void DrawSelectedUnit(const util::proto::ObjectId& unit_id,
+  void DrawSelectedUnit(const units::proto::Unit& unit,
                         SDL_Rect* unit_rect) override;
-  void DrawSelectedArea(const util::proto::ObjectId& area_id,
+  void DrawSelectedArea(const geography::proto::Area& area,
                         const sevenyears::proto::AreaState& state,
                         SDL_Rect* area_rect) override;
   util::Status Init(int width, int height) override;
@@ -143,17 +99,14 @@ public:
   void Update() override;
 
 private:
-  util::Status createText(const std::string& str, const SDL_Color& c);
-  Text& getOrCreate(const std::string& str, const SDL_Color& c);
   SDL_Point displayLine(const std::vector<std::string>& texts,
                         const SDL_Color& c, int x, int y);
-  SDL_Point displayPlan(const units::Unit& unit, const SDL_Color& c, int x,
-                        int y);
+  SDL_Point displayPlan(const units::proto::Unit& unit, const SDL_Color& c,
+                        int x, int y);
   SDL_Point displayResources(const market::proto::Container& resources,
                              const SDL_Color& c, int x, int y);
   SDL_Point displayString(const std::string& str, const SDL_Color& c, int x,
                           int y);
-  SDL_Point displayText(Text& text, int x, int y);
   void drawArea(const Area& area);
 
   std::unique_ptr<SDL_Window, SDLWindowCleaner> window_;
@@ -161,7 +114,8 @@ private:
   std::unordered_map<std::string, SDL_Texture*> unit_types_;
   std::unordered_map<std::string, SDL_Texture*> map_backgrounds_;
   std::vector<TTF_Font*> fonts_;
-  std::unordered_map<TextKey, Text> display_texts_;
+  // Draws text in the first font.
+  std::unique_ptr<GlyphAtlas> text_;
 };
 
 // This implementation is not complete, due to my decision to use
@@ -0,0 +1,137 @@
+#include "games/sevenyears/graphics/text_atlas.h"
+
+#include <algorithm>
+
+#include "absl/strings/substitute.h"
+#include "util/logging/logging.h"
+
+namespace sevenyears {
+namespace graphics {
+namespace {
+
+// Space between glyphs, so that scaling never bleeds one into the next.
+constexpr int kPadding = 1;
+
+} // namespace
+
+constexpr int GlyphAtlas::kDefaultSize;
+constexpr int GlyphAtlas::kDefaultLayouts;
+
+GlyphAtlas::GlyphAtlas(SDL_Renderer* renderer, GlyphRenderer glyph_renderer,
+                       int size, int layouts)
+    : renderer_(renderer), glyph_renderer_(std::move(glyph_renderer)),
+      size_(size), pixels_(nullptr), texture_(nullptr), dirty_(false),
+      row_x_(0), row_y_(0), row_height_(0), layouts_(layouts) {}
+
+GlyphAtlas::~GlyphAtlas() {
+  if (texture_ != nullptr) {
+    SDL_DestroyTexture(texture_);
+  }
+  if (pixels_ != nullptr) {
+    SDL_FreeSurface(pixels_);
+  }
+}
+
+GlyphAtlas::GlyphRenderer GlyphAtlas::FontGlyphs(TTF_Font* font) {
+  return [font](Uint16 code) {
+    static const SDL_Color kWhite = {255, 255, 255, 255};
+    return TTF_RenderGlyph_Blended(font, code, kWhite);
+  };
+}
+
+util::Status GlyphAtlas::Init() {
+  pixels_ = SDL_CreateRGBSurfaceWithFormat(0, size_, size_, 32,
+                                           SDL_PIXELFORMAT_ARGB8888);
+  if (pixels_ == nullptr) {
+    return util::FailedPreconditionError(absl::Substitute(
+        "Could not create glyph atlas surface: $0", SDL_GetError()));
+  }
+  SDL_FillRect(pixels_, nullptr, 0);
+  texture_ = SDL_CreateTexture(renderer_, SDL_PIXELFORMAT_ARGB8888,
+                               SDL_TEXTUREACCESS_STATIC, size_, size_);
+  if (texture_ == nullptr) {
+    return util::FailedPreconditionError(absl::Substitute(
+        "Could not create glyph atlas texture: $0", SDL_GetError()));
+  }
+  SDL_SetTextureBlendMode(texture_, SDL_BLENDMODE_BLEND);
+  dirty_ = true;
+  return util::OkStatus();
+}
+
+const GlyphAtlas::Glyph& GlyphAtlas::glyph(Uint16 code) {
+  auto found = glyphs_.find(code);
+  if (found != glyphs_.end()) {
+    return found->second;
+  }
+  // Failures are remembered too, so they are reported only once.
+  Glyph& glyph = glyphs_[code];
+  glyph.source = {0, 0, 0, 0};
+  glyph.advance = 0;
+  SDL_Surface* surface = glyph_renderer_(code);
+  if (surface == nullptr) {
+    Log::Warnf("Could not render glyph %d", code);
+    return glyph;
+  }
+  if (row_x_ + surface->w > size_) {
+    row_x_ = 0;
+    row_y_ += row_height_ + kPadding;
+    row_height_ = 0;
+  }
+  if (surface->w > size_ || row_y_ + surface->h > size_) {
+    Log::Errorf("Glyph atlas is full, cannot add glyph %d", code);
+    SDL_FreeSurface(surface);
+    return glyph;
+  }
+  glyph.source = {row_x_, row_y_, surface->w, surface->h};
+  glyph.advance = surface->w;
+  // Copy the alpha as well as the colour, rather than blending.
+  SDL_SetSurfaceBlendMode(surface, SDL_BLENDMODE_NONE);
+  SDL_BlitSurface(surface, nullptr, pixels_, &glyph.source);
+  SDL_FreeSurface(surface);
+  row_x_ += glyph.source.w + kPadding;
+  row_height_ = std::max(row_height_, glyph.source.h);
+  dirty_ = true;
+  return glyph;
+}
+
+const GlyphAtlas::Layout& GlyphAtlas::layout(const std::string& str) {
+  Layout* cached = layouts_.Find(str);
+  if (cached != nullptr) {
+    return *cached;
+  }
+  Layout layout;
+  layout.width = 0;
+  layout.height = 0;
+  for (const unsigned char letter : str) {
+    const Glyph& current = glyph(letter);
+    if (current.source.w > 0) {
+      layout.sources.push_back(current.source);
+      layout.targets.push_back(
+          {layout.width, 0, current.source.w, current.source.h});
+      layout.height = std::max(layout.height, current.source.h);
+    }
+    layout.width += current.advance;
+  }
+  return layouts_.Insert(str, std::move(layout));
+}
+
+SDL_Point GlyphAtlas::Draw(const std::string& str, const SDL_Color& c, int x,
+                           int y) {
+  // Lay out first, so that all new glyphs are uploaded together.
+  const Layout& text = layout(str);
+  if (dirty_) {
+    SDL_UpdateTexture(texture_, nullptr, pixels_->pixels, pixels_->pitch);
+    dirty_ = false;
+  }
+  SDL_SetTextureColorMod(texture_, c.r, c.g, c.b);
+  for (int i = 0; i < text.sources.size(); ++i) {
+    SDL_Rect target = text.targets[i];
+    target.x += x;
+    target.y += y;
+    SDL_RenderCopy(renderer_, texture_, &text.sources[i], &target);
+  }
+  return {x + text.width, y + text.height};
+}
+
+}  // namespace graphics
+}  // namespace sevenyears
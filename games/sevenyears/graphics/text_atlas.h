@@ -0,0 +1,92 @@
+#ifndef GAMES_SEVENYEARS_GRAPHICS_TEXT_ATLAS_H
+#define GAMES_SEVENYEARS_GRAPHICS_TEXT_ATLAS_H
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "util/cache/lru.h"
+#include "util/status/status.h"
+#include "SDL.h"
+#include "SDL_ttf.h"
+
+namespace sevenyears {
+namespace graphics {
+
+// Draws text from one texture holding each glyph of a font once. Glyphs are
+// rendered white and tinted with the texture colour modulation when drawn,
+// so every colour shares them; a string is drawn as one copy per glyph, all
+// from the same texture, which the renderer can batch. Only the positions
+// of the glyphs of recently drawn strings are cached, so strings that
+// change every turn cost no texture memory.
+class GlyphAtlas {
+public:
+  // Returns the pixels of one Latin-1 glyph, white on transparent, for the
+  // atlas to copy and free; or null if the glyph cannot be rendered.
+  typedef std::function<SDL_Surface*(Uint16 glyph)> GlyphRenderer;
+
+  // Width and height of the atlas texture.
+  static constexpr int kDefaultSize = 512;
+  // Number of string layouts kept.
+  static constexpr int kDefaultLayouts = 512;
+
+  GlyphAtlas(SDL_Renderer* renderer, GlyphRenderer glyph_renderer,
+             int size = kDefaultSize, int layouts = kDefaultLayouts);
+  ~GlyphAtlas();
+  GlyphAtlas(const GlyphAtlas&) = delete;
+  GlyphAtlas& operator=(const GlyphAtlas&) = delete;
+
+  // Returns a GlyphRenderer for font, which must outlive the atlas.
+  static GlyphRenderer FontGlyphs(TTF_Font* font);
+
+  // Creates the atlas texture.
+  util::Status Init();
+
+  // Draws str in colour c with its top left at x, y, and returns the bottom
+  // right corner of the drawn text.
+  SDL_Point Draw(const std::string& str, const SDL_Color& c, int x, int y);
+
+  // Number of distinct glyphs in the atlas.
+  int glyphs() const { return glyphs_.size(); }
+  // Number of string layouts cached.
+  int layouts() const { return layouts_.size(); }
+
+private:
+  struct Glyph {
+    // Location in the atlas; empty for glyphs that could not be rendered.
+    SDL_Rect source;
+    int advance;
+  };
+
+  // Where to copy each glyph of a string from and to, relative to its top
+  // left.
+  struct Layout {
+    std::vector<SDL_Rect> sources;
+    std::vector<SDL_Rect> targets;
+    int width;
+    int height;
+  };
+
+  const Glyph& glyph(Uint16 code);
+  const Layout& layout(const std::string& str);
+
+  SDL_Renderer* renderer_;
+  GlyphRenderer glyph_renderer_;
+  const int size_;
+  // Holds the glyphs in memory, copied to texture_ whenever dirty_.
+  SDL_Surface* pixels_;
+  SDL_Texture* texture_;
+  bool dirty_;
+  // Glyphs are packed in rows, left to right and top to bottom.
+  int row_x_;
+  int row_y_;
+  int row_height_;
+  std::unordered_map<Uint16, Glyph> glyphs_;
+  util::LruCache<std::string, Layout> layouts_;
+};
+
+}  // namespace graphics
+}  // namespace sevenyears
+
+#endif
@@ -0,0 +1,116 @@
+#include "games/sevenyears/graphics/text_atlas.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+#include "SDL.h"
+
+namespace sevenyears {
+namespace graphics {
+namespace {
+
+constexpr int kGlyphWidth = 4;
+constexpr int kGlyphHeight = 8;
+
+// Draws into a surface with the software renderer, so no display is needed.
+class GlyphAtlasTest : public testing::Test {
+protected:
+  void SetUp() override {
+    SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+    ASSERT_EQ(0, SDL_Init(SDL_INIT_VIDEO)) << SDL_GetError();
+    target_ =
+        SDL_CreateRGBSurfaceWithFormat(0, 64, 32, 32, SDL_PIXELFORMAT_ARGB8888);
+    ASSERT_NE(nullptr, target_) << SDL_GetError();
+    renderer_ = SDL_CreateSoftwareRenderer(target_);
+    ASSERT_NE(nullptr, renderer_) << SDL_GetError();
+    SDL_SetRenderDrawColor(renderer_, 0, 0, 0, 255);
+    SDL_RenderClear(renderer_);
+    rendered_ = 0;
+  }
+
+  void TearDown() override {
+    SDL_DestroyRenderer(renderer_);
+    SDL_FreeSurface(target_);
+    SDL_Quit();
+  }
+
+  // Stands in for a font: every glyph is a solid white block.
+  GlyphAtlas::GlyphRenderer blocks() {
+    return [this](Uint16 code) {
+      ++rendered_;
+      SDL_Surface* glyph = SDL_CreateRGBSurfaceWithFormat(
+          0, kGlyphWidth, kGlyphHeight, 32, SDL_PIXELFORMAT_ARGB8888);
+      SDL_FillRect(glyph, nullptr, SDL_MapRGBA(glyph->format, 255, 255, 255,
+                                               255));
+      return glyph;
+    };
+  }
+
+  Uint32 pixel(int x, int y) {
+    SDL_RenderPresent(renderer_);
+    const auto* row = static_cast<const Uint8*>(target_->pixels) +
+                      y * target_->pitch;
+    return reinterpret_cast<const Uint32*>(row)[x];
+  }
+
+  Uint32 rgb(Uint8 r, Uint8 g, Uint8 b) {
+    return SDL_MapRGB(target_->format, r, g, b);
+  }
+
+  SDL_Surface* target_;
+  SDL_Renderer* renderer_;
+  int rendered_;
+};
+
+TEST_F(GlyphAtlasTest, DrawsEachGlyphOnce) {
+  GlyphAtlas atlas(renderer_, blocks());
+  auto status = atlas.Init();
+  ASSERT_TRUE(status.ok()) << status.ToString();
+
+  const SDL_Color red = {255, 0, 0, 0};
+  SDL_Point corner = atlas.Draw("aab", red, 2, 3);
+  EXPECT_EQ(2 + 3 * kGlyphWidth, corner.x);
+  EXPECT_EQ(3 + kGlyphHeight, corner.y);
+  EXPECT_EQ(2, rendered_);
+  EXPECT_EQ(2, atlas.glyphs());
+
+  EXPECT_EQ(rgb(255, 0, 0), pixel(2, 3));
+  EXPECT_EQ(rgb(255, 0, 0), pixel(corner.x - 1, corner.y - 1));
+  EXPECT_EQ(rgb(0, 0, 0), pixel(corner.x, 3));
+  EXPECT_EQ(rgb(0, 0, 0), pixel(2, corner.y));
+
+  // Another colour and string reuse the glyphs.
+  const SDL_Color blue = {0, 0, 255, 0};
+  corner = atlas.Draw("ba", blue, 2, 20);
+  EXPECT_EQ(2, rendered_);
+  EXPECT_EQ(rgb(0, 0, 255), pixel(2, 20));
+  EXPECT_EQ(rgb(255, 0, 0), pixel(2, 3));
+}
+
+TEST_F(GlyphAtlasTest, BoundsLayouts) {
+  GlyphAtlas atlas(renderer_, blocks(), GlyphAtlas::kDefaultSize, 2);
+  ASSERT_TRUE(atlas.Init().ok());
+  const SDL_Color white = {255, 255, 255, 0};
+  for (int turn = 0; turn < 100; ++turn) {
+    atlas.Draw(std::to_string(turn), white, 0, 0);
+  }
+  EXPECT_EQ(2, atlas.layouts());
+  EXPECT_EQ(10, atlas.glyphs());
+  EXPECT_EQ(10, rendered_);
+}
+
+TEST_F(GlyphAtlasTest, FullAtlas) {
+  // Room for one row of two glyphs.
+  GlyphAtlas atlas(renderer_, blocks(), 2 * kGlyphWidth + 1);
+  ASSERT_TRUE(atlas.Init().ok());
+  const SDL_Color white = {255, 255, 255, 0};
+  // Glyphs that do not fit are left out, without stopping the rest.
+  SDL_Point corner = atlas.Draw("abc", white, 0, 0);
+  EXPECT_EQ(2 * kGlyphWidth, corner.x);
+  EXPECT_EQ(kGlyphHeight, corner.y);
+  EXPECT_EQ(3, atlas.glyphs());
+}
+
+}  // namespace
+}  // namespace graphics
+}  // namespace sevenyears
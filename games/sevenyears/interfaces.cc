@@ -23,7 +23,37 @@ SevenYearsStateImpl::mutable_area_state(const util::proto::ObjectId& area_id) {
     static proto::AreaState dummy;
     return &dummy;
   }
+  touchAreaState(area_id);
   return &area_states_.at(area_id);
 }
 
+uint64 SevenYearsStateImpl::AreaStateGeneration(
+    const util::proto::ObjectId& area_id) const {
+  auto generation = area_state_generations_.find(area_id);
+  if (generation == area_state_generations_.end()) {
+    return 0;
+  }
+  return generation->second;
+}
+
+void SevenYearsStateImpl::touchAreaState(const util::proto::ObjectId& area_id) {
+  ++area_state_generations_[area_id];
+}
+
+void SevenYearsStateImpl::StoreArrivals() {
+  for (auto& state : area_states_) {
+    if (arrivals_.Dirty(state.first)) {
+      arrivals_.Store(&state.second);
+      touchAreaState(state.first);
+    }
+  }
+}
+
+void SevenYearsStateImpl::loadArrivals() {
+  arrivals_.Clear();
+  for (const auto& state : area_states_) {
+    arrivals_.Load(state.second);
+  }
+}
+
 } // namespace sevenyears
@@ -2,6 +2,7 @@
 #define GAMES_SEVENYEARS_INTERFACES_H
 
 #include "games/industry/industry.h"
+#include "games/sevenyears/arrival_calendar.h"
 #include "games/units/unit.h"
 #include "games/setup/setup.h"
 #include "games/sevenyears/proto/sevenyears.pb.h"
@@ -17,9 +18,14 @@ public:
   virtual const games::setup::Constants& Constants() const override = 0;
   virtual const sevenyears::proto::AreaState&
   AreaState(const util::proto::ObjectId& area_id) const = 0;
+  // Returns a number that changes whenever the state of the area may have
+  // changed.
+  virtual uint64
+  AreaStateGeneration(const util::proto::ObjectId& area_id) const = 0;
   virtual const industry::Production&
   ProductionChain(const std::string& name) const = 0;
   virtual uint64 timestamp() const = 0;
+  virtual const ArrivalCalendar& Arrivals() const = 0;
 
   // Filtered accessors. The implementation may be stateful.
   virtual std::vector<const units::Unit*>
@@ -28,6 +34,10 @@ public:
   // Non-const methods.
   virtual sevenyears::proto::AreaState*
   mutable_area_state(const util::proto::ObjectId& area_id) = 0;
+  virtual ArrivalCalendar* mutable_arrivals() = 0;
+  // Copies the arrivals calendar into the arrival lists of the area states.
+  // Until this is called those lists may be out of date.
+  virtual void StoreArrivals() = 0;
 };
 
 // Default implementation.
@@ -45,15 +55,30 @@ public:
   }
   const sevenyears::proto::AreaState&
   AreaState(const util::proto::ObjectId& area_id) const override;
+  uint64
+  AreaStateGeneration(const util::proto::ObjectId& area_id) const override;
+  const ArrivalCalendar& Arrivals() const override { return arrivals_; }
 
   sevenyears::proto::AreaState*
   mutable_area_state(const util::proto::ObjectId& area_id) override;
+  ArrivalCalendar* mutable_arrivals() override { return &arrivals_; }
+  void StoreArrivals() override;
 
 protected:
+  // Loads the arrivals calendar from the area states.
+  void loadArrivals();
+  // Marks the state of the area as changed, for changes not made through
+  // mutable_area_state.
+  void touchAreaState(const util::proto::ObjectId& area_id);
+
   std::unique_ptr<games::setup::World> game_world_;
   games::setup::Constants constants_;
+  // The arrival lists in the area states are a copy of arrivals_, which is
+  // authoritative; they are only brought up to date by StoreArrivals.
   std::unordered_map<util::proto::ObjectId, sevenyears::proto::AreaState>
       area_states_;
+  ArrivalCalendar arrivals_;
+  std::unordered_map<util::proto::ObjectId, uint64> area_state_generations_;
 
 private:
   uint64 timestamp_;
@@ -3,6 +3,7 @@
 #include <algorithm>
 
 #include "absl/strings/substitute.h"
+#include "games/actions/plan.h"
 #include "games/actions/proto/plan.pb.h"
 #include "games/actions/proto/strategy.pb.h"
 #include "games/ai/executer.h"
@@ -94,7 +95,7 @@ void clearUnitInfo(const units::Unit& unit, proto::Faction* faction) {}
 // TODO: Account for unit cargo capacity.
 micro::Measure netGoods(const util::proto::ObjectId& faction_id,
                         const std::string& goods, const proto::AreaState& state,
-                        uint64 timestamp) {
+                        const ArrivalCalendar& arrivals, uint64 timestamp) {
   const proto::LocalFactionInfo* lfi = nullptr;
   for (int i = 0; i < state.factions_size(); ++i) {
     const auto& curr = state.factions(i);
@@ -110,15 +111,8 @@ micro::Measure netGoods(const util::proto::ObjectId& faction_id,
   }
 
   // TODO: Also account for production.
-  auto amount = market::GetAmount(lfi->warehouse(), goods);
-  for (const auto& arr : lfi->arrivals()) {
-    if (arr.timestamp() > timestamp) {
-      continue;
-    }
-    amount += market::GetAmount(arr.cargo(), goods);
-  }
-
-  return amount;
+  return market::GetAmount(lfi->warehouse(), goods) +
+         arrivals.Expected(state.area_id(), faction_id, goods, timestamp);
 }
 
 // Returns the supplies consumed each turn by units of the given faction
@@ -271,8 +265,9 @@ void SevenYearsMerchant::checkForPickup(const units::Unit& unit,
     return;
   }
   int pickup_time = ai::utils::NumTurns(unit, pickup_path);
-  micro::Measure availablePickup = netGoods(faction_id, pickupGoods, state,
-                                            game_->timestamp() + pickup_time);
+  micro::Measure availablePickup =
+      netGoods(faction_id, pickupGoods, state, game_->Arrivals(),
+               game_->timestamp() + pickup_time);
   // Supplies must account for the additional time taken to detour to pickup.
   int carry_time = ai::utils::NumTurns(unit, carry_path);
 
@@ -281,8 +276,9 @@ void SevenYearsMerchant::checkForPickup(const units::Unit& unit,
   hypothetical.supplies = candidate->supplies;
   micro::Measure availableExchange = 0;
   if (!exchangeGoods.empty()) {
-    availableExchange = netGoods(faction_id, exchangeGoods, state,
-                                 game_->timestamp() + pickup_time + carry_time);
+    availableExchange =
+        netGoods(faction_id, exchangeGoods, state, game_->Arrivals(),
+                 game_->timestamp() + pickup_time + carry_time);
     hypothetical.supplies = availableExchange;
   }
 
@@ -334,7 +330,7 @@ util::Status SevenYearsMerchant::planEuropeanTrade(
     }
     const auto& state = game_->AreaState(area->area_id());
     candidate.supplies =
-        netGoods(faction_id, constants::Supplies(), state,
+        netGoods(faction_id, constants::Supplies(), state, game_->Arrivals(),
                  game_->timestamp() + candidate.first_traverse_time);
     if (candidate.supplies > supplyCapacity) {
       candidate.supplies = supplyCapacity;
@@ -536,7 +532,7 @@ SevenYearsMerchant::AddStepsToPlan(const units::Unit& unit,
   if (!strategy.has_seven_years_merchant()) {
     return util::NotFoundError("No SevenYearsMerchant strategy");
   }
-  if (plan->steps_size() > 0) {
+  if (actions::StepsLeft(*plan) > 0) {
     return util::OkStatus();
   }
 
@@ -0,0 +1,132 @@
+#include "games/sevenyears/remote_game.h"
+
+#include <poll.h>
+
+#include "absl/strings/substitute.h"
+
+namespace sevenyears {
+
+void DeltaFetcher::Apply(const proto::StateDelta& delta) {
+  timestamp_ = delta.timestamp();
+  ++generation_;
+  for (const auto& area_state : delta.area_states()) {
+    areas_[area_state.area_id()] =
+        std::make_shared<const proto::AreaState>(area_state);
+    changed_[area_state.area_id()] = generation_;
+  }
+  for (const auto& unit : delta.units()) {
+    units_[unit.unit_id()] = std::make_shared<const units::proto::Unit>(unit);
+    changed_[unit.unit_id()] = generation_;
+  }
+  for (const auto& object_id : delta.removed_ids()) {
+    areas_.erase(object_id);
+    units_.erase(object_id);
+    changed_.erase(object_id);
+  }
+}
+
+interface::StateView
+DeltaFetcher::find(const util::proto::ObjectId& object_id,
+                   const google::protobuf::Descriptor* type) const {
+  if (type == proto::AreaState::descriptor()) {
+    auto area = areas_.find(object_id);
+    if (area != areas_.end()) {
+      return area->second;
+    }
+  } else if (type == units::proto::Unit::descriptor()) {
+    auto unit = units_.find(object_id);
+    if (unit != units_.end()) {
+      return unit->second;
+    }
+  }
+  return nullptr;
+}
+
+void DeltaFetcher::Fetch(const util::proto::ObjectId& object_id,
+                         google::protobuf::Message* proto) {
+  auto view = find(object_id, proto->GetDescriptor());
+  if (view) {
+    proto->CopyFrom(*view);
+  }
+}
+
+uint64
+DeltaFetcher::FetchBatch(const std::vector<util::proto::ObjectId>& object_ids,
+                         const google::protobuf::Descriptor* type,
+                         std::vector<interface::StateView>* views) {
+  views->clear();
+  views->reserve(object_ids.size());
+  for (const auto& object_id : object_ids) {
+    views->push_back(find(object_id, type));
+  }
+  return generation_;
+}
+
+uint64
+DeltaFetcher::ChangedSince(uint64 generation,
+                           std::vector<util::proto::ObjectId>* object_ids) {
+  for (const auto& object : changed_) {
+    if (object.second > generation) {
+      object_ids->push_back(object.first);
+    }
+  }
+  return generation_;
+}
+
+util::Status RemoteGame::Connect(const std::string& path) {
+  auto status = net::Connect(path, &connection_);
+  if (!status.ok()) {
+    return status;
+  }
+  proto::ServerRequest request;
+  request.set_kind(proto::ServerRequest::SR_SNAPSHOT);
+  status = connection_->Send(request);
+  if (!status.ok()) {
+    return status;
+  }
+  return receive();
+}
+
+util::Status RemoteGame::RequestTurn() {
+  if (!connection_) {
+    return util::FailedPreconditionError("Not connected");
+  }
+  proto::ServerRequest request;
+  request.set_kind(proto::ServerRequest::SR_NEW_TURN);
+  return connection_->Send(request);
+}
+
+util::Status RemoteGame::receive() {
+  proto::StateDelta delta;
+  auto status = connection_->Receive(&delta);
+  if (!status.ok()) {
+    return status;
+  }
+  if (delta.has_error()) {
+    return util::InvalidArgumentError(
+        absl::Substitute("Server error: $0", delta.error()));
+  }
+  fetcher_.Apply(delta);
+  return util::OkStatus();
+}
+
+util::Status RemoteGame::Poll() {
+  if (!connection_) {
+    return util::FailedPreconditionError("Not connected");
+  }
+  while (true) {
+    pollfd ready;
+    ready.fd = connection_->fd();
+    ready.events = POLLIN;
+    ready.revents = 0;
+    if (poll(&ready, 1, 0) <= 0 || (ready.revents & POLLIN) == 0) {
+      return util::OkStatus();
+    }
+    auto status = receive();
+    if (!status.ok()) {
+      return status;
+    }
+  }
+}
+
+}  // namespace sevenyears
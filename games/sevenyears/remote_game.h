@@ -0,0 +1,91 @@
+// Client side of the headless sevenyears server.
+#ifndef GAMES_SEVENYEARS_REMOTE_GAME_H
+#define GAMES_SEVENYEARS_REMOTE_GAME_H
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "games/interface/base.h"
+#include "games/sevenyears/proto/server.pb.h"
+#include "games/sevenyears/proto/sevenyears.pb.h"
+#include "games/units/proto/units.pb.h"
+#include "util/headers/int_types.h"
+#include "util/net/unix_socket.h"
+#include "util/proto/object_id.h"
+#include "util/proto/object_id.pb.h"
+#include "util/status/status.h"
+
+namespace sevenyears {
+
+// StateFetcher that serves area and unit states from a local copy of the
+// world, kept up to date by applying the deltas a StateServer sends. Each
+// Apply is one generation. Objects are replaced rather than changed in
+// place, so views handed out earlier are unaffected.
+class DeltaFetcher : public interface::StateFetcher {
+public:
+  DeltaFetcher() : timestamp_(0), generation_(0) {}
+
+  // Merges the states in delta into the local copy, and drops the objects
+  // it lists as removed.
+  void Apply(const proto::StateDelta& delta);
+
+  // Copies the state of object_id into proto, if it is known and proto is an
+  // AreaState or a Unit.
+  void Fetch(const util::proto::ObjectId& object_id,
+             google::protobuf::Message* proto) override;
+
+  uint64 Generation() const override { return generation_; }
+  uint64 FetchBatch(const std::vector<util::proto::ObjectId>& object_ids,
+                    const google::protobuf::Descriptor* type,
+                    std::vector<interface::StateView>* views) override;
+  uint64 ChangedSince(uint64 generation,
+                      std::vector<util::proto::ObjectId>* object_ids) override;
+
+  // Time of the most recent delta.
+  uint64 timestamp() const { return timestamp_; }
+
+private:
+  // Returns the state of object_id as a message of type, or null.
+  interface::StateView find(const util::proto::ObjectId& object_id,
+                            const google::protobuf::Descriptor* type) const;
+
+  std::unordered_map<util::proto::ObjectId,
+                     std::shared_ptr<const proto::AreaState>>
+      areas_;
+  std::unordered_map<util::proto::ObjectId,
+                     std::shared_ptr<const units::proto::Unit>>
+      units_;
+  // The generation in which each object last changed.
+  std::unordered_map<util::proto::ObjectId, uint64> changed_;
+  uint64 timestamp_;
+  uint64 generation_;
+};
+
+// Connection to a headless server. Deltas are applied to fetcher() as they
+// arrive, so a UI can hand that to its interface and call Poll once a frame.
+class RemoteGame {
+public:
+  // Connects to the server listening on path and loads a full snapshot.
+  util::Status Connect(const std::string& path);
+
+  // Asks the server to run a turn. The changes arrive through Poll, like
+  // those from turns requested by other clients.
+  util::Status RequestTurn();
+
+  // Applies every delta already waiting on the connection, without blocking.
+  util::Status Poll();
+
+  DeltaFetcher* fetcher() { return &fetcher_; }
+
+private:
+  util::Status receive();
+
+  std::unique_ptr<net::Connection> connection_;
+  DeltaFetcher fetcher_;
+};
+
+}  // namespace sevenyears
+
+#endif
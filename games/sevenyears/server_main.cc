@@ -0,0 +1,144 @@
+// Headless sevenyears server. Runs the game without any interface and serves
+// clients on a Unix-domain socket; see proto/server.proto for the requests.
+// Every client gets the changes from each turn, whoever asked for it.
+#include <poll.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "games/setup/proto/setup.pb.h"
+#include "games/sevenyears/proto/server.pb.h"
+#include "games/sevenyears/sevenyears.h"
+#include "games/sevenyears/state_server.h"
+#include "util/logging/logging.h"
+#include "util/net/unix_socket.h"
+#include "util/proto/file.h"
+#include "util/status/status.h"
+
+namespace {
+constexpr char kDefaultSocket[] = "/tmp/sevenyears.sock";
+// A client that does not read its deltas for this long is dropped, rather
+// than holding up the others.
+constexpr int kSendTimeoutMs = 1000;
+
+// Serves requests until the listener fails.
+void serve(int listener, sevenyears::StateServer* server) {
+  std::vector<std::unique_ptr<net::Connection>> clients;
+  while (true) {
+    std::vector<pollfd> fds(clients.size() + 1);
+    fds[0].fd = listener;
+    fds[0].events = POLLIN;
+    for (int i = 0; i < clients.size(); ++i) {
+      fds[i + 1].fd = clients[i]->fd();
+      fds[i + 1].events = POLLIN;
+    }
+    if (poll(fds.data(), fds.size(), -1) < 0) {
+      continue;
+    }
+
+    std::vector<bool> dropped(clients.size(), false);
+    auto send = [&clients, &dropped](int i,
+                                     const sevenyears::proto::StateDelta& delta) {
+      if (dropped[i]) {
+        return;
+      }
+      auto status = clients[i]->Send(delta);
+      if (!status.ok()) {
+        Log::Warnf("Dropping client %d: %s", clients[i]->fd(),
+                   status.message());
+        dropped[i] = true;
+      }
+    };
+    for (int i = 0; i < clients.size(); ++i) {
+      if (fds[i + 1].revents == 0 || dropped[i]) {
+        continue;
+      }
+      sevenyears::proto::ServerRequest request;
+      auto status = clients[i]->Receive(&request);
+      if (!status.ok()) {
+        dropped[i] = true;
+        continue;
+      }
+      sevenyears::proto::StateDelta delta;
+      if (!server->Handle(request, &delta)) {
+        send(i, delta);
+        continue;
+      }
+      Log::Infof("Turn %d: %d areas and %d units changed, %d removed",
+                 delta.timestamp(), delta.area_states_size(),
+                 delta.units_size(), delta.removed_ids_size());
+      for (int j = 0; j < clients.size(); ++j) {
+        send(j, delta);
+      }
+    }
+    for (int i = clients.size() - 1; i >= 0; --i) {
+      if (dropped[i]) {
+        clients.erase(clients.begin() + i);
+      }
+    }
+
+    if (fds[0].revents & POLLIN) {
+      std::unique_ptr<net::Connection> client;
+      auto status = net::Accept(listener, &client);
+      if (!status.ok()) {
+        Log::Errorf("Error accepting client: %s", status.message());
+        return;
+      }
+      status = client->SetSendTimeout(kSendTimeoutMs);
+      if (!status.ok()) {
+        Log::Errorf("Error setting up client: %s", status.message());
+        continue;
+      }
+      clients.push_back(std::move(client));
+    }
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Log::Register(Log::coutLogger);
+  if (argc < 2) {
+    Log::Error("Usage: sevenyears_server <scenario file> [socket path]");
+    return 1;
+  }
+  const std::string socket_path = argc > 2 ? argv[2] : kDefaultSocket;
+
+  games::setup::proto::ScenarioFiles scenario;
+  auto status = util::proto::ParseProtoFile(argv[1], &scenario);
+  if (!status.ok()) {
+    Log::Errorf("Error reading file %s: %s", argv[1], status.message());
+    return 2;
+  }
+  if (!scenario.has_root_path()) {
+    const std::string file = argv[1];
+    const auto slash = file.find_last_of('/');
+    scenario.set_root_path(slash == std::string::npos ? "."
+                                                      : file.substr(0, slash));
+  }
+
+  sevenyears::SevenYears game;
+  status = game.InitialiseAI();
+  if (!status.ok()) {
+    Log::Errorf("Error initialising AI: %s", status.message());
+    return 3;
+  }
+  status = game.LoadScenario(scenario);
+  if (!status.ok()) {
+    Log::Errorf("Error loading scenario: %s", status.message());
+    return 3;
+  }
+
+  int listener = -1;
+  status = net::Listen(socket_path, &listener);
+  if (!status.ok()) {
+    Log::Errorf("Error listening on %s: %s", socket_path, status.message());
+    return 4;
+  }
+  Log::Infof("Serving on %s", socket_path);
+
+  sevenyears::StateServer server(&game, [&game]() { game.NewTurn(); });
+  serve(listener, &server);
+  return 5;
+}
@@ -1,8 +1,12 @@
 #include "games/sevenyears/sevenyears.h"
 
+#include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "absl/strings/substitute.h"
+#include "games/actions/plan.h"
 #include "games/actions/proto/plan.pb.h"
 #include "games/actions/proto/strategy.pb.h"
 #include "games/actions/strategy.h"
@@ -25,6 +29,7 @@
 #include "util/logging/logging.h"
 #include "util/proto/object_id.h"
 #include "util/status/status.h"
+#include "util/threads/parallel.h"
 
 namespace sevenyears {
 
@@ -40,6 +45,28 @@ market::proto::Container* findWarehouse(const util::proto::ObjectId& faction_id,
   return lfi->mutable_warehouse();
 }
 
+// Attrites the unit and replenishes it from warehouse, for each level of
+// supply it can afford in turn.
+void consumeUnitSupplies(market::proto::Container* warehouse,
+                         units::Unit* unit) {
+  unit->Attrite();
+  for (const auto& con : unit->Template().supplies()) {
+    // Not using the full consumption model here.
+    if (con.goods_size() < 1) {
+      continue;
+    }
+
+    const auto& required = con.goods(0).consumed();
+    if (*warehouse >= required) {
+      *warehouse -= required;
+      *unit->mutable_resources() =
+          market::SubtractFloor(unit->resources(), con.relief(), 0);
+    } else {
+      break;
+    }
+  }
+}
+
 util::Status validateSetup(const games::setup::proto::ScenarioFiles& setup) {
   if (!setup.has_name()) {
     return util::InvalidArgumentError(
@@ -125,7 +152,20 @@ util::Status validateWorldState(
 
 }  // namespace
 
+SevenYears::~SevenYears() {
+  // The world is owned by the base class, so would otherwise go after the
+  // context; and objects unregister themselves from the current context.
+  util::Context::Scope scope(&context_);
+  sea_listener_.reset();
+  land_listener_.reset();
+  army_ai_.reset();
+  merchant_ai_.reset();
+  cost_calculator_.reset();
+  game_world_.reset();
+}
+
 util::Status SevenYears::InitialiseAI() {
+  util::Context::Scope scope(&context_);
   ai::RegisterExecutor(constants::LoadShip(),
                        [this](const ai::ActionCost& action,
                               const actions::proto::Step& step,
@@ -197,7 +237,8 @@ util::Status SevenYears::loadShip(const micro::Measure fraction_u,
   if (fraction_u < micro::kOneInU) {
     available_u = micro::MultiplyU(available_u, fraction_u);
   }
-  market::Move(step.good(), available_u, warehouse, unit->mutable_resources());
+  market::Add(step.good(), -available_u, warehouse);
+  unit->AddCargo(step.good(), available_u);
   capacity_u -= available_u;
   if (capacity_u <= 0) {
     return util::OkStatus();
@@ -250,48 +291,52 @@ util::Status SevenYears::offloadCargo(const micro::Measure fraction_u,
   return util::OkStatus();
 }
 
+sevenyears::proto::AreaState*
+SevenYears::mutable_area_state(const util::proto::ObjectId& area_id) {
+  area_agenda_.Wake(area_id);
+  return SevenYearsStateImpl::mutable_area_state(area_id);
+}
+
 void SevenYears::cacheUnitLocations() {
-  unitsByAreaId_.clear();
+  unit_index_.Clear();
   for (const auto& unit : World().units_) {
-    const auto& location_id = unit->location().a_area_id();
-    if (unitsByAreaId_.find(location_id) == unitsByAreaId_.end()) {
-      unitsByAreaId_.emplace(std::make_pair(
-          location_id, std::vector<const units::Unit*>{unit.get()}));
-      continue;
-    }
-    unitsByAreaId_.at(location_id).emplace_back(unit.get());
+    unit_index_.Add(unit.get());
   }
 }
 
 void SevenYears::consumeSupplies() {
+  // Group the units by the warehouse they draw on, keeping unit order within
+  // each group. The groups share no state, so they can run concurrently with
+  // the same result as a single pass over the units.
+  std::vector<std::pair<market::proto::Container*, std::vector<units::Unit*>>>
+      groups;
+  std::unordered_map<market::proto::Container*, int> group_indices;
   for (auto& unit : game_world_->units_) {
-    unit->Attrite();
     const auto& area_id = unit->location().a_area_id();
-    auto* area_state = mutable_area_state(area_id);
+    // Does not wake the area; supplies only leave warehouses, which a
+    // sleeping area does not use.
+    auto* area_state = SevenYearsStateImpl::mutable_area_state(area_id);
     if (area_state == nullptr) {
+      unit->Attrite();
       Log::Errorf("Could not find state for area %s so %s could not consume",
                   util::objectid::DisplayString(area_id),
                   util::objectid::DisplayString(unit->unit_id()));
       continue;
     }
     auto* warehouse = findWarehouse(unit->faction_id(), area_state);
-
-    for (const auto& con : unit->Template().supplies()) {
-      // Not using the full consumption model here.
-      if (con.goods_size() < 1) {
-        continue;
-      }
-
-      const auto& required = con.goods(0).consumed();
-      if (*warehouse >= required) {
-        *warehouse -= required;
-        *unit->mutable_resources() =
-            market::SubtractFloor(unit->resources(), con.relief(), 0);
-      } else {
-        break;
-      }
+    auto index = group_indices.find(warehouse);
+    if (index == group_indices.end()) {
+      index = group_indices.emplace(warehouse, groups.size()).first;
+      groups.emplace_back(warehouse, std::vector<units::Unit*>());
     }
+    groups[index->second].second.push_back(unit.get());
   }
+
+  workers_.ParallelFor(groups.size(), [&groups](int i) {
+    for (auto* unit : groups[i].second) {
+      consumeUnitSupplies(groups[i].first, unit);
+    }
+  });
 }
 
 void SevenYears::moveUnits() {
@@ -304,7 +349,7 @@ void SevenYears::moveUnits() {
       continue;
     }
     actions::proto::Plan* plan = unit->mutable_plan();
-    if (plan->steps_size() == 0) {
+    if (actions::StepsLeft(*plan) == 0) {
       auto status = ai::MakePlan(*unit, unit->strategy(), plan);
       if (!status.ok()) {
         Log::Warnf("Could not create plan for unit %s: %s",
@@ -316,27 +361,40 @@ void SevenYears::moveUnits() {
     }
   }
 
+  // Action points only go down and plans only get shorter while executing, so
+  // a unit that cannot act is dropped from the active list for the rest of
+  // the turn.
+  std::vector<units::Unit*> active;
   for (auto& unit : game_world_->units_) {
     unit->reset_action_points();
+    active.push_back(unit.get());
   }
 
+  std::vector<util::LazyStatus> statuses;
   while (true) {
     int count = 0;
     sea_listener_->Clear();
     land_listener_->Clear();
-    for (auto& unit : game_world_->units_) {
+    int num_active = 0;
+    for (auto* unit : active) {
       if (unit->action_points_u() < 1) {
         continue;
       }
-      if (unit->plan().steps_size() == 0) {
+      if (actions::StepsLeft(unit->plan()) == 0) {
         continue;
       }
-      const auto& status =
-          ai::ExecuteStep(unit->plan(), unit.get());
+      active[num_active++] = unit;
+    }
+    active.resize(num_active);
+
+    ai::ExecuteSteps(active, &statuses);
+    for (int i = 0; i < num_active; ++i) {
+      auto* unit = active[i];
+      const auto& status = statuses[i];
       if (status.ok()) {
         Log::Debugf("%s completed %s",
                     util::objectid::DisplayString(unit->unit_id()),
-                    actions::StepName(unit->plan().steps(0)));
+                    actions::StepName(actions::CurrentStep(unit->plan())));
         ai::DeleteStep(unit->mutable_plan());
         count++;
         unit->mutable_plan()->clear_incomplete();
@@ -346,86 +404,122 @@ void SevenYears::moveUnits() {
           Log::Debugf("%s giving up on plan due to %d incomplete attempts at "
                       "%s, returning to mission pool.",
                       util::objectid::DisplayString(unit->unit_id()), inc,
-                      actions::StepName(unit->plan().steps(0)));
-          unit->mutable_plan()->clear_steps();
+                      actions::StepName(actions::CurrentStep(unit->plan())));
+          actions::ClearPlan(unit->mutable_plan());
           unit->mutable_plan()->clear_incomplete();
         } else {
           Log::Debugf("%s attempted %s, incomplete: %d",
                       util::objectid::DisplayString(unit->unit_id()),
-                      actions::StepName(unit->plan().steps(0)), inc);
+                      actions::StepName(actions::CurrentStep(unit->plan())), inc);
           unit->mutable_plan()->set_incomplete(inc);
         }
       } else {
         Log::Debugf("%s could not execute %s: %s",
                     util::objectid::DisplayString(unit->unit_id()),
-                    actions::StepName(unit->plan().steps(0)),
+                    actions::StepName(actions::CurrentStep(unit->plan())),
                     status.message());
       }
     }
 
-    sea_listener_->Battle(DefaultBattleResolver());
-    auto results = land_listener_->Battle(DefaultBattleResolver());
+    geography::Connection::DeliverMovements();
+    sea_listener_->Battle(battle_resolver_);
+    auto results = land_listener_->Battle(battle_resolver_);
     for (auto& result : results) {
       ApplyBattleOutcome(result);
     }
+    // Battles may have destroyed units, so the movements must not outlive
+    // the round.
+    geography::Connection::ClearMovements();
 
     if (count == 0) {
       break;
     }
   } 
-  
-  cacheUnitLocations();
+}
+
+bool SevenYears::updateArea(geography::Area* area) {
+  area->Update();
+  const auto& area_id = area->area_id();
+  if (area_states_.find(area_id) == area_states_.end()) {
+    Log::Debugf("Could not find state for area %d", area_id.number());
+    return area->Recovered();
+  }
+  auto& area_state = area_states_.at(area_id);
+  bool doTrade = false;
+  for (int i = 0; i < area->num_fields(); ++i) {
+    const geography::proto::Field* field = area->field(i);
+    if (market::GetAmount(field->resources(), constants::ImportCapacity()) > 0) {
+      doTrade = true;
+      break;
+    }
+  }
+
+  if (doTrade) {
+    runEuropeanTrade(&area_state, area);
+    return false;
+  }
+  runAreaProduction(&area_state, area);
+  return area_state.production_size() == 0 && area->Recovered();
 }
 
 void SevenYears::NewTurn() {
+  // The worker pool passes the context on to its threads.
+  util::Context::Scope scope(&context_);
   incrementTime();
   Log::Infof("New turn (%d)", timestamp());
 
+  area_agenda_.Advance(timestamp(), nullptr);
+  std::vector<geography::Area*> due;
   for (const auto& area : game_world_->areas_) {
-    area->Update();
-    const auto& area_id = area->area_id();
-    if (area_states_.find(area_id) == area_states_.end()) {
-      Log::Debugf("Could not find state for area %d", area_id.number());
-      continue;
-    }
-    auto& area_state = area_states_.at(area_id);
-    bool doTrade = false;
-    for (int i = 0; i < area->num_fields(); ++i) {
-      const geography::proto::Field* field = area->field(i);
-      if (market::GetAmount(field->resources(), constants::ImportCapacity()) > 0) {
-        doTrade = true;
-        break;
-      }
+    if (area_agenda_.Due(area->area_id(), timestamp())) {
+      due.push_back(area.get());
     }
-
-    if (doTrade) {
-      runEuropeanTrade(&area_state, area.get());
-    } else {
-      runAreaProduction(&area_state, area.get());
+  }
+  // Each area touches only its own fields and state, so they can be updated
+  // concurrently.
+  std::vector<char> idle(due.size(), 0);
+  workers_.ParallelFor(due.size(), [this, &due, &idle](int i) {
+    idle[i] = updateArea(due[i]) ? 1 : 0;
+  });
+  for (int i = 0; i < due.size(); ++i) {
+    // updateArea changes the state directly rather than through
+    // mutable_area_state.
+    touchAreaState(due[i]->area_id());
+    if (idle[i]) {
+      area_agenda_.SleepUntil(due[i]->area_id(), area_agenda_.kNever);
     }
   }
 
   consumeSupplies();
   moveUnits();
 
-  dirtyGraphics_ = true;
+  publishSnapshot();
+}
+
+void SevenYears::publishSnapshot() {
+  StoreArrivals();
+  auto snapshot = snapshots_.Back();
+  FillSnapshot(*this, ++snapshot_version_, snapshots_.Front(),
+               snapshot.get());
+  snapshots_.Publish(std::move(snapshot));
 }
 
 // TODO: Move this into the main binary, the graphics don't belong in here.
 void SevenYears::UpdateGraphicsInfo(interface::Base* gfx) {
-  if (!dirtyGraphics_) {
+  // The unit list and the states gfx looks up must come from the same
+  // snapshot, even if a turn publishes another one meanwhile.
+  auto snapshot = snapshots_.Latest();
+  if (!snapshot || snapshot->version == displayed_version_) {
     return;
   }
   std::vector<util::proto::ObjectId> unit_ids;
-  for (const auto& unit : game_world_->units_) {
-    if (!unit) {
-      Log::Warn("Null unit!");
-      continue;
-    }
-    unit_ids.push_back(unit->ID());
+  unit_ids.reserve(snapshot->units.size());
+  for (const auto& unit : snapshot->units) {
+    unit_ids.push_back(unit.first);
   }
-  gfx->DisplayUnits(unit_ids);
-  dirtyGraphics_ = false;
+  displayed_version_ = snapshot->version;
+  SnapshotFetcher frame(std::move(snapshot));
+  gfx->DisplayUnits(unit_ids, &frame);
 }
 
 void SevenYears::runEuropeanTrade(proto::AreaState* area_state,
@@ -503,7 +597,7 @@ void SevenYears::runAreaProduction(proto::AreaState* area_state,
       break;
     }
     const std::string& chain_name = area_state->production(i);
-    const auto& chain = production_chains_[chain_name];
+    const auto& chain = ProductionChain(chain_name);
 
     if (!field->has_progress() || chain.Complete(field->progress())) {
       *field->mutable_progress() = chain.MakeProgress(micro::kOneInU);
@@ -563,6 +657,7 @@ SevenYears::validation(const games::setup::proto::GameWorld& world) {
 
 util::Status
 SevenYears::LoadScenario(const games::setup::proto::ScenarioFiles& setup) {
+  util::Context::Scope scope(&context_);
   auto status = validateSetup(setup);
   if (!status.ok()) {
     return status;
@@ -646,6 +741,7 @@ SevenYears::LoadScenario(const games::setup::proto::ScenarioFiles& setup) {
     *state.mutable_owner_id() = util::objectid::kNullId;
     area_states_[area_id] = state;
   }
+  loadArrivals();
 
   sea_listener_.reset(new SeaMoveObserver());
   land_listener_.reset(new LandMoveObserver());
@@ -664,6 +760,7 @@ SevenYears::LoadScenario(const games::setup::proto::ScenarioFiles& setup) {
   }
 
   cacheUnitLocations();
+  publishSnapshot();
 
   return util::OkStatus();
 }
@@ -680,9 +777,26 @@ SevenYears::ProductionChain(const std::string& name) const {
 
 void SevenYears::Fetch(const util::proto::ObjectId& object_id,
                        google::protobuf::Message* proto) {
-  if (area_states_.find(object_id) != area_states_.end()) {
-    proto->CopyFrom(area_states_.at(object_id));
-  }
+  SnapshotFetcher(snapshots_.Latest()).Fetch(object_id, proto);
+}
+
+uint64 SevenYears::Generation() const {
+  return SnapshotFetcher(snapshots_.Latest()).Generation();
+}
+
+uint64
+SevenYears::FetchBatch(const std::vector<util::proto::ObjectId>& object_ids,
+                       const google::protobuf::Descriptor* type,
+                       std::vector<interface::StateView>* views) {
+  return SnapshotFetcher(snapshots_.Latest())
+      .FetchBatch(object_ids, type, views);
+}
+
+uint64
+SevenYears::ChangedSince(uint64 generation,
+                         std::vector<util::proto::ObjectId>* object_ids) {
+  return SnapshotFetcher(snapshots_.Latest())
+      .ChangedSince(generation, object_ids);
 }
 
 std::vector<const units::Unit*>
@@ -690,7 +804,7 @@ SevenYears::ListUnits(const units::Filter& filter) const {
   std::vector<const units::Unit*> ret;
   if (util::objectid::IsNull(filter.location_id)) {
     for (const auto& uptr : World().units_) {
-      if (!uptr->Match(filter).ok()) {
+      if (!uptr->Matches(filter)) {
         continue;
       }
       ret.push_back(uptr.get());
@@ -698,17 +812,7 @@ SevenYears::ListUnits(const units::Filter& filter) const {
     return ret;
   }
 
-  if (unitsByAreaId_.find(filter.location_id) == unitsByAreaId_.end()) {
-    return ret;
-  }
-
-  for (const auto* uptr : unitsByAreaId_.at(filter.location_id)) {
-    if (!uptr->Match(filter).ok()) {
-      continue;
-    }
-    ret.push_back(uptr);
-  }
-
+  unit_index_.InArea(filter.location_id, filter.faction_id, &ret);
   return ret;
 }
 
@@ -1,10 +1,12 @@
 #ifndef GAMES_SEVENYEARS_SEVENYEARS_H
 #define GAMES_SEVENYEARS_SEVENYEARS_H
 
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "games/interface/base.h"
+#include "games/setup/agenda.h"
 #include "games/setup/proto/setup.pb.h"
 #include "games/sevenyears/action_cost_calculator.h"
 #include "games/sevenyears/army_ai.h"
@@ -12,40 +14,82 @@
 #include "games/sevenyears/interfaces.h"
 #include "games/sevenyears/merchant_ship_ai.h"
 #include "games/sevenyears/proto/sevenyears.pb.h"
+#include "games/sevenyears/world_snapshot.h"
+#include "games/units/unit_index.h"
+#include "util/context/context.h"
+#include "util/headers/int_types.h"
 #include "util/proto/object_id.pb.h"
 #include "util/status/status.h"
+#include "util/threads/parallel.h"
 
 namespace sevenyears {
 
-// Class for running actual game mechanics.
+// Class for running actual game mechanics. The game keeps its registries -
+// goods, units, areas, executors and so on - in a util::Context of its own,
+// which LoadScenario, InitialiseAI and NewTurn make current while they run.
+// Callers that look objects up in the registries themselves should hold a
+// Scope for context().
 class SevenYears : public SevenYearsStateImpl, public interface::StateFetcher {
 public:
-  SevenYears() : dirtyGraphics_(true) {}
-  ~SevenYears() {}
+  SevenYears() : snapshot_version_(0), displayed_version_(0) {}
+  ~SevenYears();
+
+  // The context holding this game's registries.
+  util::Context* context() { return &context_; }
 
   util::Status LoadScenario(const games::setup::proto::ScenarioFiles& setup);
+  // Runs a turn and publishes a new snapshot at the end of it.
   void NewTurn();
+  // Passes the units in the latest snapshot to gfx, if it has not seen it.
+  // Safe to call while a turn is running on another thread.
   void UpdateGraphicsInfo(interface::Base* gfx);
   util::Status InitialiseAI();
 
   const industry::Production&
   ProductionChain(const std::string& name) const override;
 
-  // Load the state of object_id into proto, if it exists.
+  // Load the state of object_id, as of the latest snapshot, into proto if it
+  // exists. Safe to call while a turn is running on another thread.
   void Fetch(const util::proto::ObjectId& object_id,
-             google::protobuf::Message* proto);
+             google::protobuf::Message* proto) override;
+
+  // Batched and incremental fetches from the latest snapshot; the
+  // generation is the snapshot version.
+  uint64 Generation() const override;
+  uint64 FetchBatch(const std::vector<util::proto::ObjectId>& object_ids,
+                    const google::protobuf::Descriptor* type,
+                    std::vector<interface::StateView>* views) override;
+  uint64 ChangedSince(uint64 generation,
+                      std::vector<util::proto::ObjectId>* object_ids) override;
+
+  // Returns the state as of the end of the last turn.
+  std::shared_ptr<const WorldSnapshot> Snapshot() const {
+    return snapshots_.Latest();
+  }
 
   std::vector<const units::Unit*>
   ListUnits(const units::Filter& filter) const override;
 
+  // Also wakes the area, since its production or warehouses may change.
+  sevenyears::proto::AreaState*
+  mutable_area_state(const util::proto::ObjectId& area_id) override;
+
 private:
-  // Recalculate the units-by-area map.
+  // Refills the unit index from the world.
   void cacheUnitLocations();
   // Use supplies.
   friend class SevenYearsTest_ConsumeSupplies_Test;
+  friend class SevenYearsTest_ArrivalWakesArea_Test;
+  friend class SevenYearsTest_SnapshotSharesIdleAreas_Test;
   void consumeSupplies();
   // Moves units, updating their plans if needed.
   void moveUnits();
+  // Copies the state the interface needs into a new snapshot.
+  void publishSnapshot();
+  // Recovers resources and runs production or trade in one area. Safe to call
+  // concurrently for different areas. Returns true if the area has nothing to
+  // do until something outside it changes.
+  bool updateArea(geography::Area* area);
   void runAreaProduction(proto::AreaState* area_state, geography::Area* area);
   void runEuropeanTrade(proto::AreaState* area_state, geography::Area* area);
   std::vector<std::string>
@@ -60,13 +104,27 @@ private:
                             const actions::proto::Step& step, units::Unit* unit,
                             market::proto::Container* amount);
 
-  bool dirtyGraphics_;
+  util::Context context_;
+  // Runs the per-area and per-warehouse work of each turn, without starting
+  // threads every turn.
+  threads::WorkerPool workers_;
+  SnapshotBuffer snapshots_;
+  uint64 snapshot_version_;
+  // Version of the snapshot last passed to UpdateGraphicsInfo; only touched
+  // by the interface thread.
+  uint64 displayed_version_;
+  // Areas that are skipped until woken. An area sleeps when it has no
+  // production or trade and its fields are fully recovered. Units and the AI
+  // change area states only through mutable_area_state, which wakes the area.
+  games::setup::Agenda<util::proto::ObjectId> area_agenda_;
   std::unordered_map<std::string, industry::Production> production_chains_;
-  std::unordered_map<util::proto::ObjectId, std::vector<const units::Unit*>>
-      unitsByAreaId_;
+  // Kept current as units move, so it need only be filled when the world
+  // is loaded.
+  units::UnitIndex unit_index_;
   std::unique_ptr<sevenyears::SevenYearsMerchant> merchant_ai_;
   std::unique_ptr<sevenyears::SevenYearsArmyAi> army_ai_;
   std::unique_ptr<sevenyears::ActionCostCalculator> cost_calculator_;
+  DefaultBattleResolver battle_resolver_;
   std::unique_ptr<sevenyears::SeaMoveObserver> sea_listener_;
   std::unique_ptr<sevenyears::LandMoveObserver> land_listener_;
 };
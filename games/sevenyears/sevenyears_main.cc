@@ -2,6 +2,7 @@
 #define _SILENCE_EXPERIMENTAL_FILESYSTEM_DEPRECATION_WARNING
 #include <experimental/filesystem>
 #include <fstream>
+#include <memory>
 #include <vector>
 
 #include "absl/strings/substitute.h"
@@ -12,6 +13,8 @@
 #include "games/sevenyears/graphics/sdl_interface.h"
 #include "games/sevenyears/proto/sevenyears.pb.h"
 #include "games/sevenyears/sevenyears.h"
+#include "games/sevenyears/simulation_thread.h"
+#include "util/context/context.h"
 #include "util/logging/logging.h"
 #include "util/proto/file.h"
 #include "util/proto/object_id.pb.h"
@@ -89,7 +92,7 @@ loadGraphicsInfo(sevenyears::graphics::SevenYearsInterface* interface) {
 
 class EventHandler : public interface::Receiver {
 public:
-  EventHandler(sevenyears::SevenYears* game) : game_(game), quit_(false) {}
+  EventHandler(sevenyears::SimulationThread* sim) : quit_(false), sim_(sim) {}
 
   void QuitToDesktop() override {
     quit_ = true;
@@ -103,14 +106,14 @@ public:
 
 private:
   bool quit_;
-  sevenyears::SevenYears* game_;
+  sevenyears::SimulationThread* sim_;
 };
 
 void EventHandler::HandleKeyRelease(const SDL_Keysym& keysym) {
   switch (keysym.sym) {
     case SDLK_KP_ENTER:
     case SDLK_RETURN:
-      game_->NewTurn();
+      sim_->RequestTurn();
       break;
     case SDLK_q:
       quit_ = true;
@@ -143,6 +146,9 @@ int main(int /*argc*/, char** /*argv*/) {
   }
 
   sevenYears = new sevenyears::SevenYears();
+  // The interface looks connections up in the game's registries, and the
+  // simulation thread takes the context current when it starts.
+  util::Context::Scope scope(sevenYears->context());
   auto status = sevenYears->InitialiseAI();
   if (!status.ok()) {
     Log::Errorf("Error initialising AI: %s", status.message());
@@ -161,7 +167,11 @@ int main(int /*argc*/, char** /*argv*/) {
 
   games::interface::proto::Config config;
   config.set_screen_size(games::interface::proto::Config::SS_1440_900);
-  EventHandler handler(sevenYears);
+  // Turns run on their own thread; the interface only sees the snapshot
+  // published at the end of each.
+  std::unique_ptr<sevenyears::SimulationThread> sim(
+      new sevenyears::SimulationThread([]() { sevenYears->NewTurn(); }));
+  EventHandler handler(sim.get());
 
   graphics = createInterface();
   graphics->SetReceiver(&handler);
@@ -186,6 +196,8 @@ int main(int /*argc*/, char** /*argv*/) {
     sevenYears->UpdateGraphicsInfo(graphics);
   }
 
+  // Finishes the running turn before the game goes away.
+  sim.reset();
   graphics->Cleanup();
   delete graphics;
   delete sevenYears;
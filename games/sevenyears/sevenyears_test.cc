@@ -1,7 +1,12 @@
 #include "games/sevenyears/sevenyears.h"
 
+#include <unordered_set>
+#include <vector>
+
 #include "absl/strings/substitute.h"
+#include "games/actions/proto/plan.pb.h"
 #include "games/actions/proto/strategy.pb.h"
+#include "games/interface/base.h"
 #include "games/industry/industry.h"
 #include "games/market/goods_utils.h"
 #include "games/setup/setup.h"
@@ -11,7 +16,10 @@
 #include "games/sevenyears/test_utils.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "util/arithmetic/microunits.h"
+#include "util/context/context.h"
 #include "util/logging/logging.h"
+#include "util/proto/object_id.h"
 #include "util/proto/object_id.pb.h"
 #include "util/status/status.h"
 
@@ -28,7 +36,10 @@ protected:
   }
 
   util::Status LoadTestData(const std::string& location) {
+    scope_.reset();
     game_.reset(new SevenYears());
+    // So that the tests can look the game's objects up directly.
+    scope_ = std::make_unique<util::Context::Scope>(game_->context());
     games::setup::proto::ScenarioFiles config;
     PopulateScenarioFiles(location, &config);
     return game_->LoadScenario(config);
@@ -36,6 +47,7 @@ protected:
 
   void EndToEndTest(const std::string& testName, Golden* golds);
   std::unique_ptr<sevenyears::SevenYears> game_;
+  std::unique_ptr<util::Context::Scope> scope_;
 };
 
 void SevenYearsTest::EndToEndTest(const std::string& testName, Golden* golds) {
@@ -57,7 +69,7 @@ void SevenYearsTest::EndToEndTest(const std::string& testName, Golden* golds) {
   for (int stage = 0; stage < numStages; ++stage) {
     game_->NewTurn();
     if (golds->HasAreaStates()) {
-      CheckAreaStatesForStage(*game_, *golds, stage);
+      CheckAreaStatesForStage(game_.get(), *golds, stage);
     }
     if (golds->HasUnits()) {
       CheckUnitStatesForStage(*game_, *golds, stage);
@@ -90,6 +102,79 @@ TEST_F(SevenYearsTest, Executors) {
   }
 }
 
+TEST_F(SevenYearsTest, OwnContext) {
+  auto status = LoadTestData("executors");
+  ASSERT_TRUE(status.ok()) << status.message();
+  const auto& unit_id = game_->World().units_.front()->unit_id();
+  EXPECT_EQ(game_->World().units_.front().get(), units::Unit::ById(unit_id));
+
+  // Nothing was registered in the default context.
+  util::Context::Scope outside(&util::Context::Default());
+  EXPECT_EQ(nullptr, units::Unit::ById(unit_id));
+}
+
+TEST_F(SevenYearsTest, Snapshot) {
+  auto status = LoadTestData("executors");
+  ASSERT_TRUE(status.ok()) << status.message();
+  status = game_->InitialiseAI();
+  ASSERT_TRUE(status.ok()) << status.message();
+
+  auto loaded = game_->Snapshot();
+  ASSERT_TRUE(loaded);
+  ASSERT_FALSE(game_->World().units_.empty());
+  EXPECT_EQ(game_->World().units_.size(), loaded->units.size());
+  EXPECT_EQ(game_->World().areas_.size(), loaded->area_states.size());
+  const auto& unit = *game_->World().units_.front();
+  const std::string before = unit.Proto().DebugString();
+  EXPECT_EQ(before, loaded->units.at(unit.ID()).state->DebugString());
+
+  game_->NewTurn();
+  auto latest = game_->Snapshot();
+  EXPECT_EQ(loaded->version + 1, latest->version);
+  EXPECT_EQ(unit.Proto().DebugString(),
+            latest->units.at(unit.ID()).state->DebugString());
+  // Earlier snapshots do not see the turn.
+  EXPECT_EQ(before, loaded->units.at(unit.ID()).state->DebugString());
+
+  std::vector<util::proto::ObjectId> changed;
+  EXPECT_EQ(latest->version, game_->ChangedSince(loaded->version, &changed));
+  std::unordered_set<util::proto::ObjectId> changed_set(changed.begin(),
+                                                       changed.end());
+  // Everything not listed as changed shares its state with the earlier
+  // snapshot.
+  for (const auto& entry : latest->units) {
+    if (changed_set.count(entry.first) == 0) {
+      EXPECT_EQ(loaded->units.at(entry.first).state, entry.second.state);
+    }
+  }
+  for (const auto& entry : latest->area_states) {
+    if (changed_set.count(entry.first) == 0) {
+      EXPECT_EQ(loaded->area_states.at(entry.first).state,
+                entry.second.state);
+    }
+  }
+  changed.clear();
+  EXPECT_EQ(latest->version, game_->ChangedSince(latest->version, &changed));
+  EXPECT_TRUE(changed.empty());
+
+  // Batches point into the snapshot rather than copying.
+  std::vector<interface::StateView> views;
+  EXPECT_EQ(latest->version,
+            game_->FetchBatch({unit.ID(), util::objectid::New("unit", 999)},
+                              units::proto::Unit::descriptor(), &views));
+  ASSERT_EQ(2, views.size());
+  EXPECT_EQ(latest->units.at(unit.ID()).state.get(), views[0].get());
+  EXPECT_FALSE(views[1]);
+
+  units::proto::Unit fetched;
+  game_->Fetch(unit.ID(), &fetched);
+  EXPECT_EQ(unit.Proto().DebugString(), fetched.DebugString());
+  const auto& area_id = game_->World().areas_.front()->area_id();
+  proto::AreaState area_state;
+  game_->Fetch(area_id, &area_state);
+  EXPECT_EQ(game_->AreaState(area_id).DebugString(), area_state.DebugString());
+}
+
 // End-to-end test for European trade.
 TEST_F(SevenYearsTest, EuropeanTradeE2E) {
   Golden golds;
@@ -105,6 +190,66 @@ TEST_F(SevenYearsTest, ArmySupplyE2E) {
   EndToEndTest("army_supply_e2e", &golds);
 }
 
+// An area with nothing to do sleeps until a unit delivers cargo to it.
+TEST_F(SevenYearsTest, ArrivalWakesArea) {
+  auto status = LoadTestData("executors");
+  ASSERT_TRUE(status.ok()) << status.message();
+  status = game_->InitialiseAI();
+  ASSERT_TRUE(status.ok()) << status.message();
+
+  // Nothing else may touch the area during the turn.
+  for (auto& unit : game_->game_world_->units_) {
+    unit->mutable_strategy()->Clear();
+    unit->mutable_plan()->Clear();
+  }
+  const auto area_id = util::objectid::New("area", 1);
+  game_->area_states_.at(area_id).clear_production();
+  game_->NewTurn();
+  EXPECT_FALSE(game_->area_agenda_.Due(area_id, game_->timestamp() + 1));
+
+  auto* unit = game_->game_world_->units_.front().get();
+  *unit->mutable_location()->mutable_a_area_id() = area_id;
+  unit->mutable_location()->clear_progress_u();
+  unit->AddCargo("supplies", micro::kOneInU);
+  actions::proto::Step step;
+  market::proto::Container delivered;
+  status = game_->offloadCargo(micro::kOneInU, step, unit, &delivered);
+  ASSERT_TRUE(status.ok()) << status.message();
+  EXPECT_EQ(micro::kOneInU, market::GetAmount(delivered, "supplies"));
+  EXPECT_TRUE(game_->area_agenda_.Due(area_id, game_->timestamp() + 1));
+}
+
+// Snapshots share the state of areas nothing has touched.
+TEST_F(SevenYearsTest, SnapshotSharesIdleAreas) {
+  auto status = LoadTestData("executors");
+  ASSERT_TRUE(status.ok()) << status.message();
+  status = game_->InitialiseAI();
+  ASSERT_TRUE(status.ok()) << status.message();
+
+  // Units draw supplies where they are, so they wait elsewhere.
+  for (auto& unit : game_->game_world_->units_) {
+    unit->mutable_strategy()->Clear();
+    unit->mutable_plan()->Clear();
+    *unit->mutable_location()->mutable_a_area_id() =
+        util::objectid::New("area", 2);
+  }
+  const auto area_id = util::objectid::New("area", 1);
+  game_->area_states_.at(area_id).clear_production();
+  game_->NewTurn();
+  auto before = game_->Snapshot();
+  game_->NewTurn();
+  auto after = game_->Snapshot();
+
+  EXPECT_EQ(before->areas.at(area_id).state, after->areas.at(area_id).state);
+  EXPECT_EQ(before->area_states.at(area_id).state,
+            after->area_states.at(area_id).state);
+  std::vector<util::proto::ObjectId> changed;
+  game_->ChangedSince(before->version, &changed);
+  for (const auto& object_id : changed) {
+    EXPECT_FALSE(object_id == area_id);
+  }
+}
+
 // Test for attrition and supply consumption.
 TEST_F(SevenYearsTest, ConsumeSupplies) {
   const std::string testName("attrition");
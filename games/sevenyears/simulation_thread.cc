@@ -0,0 +1,60 @@
+#include "games/sevenyears/simulation_thread.h"
+
+#include <utility>
+
+namespace sevenyears {
+
+SimulationThread::SimulationThread(std::function<void()> turn)
+    : turn_(std::move(turn)), context_(&util::Context::Current()),
+      queued_(0), running_(false), quit_(false), thread_(&SimulationThread::run, this) {}
+
+SimulationThread::~SimulationThread() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    quit_ = true;
+  }
+  wake_.notify_one();
+  thread_.join();
+}
+
+void SimulationThread::RequestTurn() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queued_++;
+  }
+  wake_.notify_one();
+}
+
+bool SimulationThread::Busy() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return running_ || queued_ > 0;
+}
+
+void SimulationThread::WaitIdle() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  idle_.wait(lock, [this] { return !running_ && queued_ == 0; });
+}
+
+void SimulationThread::run() {
+  util::Context::Scope scope(context_);
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    wake_.wait(lock, [this] { return quit_ || queued_ > 0; });
+    if (quit_) {
+      break;
+    }
+    queued_--;
+    running_ = true;
+    lock.unlock();
+    turn_();
+    lock.lock();
+    running_ = false;
+    if (queued_ == 0) {
+      idle_.notify_all();
+    }
+  }
+  queued_ = 0;
+  idle_.notify_all();
+}
+
+}  // namespace sevenyears
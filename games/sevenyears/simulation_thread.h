@@ -0,0 +1,49 @@
+// Runs game turns away from the interface thread.
+#ifndef GAMES_SEVENYEARS_SIMULATION_THREAD_H
+#define GAMES_SEVENYEARS_SIMULATION_THREAD_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "util/context/context.h"
+
+namespace sevenyears {
+
+// Owns a thread that calls a turn function each time a turn is requested,
+// so that the caller can go on drawing while the turn runs. Turns requested
+// while one is running are queued and run in order. Turns run in the
+// util::Context that was current when the thread was created.
+class SimulationThread {
+public:
+  explicit SimulationThread(std::function<void()> turn);
+  // Finishes the running turn, if any, and drops the queued ones.
+  ~SimulationThread();
+
+  // Queues one turn.
+  void RequestTurn();
+
+  // Returns true if a turn is running or queued.
+  bool Busy() const;
+
+  // Blocks until no turn is running or queued.
+  void WaitIdle();
+
+private:
+  void run();
+
+  std::function<void()> turn_;
+  util::Context* context_;
+  mutable std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable idle_;
+  int queued_;
+  bool running_;
+  bool quit_;
+  std::thread thread_;
+};
+
+}  // namespace sevenyears
+
+#endif
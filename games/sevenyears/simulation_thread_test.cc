@@ -0,0 +1,41 @@
+#include "games/sevenyears/simulation_thread.h"
+
+#include <atomic>
+#include <mutex>
+
+#include "gtest/gtest.h"
+
+namespace sevenyears {
+
+TEST(SimulationThreadTest, RunsQueuedTurns) {
+  std::atomic<int> turns(0);
+  SimulationThread thread([&turns]() { turns++; });
+  for (int i = 0; i < 5; ++i) {
+    thread.RequestTurn();
+  }
+  thread.WaitIdle();
+  EXPECT_FALSE(thread.Busy());
+  EXPECT_EQ(5, turns);
+
+  thread.RequestTurn();
+  thread.WaitIdle();
+  EXPECT_EQ(6, turns);
+}
+
+TEST(SimulationThreadTest, CallerNotBlocked) {
+  std::mutex gate;
+  std::unique_lock<std::mutex> hold(gate);
+  int turns = 0;
+  SimulationThread thread([&gate, &turns]() {
+    std::lock_guard<std::mutex> lock(gate);
+    turns++;
+  });
+  // The turn cannot finish until the gate opens, but requesting it returns.
+  thread.RequestTurn();
+  EXPECT_TRUE(thread.Busy());
+  hold.unlock();
+  thread.WaitIdle();
+  EXPECT_EQ(1, turns);
+}
+
+}  // namespace sevenyears
@@ -0,0 +1,115 @@
+#include "games/sevenyears/state_server.h"
+
+#include <utility>
+
+#include "absl/strings/substitute.h"
+
+namespace sevenyears {
+
+StateServer::StateServer(const SevenYearsState* state,
+                         std::function<void()> new_turn)
+    : state_(state), new_turn_(std::move(new_turn)), pass_(0) {
+  proto::StateDelta ignored;
+  changes(&ignored);
+}
+
+bool StateServer::changed(const util::proto::ObjectId& object_id,
+                          const void* source, uint64 generation, bool always) {
+  auto& sent = sent_[object_id];
+  const bool same = sent.pass != 0 && sent.source == source &&
+                    sent.generation == generation && !always;
+  sent.source = source;
+  sent.generation = generation;
+  sent.pass = pass_;
+  return !same;
+}
+
+void StateServer::changes(proto::StateDelta* delta) {
+  ++pass_;
+  delta->set_timestamp(state_->timestamp());
+  for (const auto& area : state_->World().areas_) {
+    const auto& area_id = area->area_id();
+    if (changed(area_id, state_, state_->AreaStateGeneration(area_id),
+                false)) {
+      *delta->add_area_states() = state_->AreaState(area_id);
+    }
+  }
+  for (const auto& unit : state_->World().units_) {
+    // A market may still be filling a shared container, which the generation
+    // does not see.
+    if (unit && changed(unit->ID(), unit.get(), unit->generation(),
+                        unit->resources_shared())) {
+      *delta->add_units() = unit->Proto();
+    }
+  }
+  for (auto sent = sent_.begin(); sent != sent_.end();) {
+    if (sent->second.pass == pass_) {
+      ++sent;
+      continue;
+    }
+    *delta->add_removed_ids() = sent->first;
+    sent = sent_.erase(sent);
+  }
+}
+
+void StateServer::NewTurn(proto::StateDelta* delta) {
+  new_turn_();
+  changes(delta);
+}
+
+void StateServer::Snapshot(proto::StateDelta* delta) const {
+  delta->set_timestamp(state_->timestamp());
+  for (const auto& area : state_->World().areas_) {
+    *delta->add_area_states() = state_->AreaState(area->area_id());
+  }
+  for (const auto& unit : state_->World().units_) {
+    if (unit) {
+      *delta->add_units() = unit->Proto();
+    }
+  }
+}
+
+bool StateServer::addObject(const util::proto::ObjectId& object_id,
+                            proto::StateDelta* delta) const {
+  for (const auto& area : state_->World().areas_) {
+    if (area->area_id() == object_id) {
+      *delta->add_area_states() = state_->AreaState(object_id);
+      return true;
+    }
+  }
+  for (const auto& unit : state_->World().units_) {
+    if (unit && unit->ID() == object_id) {
+      *delta->add_units() = unit->Proto();
+      return true;
+    }
+  }
+  return false;
+}
+
+bool StateServer::Handle(const proto::ServerRequest& request,
+                         proto::StateDelta* delta) {
+  switch (request.kind()) {
+  case proto::ServerRequest::SR_NEW_TURN:
+    NewTurn(delta);
+    return true;
+  case proto::ServerRequest::SR_SNAPSHOT:
+    Snapshot(delta);
+    return false;
+  case proto::ServerRequest::SR_FETCH:
+    delta->set_timestamp(state_->timestamp());
+    for (const auto& object_id : request.object_ids()) {
+      if (!addObject(object_id, delta)) {
+        delta->set_error(absl::Substitute("Unknown object $0",
+                                          util::objectid::DisplayString(
+                                              object_id)));
+      }
+    }
+    return false;
+  default:
+    delta->set_error(
+        absl::Substitute("Unknown request kind $0", request.kind()));
+    return false;
+  }
+}
+
+}  // namespace sevenyears
@@ -0,0 +1,63 @@
+// Transport-independent core of the headless sevenyears server.
+#ifndef GAMES_SEVENYEARS_STATE_SERVER_H
+#define GAMES_SEVENYEARS_STATE_SERVER_H
+
+#include <functional>
+#include <unordered_map>
+
+#include "games/sevenyears/interfaces.h"
+#include "games/sevenyears/proto/server.pb.h"
+#include "util/headers/int_types.h"
+#include "util/proto/object_id.h"
+#include "util/proto/object_id.pb.h"
+
+namespace sevenyears {
+
+// Answers ServerRequests from the state of a running game, and works out
+// which areas and units changed in each turn from their generations, and
+// which went away, against what was last pushed to clients.
+class StateServer {
+public:
+  // The state is read after new_turn returns; both must outlive the server.
+  StateServer(const SevenYearsState* state, std::function<void()> new_turn);
+
+  // Handles request, storing the reply in delta. Returns true if the reply
+  // should be pushed to every client rather than only the requester.
+  bool Handle(const proto::ServerRequest& request, proto::StateDelta* delta);
+
+  // Runs a turn and stores the areas and units that changed or were removed
+  // in delta.
+  void NewTurn(proto::StateDelta* delta);
+
+  // Stores every area and unit in delta.
+  void Snapshot(proto::StateDelta* delta) const;
+
+private:
+  // Adds the object to delta if it is known, returning false otherwise.
+  bool addObject(const util::proto::ObjectId& object_id,
+                 proto::StateDelta* delta) const;
+  // Adds the objects that changed or went away since the last call to delta.
+  void changes(proto::StateDelta* delta);
+
+  // The version of an object that was last pushed.
+  struct Sent {
+    Sent() : source(nullptr), generation(0), pass(0) {}
+    const void* source;
+    uint64 generation;
+    // The last call to changes that saw the object.
+    uint64 pass;
+  };
+  // Returns true if the object has changed since it was last pushed, and
+  // records it as pushed now.
+  bool changed(const util::proto::ObjectId& object_id, const void* source,
+               uint64 generation, bool always);
+
+  const SevenYearsState* state_;
+  std::function<void()> new_turn_;
+  std::unordered_map<util::proto::ObjectId, Sent> sent_;
+  uint64 pass_;
+};
+
+}  // namespace sevenyears
+
+#endif
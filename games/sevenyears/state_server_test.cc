@@ -0,0 +1,172 @@
+#include "games/sevenyears/state_server.h"
+
+#include <vector>
+
+#include "games/interface/base.h"
+#include "games/market/goods_utils.h"
+#include "games/sevenyears/proto/server.pb.h"
+#include "games/sevenyears/proto/sevenyears.pb.h"
+#include "games/sevenyears/remote_game.h"
+#include "games/sevenyears/test_utils.h"
+#include "games/units/unit.h"
+#include "gtest/gtest.h"
+#include "util/proto/object_id.h"
+
+namespace sevenyears {
+
+class StateServerTest : public testing::Test {
+protected:
+  void SetUp() override {
+    units::Unit::ClearTemplates();
+    market::ClearGoods();
+    auto status = state_.Initialise("executors");
+    ASSERT_TRUE(status.ok()) << status.message();
+  }
+
+  proto::ServerRequest request(proto::ServerRequest::Kind kind) {
+    proto::ServerRequest req;
+    req.set_kind(kind);
+    return req;
+  }
+
+  TestState state_;
+};
+
+TEST_F(StateServerTest, Deltas) {
+  const auto area_id = state_.World().areas_[0]->area_id();
+  units::Unit* unit = state_.World().units_[0].get();
+  int turns = 0;
+  StateServer server(&state_, [&]() {
+    ++turns;
+    state_.incrementTime();
+    if (turns == 1) {
+      state_.mutable_area_state(area_id)->add_production("test");
+    } else if (turns == 2) {
+      market::SetAmount("supplies", 1, unit->mutable_resources());
+    }
+  });
+
+  proto::StateDelta delta;
+  EXPECT_FALSE(server.Handle(request(proto::ServerRequest::SR_SNAPSHOT),
+                             &delta));
+  EXPECT_EQ(state_.World().areas_.size(), delta.area_states_size());
+  EXPECT_EQ(state_.World().units_.size(), delta.units_size());
+  DeltaFetcher fetcher;
+  fetcher.Apply(delta);
+  const uint64 start = fetcher.timestamp();
+  const int productions = state_.AreaState(area_id).production_size();
+
+  // Only the area changed.
+  delta.Clear();
+  EXPECT_TRUE(
+      server.Handle(request(proto::ServerRequest::SR_NEW_TURN), &delta));
+  ASSERT_EQ(1, delta.area_states_size());
+  EXPECT_TRUE(area_id == delta.area_states(0).area_id());
+  EXPECT_EQ(0, delta.units_size());
+  const uint64 generation = fetcher.Generation();
+  std::vector<interface::StateView> held;
+  fetcher.FetchBatch({area_id}, proto::AreaState::descriptor(), &held);
+  fetcher.Apply(delta);
+  EXPECT_EQ(start + 1, fetcher.timestamp());
+  proto::AreaState area_state;
+  fetcher.Fetch(area_id, &area_state);
+  EXPECT_EQ(productions + 1, area_state.production_size());
+
+  std::vector<util::proto::ObjectId> changed;
+  EXPECT_EQ(generation + 1, fetcher.ChangedSince(generation, &changed));
+  ASSERT_EQ(1, changed.size());
+  EXPECT_TRUE(area_id == changed[0]);
+  std::vector<interface::StateView> views;
+  EXPECT_EQ(generation + 1,
+            fetcher.FetchBatch({area_id, unit->ID()},
+                               proto::AreaState::descriptor(), &views));
+  ASSERT_EQ(2, views.size());
+  ASSERT_TRUE(views[0]);
+  EXPECT_EQ(productions + 1,
+            static_cast<const proto::AreaState&>(*views[0]).production_size());
+  EXPECT_FALSE(views[1]);
+  // Views from before the delta still see the old state.
+  ASSERT_EQ(1, held.size());
+  EXPECT_EQ(productions,
+            static_cast<const proto::AreaState&>(*held[0]).production_size());
+
+  // Only the unit changed.
+  delta.Clear();
+  server.NewTurn(&delta);
+  EXPECT_EQ(0, delta.area_states_size());
+  ASSERT_EQ(1, delta.units_size());
+  fetcher.Apply(delta);
+  units::proto::Unit fetched;
+  fetcher.Fetch(unit->ID(), &fetched);
+  EXPECT_EQ(1, market::GetAmount(fetched.resources(), "supplies"));
+
+  // Nothing changed.
+  delta.Clear();
+  server.NewTurn(&delta);
+  EXPECT_EQ(0, delta.area_states_size());
+  EXPECT_EQ(0, delta.units_size());
+  EXPECT_EQ(3, turns);
+}
+
+TEST_F(StateServerTest, Removals) {
+  auto& units = state_.mutable_world()->units_;
+  const auto unit_id = units.back()->ID();
+  bool removed = false;
+  StateServer server(&state_, [&]() {
+    state_.incrementTime();
+    if (!removed) {
+      units.pop_back();
+      removed = true;
+    }
+  });
+
+  proto::StateDelta delta;
+  server.Handle(request(proto::ServerRequest::SR_SNAPSHOT), &delta);
+  DeltaFetcher fetcher;
+  fetcher.Apply(delta);
+  std::vector<interface::StateView> views;
+  fetcher.FetchBatch({unit_id}, units::proto::Unit::descriptor(), &views);
+  ASSERT_EQ(1, views.size());
+  EXPECT_TRUE(views[0]);
+
+  delta.Clear();
+  server.NewTurn(&delta);
+  ASSERT_EQ(1, delta.removed_ids_size());
+  EXPECT_TRUE(unit_id == delta.removed_ids(0));
+  EXPECT_EQ(0, delta.units_size());
+  fetcher.Apply(delta);
+  fetcher.FetchBatch({unit_id}, units::proto::Unit::descriptor(), &views);
+  ASSERT_EQ(1, views.size());
+  EXPECT_FALSE(views[0]);
+
+  // Removals are only reported once.
+  delta.Clear();
+  server.NewTurn(&delta);
+  EXPECT_EQ(0, delta.removed_ids_size());
+}
+
+TEST_F(StateServerTest, Fetch) {
+  StateServer server(&state_, []() {});
+  const auto area_id = state_.World().areas_[0]->area_id();
+  const auto unit_id = state_.World().units_[0]->ID();
+  auto req = request(proto::ServerRequest::SR_FETCH);
+  *req.add_object_ids() = area_id;
+  *req.add_object_ids() = unit_id;
+
+  proto::StateDelta delta;
+  EXPECT_FALSE(server.Handle(req, &delta));
+  EXPECT_EQ(1, delta.area_states_size());
+  EXPECT_EQ(1, delta.units_size());
+  EXPECT_FALSE(delta.has_error());
+
+  *req.add_object_ids() = util::objectid::New("nonesuch", 1);
+  delta.Clear();
+  server.Handle(req, &delta);
+  EXPECT_TRUE(delta.has_error());
+
+  delta.Clear();
+  server.Handle(request(proto::ServerRequest::SR_UNKNOWN), &delta);
+  EXPECT_TRUE(delta.has_error());
+}
+
+}  // namespace sevenyears
@@ -5,6 +5,7 @@
 #include <experimental/filesystem>
 
 #include "absl/strings/substitute.h"
+#include "games/actions/plan.h"
 #include "games/industry/industry.h"
 #include "games/setup/setup.h"
 #include "games/sevenyears/proto/sevenyears.pb.h"
@@ -206,6 +207,7 @@ TestState::Initialise(const games::setup::proto::ScenarioFiles& config) {
   for (const auto& as : world_state->area_states()) {
     area_states_[as.area_id()] = as;
   }
+  loadArrivals();
   setTime(world_state->timestamp());
 
   return util::OkStatus();
@@ -239,13 +241,14 @@ TestState::ListUnits(const units::Filter& filter) const {
 }
 
 
-void CheckAreaStatesForStage(const SevenYearsState& got, const Golden& want,
+void CheckAreaStatesForStage(SevenYearsState* got, const Golden& want,
                              int stage) {
   google::protobuf::util::MessageDifferencer differ;
   if (want.area_states_->empty()) {
     EXPECT_FALSE(want.area_states_->empty()) << "No golden area states.";
     return;
   }
+  got->StoreArrivals();
   for (const auto& goldIt : *(want.area_states_)) {
     std::string tag = goldIt.first;
     const auto* goldStateList = goldIt.second;
@@ -255,7 +258,7 @@ void CheckAreaStatesForStage(const SevenYearsState& got, const Golden& want,
     }
     const auto& goldState = goldStateList->states(stage);
     const util::proto::ObjectId& area_id = goldState.area_id();
-    const auto& actual = got.AreaState(area_id);
+    const auto& actual = got->AreaState(area_id);
     EXPECT_TRUE(differ.Equals(goldState, actual))
         << "Stage " << stage << ": " << util::objectid::DisplayString(area_id)
         << ": Golden state " << goldState.DebugString()
@@ -285,11 +288,16 @@ void CheckUnitStatesForStage(const SevenYearsState& got, const Golden& want,
       if (cand->unit_id() != unit_id) {
         continue;
       }
-      EXPECT_TRUE(differ.Equals(goldState, cand->Proto()))
+      // The goldens list only the steps not yet done.
+      units::proto::Unit actual = cand->Proto();
+      if (actual.has_plan()) {
+        actions::CompactPlan(actual.mutable_plan());
+      }
+      EXPECT_TRUE(differ.Equals(goldState, actual))
           << "Stage " << stage << ": " << util::objectid::DisplayString(unit_id)
           << ": Golden state " << goldState.DebugString()
           << "\ndiffers from actual state\n"
-          << cand->Proto().DebugString();
+          << actual.DebugString();
       found = true;
       break;
     }
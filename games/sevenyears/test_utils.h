@@ -45,8 +45,9 @@ util::Status LoadGoldens(const std::string& location, Golden* golds);
 // Returns a filename for the provided object ID.
 const std::string FileTag(const util::proto::ObjectId& obj_id);
 
-// Compares the world state against the golden state for the given stage.
-void CheckAreaStatesForStage(const SevenYearsState& got, const Golden& want,
+// Compares the world state against the golden state for the given stage,
+// after storing the arrivals calendar into the area states.
+void CheckAreaStatesForStage(SevenYearsState* got, const Golden& want,
                              int stage);
 
 // Compares world state against golden unit states for the given stage.
@@ -71,6 +72,9 @@ public:
   // a runnable SevenYears game.
   util::Status PopulateProtos(const games::setup::proto::ScenarioFiles& config);
 
+  // For tests that add or remove objects.
+  games::setup::World* mutable_world() { return game_world_.get(); }
+
 protected:
   games::setup::proto::GameWorld world_proto_;
   games::setup::proto::Scenario scenario_proto_;
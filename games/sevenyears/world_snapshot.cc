@@ -0,0 +1,206 @@
+#include "games/sevenyears/world_snapshot.h"
+
+#include <utility>
+
+namespace sevenyears {
+namespace {
+
+template <typename T>
+using Entries = std::unordered_map<util::proto::ObjectId, SnapshotEntry<T>>;
+
+template <typename T>
+const T* find(const std::unordered_map<util::proto::ObjectId, T>& objects,
+              const util::proto::ObjectId& object_id) {
+  auto object = objects.find(object_id);
+  if (object == objects.end()) {
+    return nullptr;
+  }
+  return &object->second;
+}
+
+template <typename T>
+const T* findState(const Entries<T>& objects,
+                   const util::proto::ObjectId& object_id) {
+  const auto* entry = find(objects, object_id);
+  return entry == nullptr ? nullptr : entry->state.get();
+}
+
+// Points the entry for object_id in objects at the state of object, which is
+// at generation. Shares the entry in previous if it was taken from the same
+// object at the same generation, and copies object otherwise. Returns true if
+// it copied.
+template <typename T>
+bool share(const util::proto::ObjectId& object_id, const void* source,
+           uint64 generation, const T& object, const Entries<T>* previous,
+           Entries<T>* objects) {
+  auto& entry = (*objects)[object_id];
+  const auto* old = previous == nullptr ? nullptr : find(*previous, object_id);
+  if (old != nullptr && old->source == source &&
+      old->generation == generation) {
+    entry = *old;
+    return false;
+  }
+  entry.source = source;
+  entry.generation = generation;
+  entry.state = std::make_shared<const T>(object);
+  return true;
+}
+
+}  // namespace
+
+const google::protobuf::Message*
+WorldSnapshot::Find(const util::proto::ObjectId& object_id,
+                    const google::protobuf::Descriptor* type) const {
+  if (type == proto::AreaState::descriptor()) {
+    return findState(area_states, object_id);
+  }
+  if (type == units::proto::Unit::descriptor()) {
+    return findState(units, object_id);
+  }
+  if (type == geography::proto::Area::descriptor()) {
+    return findState(areas, object_id);
+  }
+  return nullptr;
+}
+
+bool WorldSnapshot::Fetch(const util::proto::ObjectId& object_id,
+                          google::protobuf::Message* proto) const {
+  const auto* object = Find(object_id, proto->GetDescriptor());
+  if (object == nullptr) {
+    return false;
+  }
+  proto->CopyFrom(*object);
+  return true;
+}
+
+void WorldSnapshot::ChangedSince(
+    uint64 since, std::vector<util::proto::ObjectId>* object_ids) const {
+  for (const auto& object : changed) {
+    if (object.second > since) {
+      object_ids->push_back(object.first);
+    }
+  }
+}
+
+void SnapshotFetcher::Fetch(const util::proto::ObjectId& object_id,
+                            google::protobuf::Message* proto) {
+  if (snapshot_) {
+    snapshot_->Fetch(object_id, proto);
+  }
+}
+
+uint64 SnapshotFetcher::Generation() const {
+  return snapshot_ ? snapshot_->version : 0;
+}
+
+uint64 SnapshotFetcher::FetchBatch(
+    const std::vector<util::proto::ObjectId>& object_ids,
+    const google::protobuf::Descriptor* type,
+    std::vector<interface::StateView>* views) {
+  views->clear();
+  if (!snapshot_) {
+    views->resize(object_ids.size());
+    return 0;
+  }
+  views->reserve(object_ids.size());
+  for (const auto& object_id : object_ids) {
+    const auto* object = snapshot_->Find(object_id, type);
+    if (object == nullptr) {
+      views->emplace_back();
+      continue;
+    }
+    // Shares ownership of the whole snapshot, so the view stays valid after
+    // newer ones are published.
+    views->emplace_back(snapshot_, object);
+  }
+  return snapshot_->version;
+}
+
+uint64 SnapshotFetcher::ChangedSince(
+    uint64 generation, std::vector<util::proto::ObjectId>* object_ids) {
+  if (!snapshot_) {
+    return generation;
+  }
+  snapshot_->ChangedSince(generation, object_ids);
+  return snapshot_->version;
+}
+
+void FillSnapshot(const SevenYearsState& state, uint64 version,
+                  const WorldSnapshot* previous, WorldSnapshot* snapshot) {
+  snapshot->version = version;
+  const auto& world = state.World();
+  auto mark = [version, previous, snapshot](const util::proto::ObjectId& id,
+                                            bool changed) {
+    const uint64* old =
+        previous == nullptr ? nullptr : find(previous->changed, id);
+    snapshot->changed[id] = (changed || old == nullptr) ? version : *old;
+  };
+
+  // Assigning over the entries of a recycled snapshot reuses the maps. If a
+  // map ends up larger than the world, some objects have gone away and it is
+  // rebuilt from scratch.
+  auto fillUnits = [&world, previous, snapshot, &mark]() {
+    int num_units = 0;
+    for (const auto& unit : world.units_) {
+      if (unit) {
+        // A market may still be filling a shared container, which the
+        // generation does not see, so such units are always copied.
+        const bool shareable = previous != nullptr && !unit->resources_shared();
+        mark(unit->ID(),
+             share(unit->ID(), unit.get(), unit->generation(), unit->Proto(),
+                   shareable ? &previous->units : nullptr, &snapshot->units));
+        ++num_units;
+      }
+    }
+    return num_units;
+  };
+  auto fillAreas = [&state, &world, previous, snapshot, &mark]() {
+    for (const auto& area_ptr : world.areas_) {
+      // Through a const reference; the mutable Proto counts as a change.
+      const geography::Area& area = *area_ptr;
+      const auto& area_id = area.area_id();
+      const bool area_changed =
+          share(area_id, &area, area.generation(), *area.Proto(),
+                previous ? &previous->areas : nullptr, &snapshot->areas);
+      const bool state_changed =
+          share(area_id, &state, state.AreaStateGeneration(area_id),
+                state.AreaState(area_id),
+                previous ? &previous->area_states : nullptr,
+                &snapshot->area_states);
+      mark(area_id, area_changed || state_changed);
+    }
+  };
+
+  const int num_units = fillUnits();
+  fillAreas();
+  if (snapshot->units.size() > num_units ||
+      snapshot->areas.size() > world.areas_.size()) {
+    snapshot->units.clear();
+    snapshot->areas.clear();
+    snapshot->area_states.clear();
+    snapshot->changed.clear();
+    fillUnits();
+    fillAreas();
+  }
+}
+
+std::shared_ptr<WorldSnapshot> SnapshotBuffer::Back() {
+  if (back_ && back_.use_count() == 1) {
+    return std::move(back_);
+  }
+  back_.reset();
+  return std::make_shared<WorldSnapshot>();
+}
+
+void SnapshotBuffer::Publish(std::shared_ptr<WorldSnapshot> snapshot) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  back_.swap(front_);
+  front_.swap(snapshot);
+}
+
+std::shared_ptr<const WorldSnapshot> SnapshotBuffer::Latest() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return front_;
+}
+
+}  // namespace sevenyears
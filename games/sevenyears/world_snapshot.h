@@ -0,0 +1,129 @@
+// Read-only copies of game state for the interface.
+#ifndef GAMES_SEVENYEARS_WORLD_SNAPSHOT_H
+#define GAMES_SEVENYEARS_WORLD_SNAPSHOT_H
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "games/geography/proto/geography.pb.h"
+#include "games/interface/base.h"
+#include "games/sevenyears/interfaces.h"
+#include "games/sevenyears/proto/sevenyears.pb.h"
+#include "games/units/proto/units.pb.h"
+#include "util/headers/int_types.h"
+#include "util/proto/object_id.h"
+#include "util/proto/object_id.pb.h"
+#include "src/google/protobuf/descriptor.h"
+#include "src/google/protobuf/message.h"
+
+namespace sevenyears {
+
+// The state of one object in a snapshot, with the live object it was copied
+// from and that object's generation at the time. Snapshots share the state
+// of objects whose generation has not changed.
+template <typename T> struct SnapshotEntry {
+  SnapshotEntry() : source(nullptr), generation(0) {}
+  const void* source;
+  uint64 generation;
+  std::shared_ptr<const T> state;
+};
+
+// The state the interface draws - unit locations and plans, areas, owners
+// and warehouses - as of the end of one turn. Never changed once published.
+struct WorldSnapshot {
+  WorldSnapshot() : version(0) {}
+
+  // Returns the state of object_id as a message of type, or null if the
+  // snapshot has no such object.
+  const google::protobuf::Message*
+  Find(const util::proto::ObjectId& object_id,
+       const google::protobuf::Descriptor* type) const;
+
+  // Copies the state of object_id into proto if the snapshot has an object
+  // of that id and message type, returning false otherwise.
+  bool Fetch(const util::proto::ObjectId& object_id,
+             google::protobuf::Message* proto) const;
+
+  // Adds to object_ids the objects that appeared or changed after version.
+  void ChangedSince(uint64 version,
+                    std::vector<util::proto::ObjectId>* object_ids) const;
+
+  uint64 version;
+  std::unordered_map<util::proto::ObjectId, SnapshotEntry<units::proto::Unit>>
+      units;
+  std::unordered_map<util::proto::ObjectId,
+                     SnapshotEntry<geography::proto::Area>>
+      areas;
+  std::unordered_map<util::proto::ObjectId, SnapshotEntry<proto::AreaState>>
+      area_states;
+  // The version in which each object was last copied, which is the last in
+  // which it may have changed. An area counts as changed if either its Area
+  // or its AreaState did.
+  std::unordered_map<util::proto::ObjectId, uint64> changed;
+};
+
+// Overwrites snapshot with the current contents of state. Objects whose
+// generation is the same as in previous, if not null, share its copy and
+// count as unchanged; the others are copied.
+void FillSnapshot(const SevenYearsState& state, uint64 version,
+                  const WorldSnapshot* previous, WorldSnapshot* snapshot);
+
+// Serves the states in one snapshot, whose version is the generation, however
+// many are published after it. Readers that make several calls and need them
+// to agree, such as one frame of drawing, should use one of these rather than
+// a fetcher that follows the latest snapshot.
+class SnapshotFetcher : public interface::StateFetcher {
+public:
+  explicit SnapshotFetcher(std::shared_ptr<const WorldSnapshot> snapshot)
+      : snapshot_(std::move(snapshot)) {}
+
+  void Fetch(const util::proto::ObjectId& object_id,
+             google::protobuf::Message* proto) override;
+  uint64 Generation() const override;
+  uint64 FetchBatch(const std::vector<util::proto::ObjectId>& object_ids,
+                    const google::protobuf::Descriptor* type,
+                    std::vector<interface::StateView>* views) override;
+  uint64 ChangedSince(uint64 generation,
+                      std::vector<util::proto::ObjectId>* object_ids) override;
+
+private:
+  // May be null, in which case nothing is found.
+  std::shared_ptr<const WorldSnapshot> snapshot_;
+};
+
+// Holds the most recently published snapshot. There is one writer, which
+// fills the buffer returned by Back and then publishes it; any number of
+// readers may call Latest from other threads. Publishing swaps a pointer, so
+// readers never wait for a snapshot to be built, and a reader holding an
+// older snapshot keeps it alive and unchanged until it lets go.
+class SnapshotBuffer {
+public:
+  // Returns a snapshot for the writer to fill. This is the one retired by
+  // the previous Publish if no reader still holds it, so that its memory is
+  // reused; otherwise it is new.
+  std::shared_ptr<WorldSnapshot> Back();
+
+  // Returns the latest published snapshot, for the writer to compare
+  // against; unlike Latest this does not lock.
+  const WorldSnapshot* Front() const { return front_.get(); }
+
+  // Makes snapshot the latest one and retires the previous latest.
+  void Publish(std::shared_ptr<WorldSnapshot> snapshot);
+
+  // Returns the latest published snapshot, or null if there is none.
+  std::shared_ptr<const WorldSnapshot> Latest() const;
+
+private:
+  mutable std::mutex mutex_;
+  std::shared_ptr<WorldSnapshot> front_;
+  // Only touched by the writer, and unreachable through Latest, so once no
+  // reader holds it nobody else can start to.
+  std::shared_ptr<WorldSnapshot> back_;
+};
+
+}  // namespace sevenyears
+
+#endif
@@ -0,0 +1,114 @@
+#include "games/sevenyears/world_snapshot.h"
+
+#include <memory>
+#include <vector>
+
+#include "games/sevenyears/proto/sevenyears.pb.h"
+#include "games/units/proto/units.pb.h"
+#include "gtest/gtest.h"
+#include "util/proto/object_id.h"
+
+namespace sevenyears {
+
+TEST(WorldSnapshotTest, Fetch) {
+  WorldSnapshot snapshot;
+  const auto area_id = util::objectid::New("area", 1);
+  const auto owner_id = util::objectid::New("faction", 1);
+  const auto unit_id = util::objectid::New("schooner", 1);
+  proto::AreaState area_state;
+  *area_state.mutable_owner_id() = owner_id;
+  snapshot.area_states[area_id].state =
+      std::make_shared<const proto::AreaState>(area_state);
+  units::proto::Unit unit_state;
+  *unit_state.mutable_unit_id() = unit_id;
+  snapshot.units[unit_id].state =
+      std::make_shared<const units::proto::Unit>(unit_state);
+
+  proto::AreaState state;
+  EXPECT_TRUE(snapshot.Fetch(area_id, &state));
+  EXPECT_TRUE(owner_id == state.owner_id());
+  units::proto::Unit unit;
+  EXPECT_TRUE(snapshot.Fetch(unit_id, &unit));
+  EXPECT_TRUE(unit_id == unit.unit_id());
+
+  // Wrong kind of message for the id.
+  EXPECT_FALSE(snapshot.Fetch(area_id, &unit));
+  EXPECT_FALSE(snapshot.Fetch(util::objectid::New("area", 2), &state));
+}
+
+TEST(WorldSnapshotTest, Publish) {
+  SnapshotBuffer buffer;
+  EXPECT_FALSE(buffer.Latest());
+
+  auto first = buffer.Back();
+  first->version = 1;
+  WorldSnapshot* first_address = first.get();
+  buffer.Publish(std::move(first));
+  auto held = buffer.Latest();
+  ASSERT_TRUE(held);
+  EXPECT_EQ(1, held->version);
+
+  auto second = buffer.Back();
+  WorldSnapshot* second_address = second.get();
+  EXPECT_NE(first_address, second_address);
+  second->version = 2;
+  buffer.Publish(std::move(second));
+  EXPECT_EQ(2, buffer.Latest()->version);
+
+  // The first snapshot is still held, so it is neither reused nor changed.
+  auto third = buffer.Back();
+  EXPECT_NE(first_address, third.get());
+  EXPECT_NE(second_address, third.get());
+  third->version = 3;
+  buffer.Publish(std::move(third));
+  EXPECT_EQ(1, held->version);
+
+  // Nobody holds the second, so the writer gets it back.
+  held.reset();
+  auto fourth = buffer.Back();
+  EXPECT_EQ(second_address, fourth.get());
+  EXPECT_EQ(3, buffer.Latest()->version);
+}
+
+TEST(WorldSnapshotTest, PinnedFetcher) {
+  SnapshotBuffer buffer;
+  const auto unit_id = util::objectid::New("schooner", 1);
+  auto first = buffer.Back();
+  first->version = 1;
+  buffer.Publish(std::move(first));
+  SnapshotFetcher frame(buffer.Latest());
+
+  // A unit that first appears in the next snapshot.
+  auto second = buffer.Back();
+  second->version = 2;
+  units::proto::Unit unit_state;
+  *unit_state.mutable_unit_id() = unit_id;
+  second->units[unit_id].state =
+      std::make_shared<const units::proto::Unit>(unit_state);
+  second->changed[unit_id] = 2;
+  buffer.Publish(std::move(second));
+
+  // The frame still sees only the first.
+  std::vector<util::proto::ObjectId> changed;
+  EXPECT_EQ(1, frame.ChangedSince(0, &changed));
+  EXPECT_TRUE(changed.empty());
+  std::vector<interface::StateView> views;
+  EXPECT_EQ(1, frame.FetchBatch({unit_id}, units::proto::Unit::descriptor(),
+                                &views));
+  ASSERT_EQ(1, views.size());
+  EXPECT_FALSE(views[0]);
+
+  // So the next frame, starting from generation 1, finds the new unit.
+  SnapshotFetcher next(buffer.Latest());
+  EXPECT_EQ(2, next.ChangedSince(frame.Generation(), &changed));
+  ASSERT_EQ(1, changed.size());
+  EXPECT_TRUE(unit_id == changed[0]);
+  EXPECT_EQ(2, next.FetchBatch(changed, units::proto::Unit::descriptor(),
+                               &views));
+  ASSERT_EQ(1, views.size());
+  EXPECT_TRUE(views[0]);
+
+  EXPECT_EQ(0, SnapshotFetcher(nullptr).Generation());
+}
+
+}  // namespace sevenyears
@@ -1,15 +1,22 @@
 #include "games/sinews/game_world.h"
 
+#include <cstdlib>
+#include <unordered_set>
+#include <vector>
+
+#include "games/actions/plan.h"
 #include "games/actions/proto/plan.pb.h"
 #include "games/actions/proto/strategy.pb.h"
 #include "games/ai/executer.h"
 #include "games/ai/planner.h"
+#include "games/geography/chain_index.h"
 #include "games/geography/geography.h"
 #include "games/industry/decisions/production_evaluator.h"
 #include "games/industry/worker.h"
 #include "games/market/goods_utils.h"
 #include "games/units/unit.h"
 #include "util/arithmetic/microunits.h"
+#include "util/context/context.h"
 #include "util/logging/logging.h"
 #include "util/status/status.h"
 
@@ -19,19 +26,49 @@ using industry::decisions::ProductionContext;
 namespace game {
 namespace {
 
-class PossibilityFilter : public industry::ProductionFilter {
-public:
-  bool Filter(const geography::proto::Field& field,
-              const industry::Production& prod) const {
-    if (!geography::HasLandType(field, prod)) {
+// Relative change in a price that is tolerated before cached production
+// candidates are recalculated. Resources and capital get no tolerance, since
+// chain eligibility is a strict threshold on them.
+constexpr micro::Measure kCacheToleranceU = micro::kOneInU / 20;
+
+// Returns true if any amount in current differs from the cached amount by more
+// than the tolerance, or has appeared or disappeared altogether.
+bool MovedBeyondTolerance(const market::proto::Container& cached,
+                          const market::proto::Container& current) {
+  for (const auto& good : current.quantities()) {
+    micro::Measure old_u = market::GetAmount(cached, good.first);
+    if ((old_u > 0) != (good.second > 0)) {
+      return true;
+    }
+    micro::Measure diff_u = std::abs(good.second - old_u);
+    if (diff_u > micro::MultiplyU(std::abs(old_u), kCacheToleranceU)) {
+      return true;
+    }
+  }
+  for (const auto& good : cached.quantities()) {
+    if (good.second > 0 && !market::Contains(current, good.first)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Returns true if every good has the same amount in both containers, treating
+// absent goods as zero.
+bool SameAmounts(const market::proto::Container& cached,
+                 const market::proto::Container& current) {
+  for (const auto& good : current.quantities()) {
+    if (market::GetAmount(cached, good.first) != good.second) {
       return false;
     }
-    if (!geography::HasRawMaterials(field, prod)) {
+  }
+  for (const auto& good : cached.quantities()) {
+    if (market::GetAmount(current, good.first) != good.second) {
       return false;
     }
-    return true;
   }
-};
+  return true;
+}
 
 void PrintMarket(const market::proto::MarketProto& market,
                  const market::proto::Container& volumes) {
@@ -49,7 +86,8 @@ void PrintMarket(const market::proto::MarketProto& market,
 // Selects and runs production processes for each field until no fields make
 // progress.
 void RunAreaIndustry(
-    std::unordered_map<population::PopUnit*, ProductionContext>* contexts) {
+    std::unordered_map<population::PopUnit*, ProductionContext>* contexts,
+    industry::BatchEvaluator* evaluator) {
 
   std::unordered_set<Field*> progressed;
   std::unordered_map<Field*, int> attempts;
@@ -69,7 +107,7 @@ void RunAreaIndustry(
         if (progressed.count(field) != 0) {
           continue;
         }
-        industry::CalculateProductionScale(pop->wealth(), &context, field);
+        evaluator->CalculateProductionScale(pop->wealth(), &context, field);
         info.evaluator->SelectCandidate(&context, field);
 
         const auto& decision = info.decision;
@@ -154,6 +192,11 @@ void RunAreaIndustry(
 } // namespace
 
 GameWorld::~GameWorld() {
+  // Objects unregister themselves from the current context as they go.
+  util::Context::Scope scope(&context_);
+  area_caches_.clear();
+  production_evaluators_.clear();
+  world_state_.reset();
   for (auto& production : production_map_) {
     delete production.second;
   }
@@ -162,22 +205,145 @@ GameWorld::~GameWorld() {
 
 GameWorld::GameWorld(const games::setup::proto::GameWorld& world,
                      const games::setup::proto::Scenario& scenario)
-    : default_evaluator_(new industry::decisions::LocalProfitMaximiser()) {
+    : default_evaluator_(new industry::decisions::LocalProfitMaximiser()),
+      recalculated_fields_(0), reused_fields_(0) {
+  util::Context::Scope scope(&context_);
   constants_ = std::make_unique<games::setup::Constants>(scenario);
   world_state_ = games::setup::World::FromProto(world);
 
   for (const auto& prod_proto : constants_->production_chains_) {
-    production_map_.emplace(prod_proto.name(),
-                            new industry::Production(prod_proto));
+    auto* chain = new industry::Production(prod_proto);
+    production_map_.emplace(prod_proto.name(), chain);
+    chain_index_.Add(*chain);
     chain_names_.push_back(prod_proto.name());
   }
+  batch_evaluator_ =
+      std::make_unique<industry::BatchEvaluator>(production_map_);
+  for (auto& area : world_state_->areas_) {
+    // Settled in TimeStep once trading is over.
+    area->mutable_market()->DeferCredit(true);
+  }
+}
+
+void GameWorld::updateContexts(geography::Area* area, AreaCache* cache) {
+  auto* market = area->mutable_market();
+
+  // A general price movement invalidates every candidate in the area.
+  const auto& prices_u = market->Proto()->prices_u();
+  bool prices_moved = MovedBeyondTolerance(cache->prices_u, prices_u);
+  if (prices_moved) {
+    cache->prices_u = prices_u;
+  }
+
+  std::vector<const industry::Production*> eligible;
+  // Owned fields and their owners, so that the cache can be pruned of fields
+  // and pops that have gone.
+  std::unordered_set<Field*> present;
+  std::unordered_set<population::PopUnit*> owners;
+  for (auto& field : *area->Proto()->mutable_fields()) {
+    auto* pop = population::PopUnit::GetPopId(field.owner_id());
+    auto cached = cache->fields.find(&field);
+    if (cached != cache->fields.end() && cached->second.owner != pop) {
+      auto old_context = cache->contexts.find(cached->second.owner);
+      if (old_context != cache->contexts.end()) {
+        old_context->second.fields.erase(&field);
+      }
+      cache->fields.erase(cached);
+      cached = cache->fields.end();
+    }
+    if (pop == nullptr) {
+      continue;
+    }
+    present.insert(&field);
+    owners.insert(pop);
+
+    auto& context = cache->contexts[pop];
+    context.production_map = &production_map_;
+    context.market = market;
+    auto& field_info = context.fields[&field];
+    if (production_evaluators_.find(&field) != production_evaluators_.end()) {
+      field_info.evaluator = production_evaluators_[&field];
+    } else {
+      field_info.evaluator = default_evaluator_;
+    }
+
+    if (cached != cache->fields.end() && !prices_moved) {
+      const FieldCache& old = cached->second;
+      bool changed = old.land_type != field.land_type() ||
+                     old.progress_name != field.progress().name() ||
+                     old.progress_step != field.progress().step() ||
+                     old.progress_scaling_u != field.progress().scaling_u() ||
+                     old.progress_efficiency_u !=
+                         field.progress().efficiency_u() ||
+                     !SameAmounts(old.resources, field.resources()) ||
+                     !SameAmounts(old.fixed_capital, field.fixed_capital());
+      if (!changed) {
+        ++reused_fields_;
+        continue;
+      }
+    }
+    ++recalculated_fields_;
+
+    FieldCache& snapshot = cache->fields[&field];
+    snapshot.owner = pop;
+    snapshot.land_type = field.land_type();
+    snapshot.resources = field.resources();
+    snapshot.fixed_capital = field.fixed_capital();
+    snapshot.progress_name = field.progress().name();
+    snapshot.progress_step = field.progress().step();
+    snapshot.progress_scaling_u = field.progress().scaling_u();
+    snapshot.progress_efficiency_u = field.progress().efficiency_u();
+
+    field_info.candidates.clear();
+    eligible.clear();
+    chain_index_.Eligible(field, &eligible);
+    for (const industry::Production* prod : eligible) {
+      field_info.candidates.emplace_back(
+          std::make_unique<industry::decisions::proto::ProductionInfo>());
+      field_info.candidates.back()->set_name(prod->get_name());
+    }
+    batch_evaluator_->CalculateProductionCosts(*market, field,
+                                               &field_info.candidates);
+  }
+
+  for (auto it = cache->fields.begin(); it != cache->fields.end();) {
+    if (present.count(it->first) == 0) {
+      it = cache->fields.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  for (auto it = cache->contexts.begin(); it != cache->contexts.end();) {
+    if (owners.count(it->first) == 0) {
+      it = cache->contexts.erase(it);
+      continue;
+    }
+    auto& fields = it->second.fields;
+    for (auto field = fields.begin(); field != fields.end();) {
+      if (present.count(field->first) == 0) {
+        field = fields.erase(field);
+      } else {
+        ++field;
+      }
+    }
+    ++it;
+  }
+}
+
+int GameWorld::cached_fields() const {
+  int count = 0;
+  for (const auto& area_cache : area_caches_) {
+    count += area_cache.second.fields.size();
+  }
+  return count;
 }
 
 void GameWorld::TimeStep(
     industry::decisions::FieldMap<
         industry::decisions::proto::ProductionDecision>* decisions) {
-  static PossibilityFilter possible;
-
+  util::Context::Scope scope(&context_);
+  recalculated_fields_ = 0;
+  reused_fields_ = 0;
   for (auto& area : world_state_->areas_) {
     auto* market = area->mutable_market();
     for (const auto pop_id : area->Proto()->pop_ids()) {
@@ -189,39 +355,14 @@ void GameWorld::TimeStep(
       pop->AutoProduce(constants_->auto_production_, market);
     }
 
-    std::unordered_map<population::PopUnit*, ProductionContext> contexts;
-    for (auto& field : *area->Proto()->mutable_fields()) {
-      auto* pop = population::PopUnit::GetPopId(field.owner_id());
-      if (pop == nullptr) {
-        continue;
-      }
-      if (contexts.find(pop) == contexts.end()) {
-        contexts[pop].production_map = &production_map_;
-        contexts[pop].market = market;
-        contexts[pop].fields[&field] = industry::decisions::FieldInfo();
-      }
-      if (production_evaluators_.find(&field) != production_evaluators_.end()) {
-        contexts[pop].fields[&field].evaluator = production_evaluators_[&field];
-      } else {
-        contexts[pop].fields[&field].evaluator = default_evaluator_;
-      }
-
-      for (const auto& chain : production_map_) {
-        const industry::Production& prod = *chain.second;
-        if (!possible.Filter(field, prod)) {
-          continue;
-        }
-
-        auto& field_info = contexts[pop].fields[&field];
-        field_info.candidates.emplace_back(
-            std::make_unique<industry::decisions::proto::ProductionInfo>());
-        auto* info = field_info.candidates.back().get();
-        info->set_name(chain.first);
-        industry::CalculateProductionCosts(prod, *market, field, info);
+    auto& cache = area_caches_[area.get()];
+    updateContexts(area.get(), &cache);
+    for (auto& pop_context : cache.contexts) {
+      for (auto& field_info : pop_context.second.fields) {
+        field_info.second.decision.Clear();
       }
     }
-
-    RunAreaIndustry(&contexts);
+    RunAreaIndustry(&cache.contexts, batch_evaluator_.get());
 
     // Copy decisions into output map.
     for (auto& field : *area->Proto()->mutable_fields()) {
@@ -229,7 +370,7 @@ void GameWorld::TimeStep(
       if (pop == nullptr) {
         continue;
       }
-      decisions->emplace(&field, contexts[pop].fields[&field].decision);
+      decisions->emplace(&field, cache.contexts[pop].fields[&field].decision);
     }
   }
 
@@ -242,20 +383,28 @@ void GameWorld::TimeStep(
       continue;
     }
     actions::proto::Plan* plan = unit->mutable_plan();
-    if (plan->steps_size() == 0) {
+    if (actions::StepsLeft(*plan) == 0) {
       // TODO: Handle bad status here.
       ai::MakePlan(*unit, unit->strategy(), plan);
     }
   }
 
-  // Execute in single steps.
+  // Execute in single steps, all units with steps left at once.
+  std::vector<units::Unit*> acting;
+  std::vector<util::LazyStatus> statuses;
   while (true) {
     int count = 0;
+    acting.clear();
     for (auto& unit : world_state_->units_) {
-      if (unit->plan().steps().empty()) {
+      if (actions::StepsLeft(unit->plan()) == 0) {
         continue;
       }
-      auto status = ai::ExecuteStep(unit->plan(), unit.get());
+      acting.push_back(unit.get());
+    }
+    ai::ExecuteSteps(acting, &statuses);
+    for (int i = 0; i < acting.size(); ++i) {
+      auto* unit = acting[i];
+      const auto& status = statuses[i];
       if (status.ok()) {
         ai::DeleteStep(unit->mutable_plan());
         ++count;
@@ -284,6 +433,11 @@ void GameWorld::TimeStep(
     }
   }
 
+  // Trading is over, so credit is settled before anything that looks at
+  // the traders' balances.
+  for (auto& area : world_state_->areas_) {
+    area->mutable_market()->SettleCredit();
+  }
   for (auto& pop : world_state_->pops_) {
     pop->EndTurn(constants_->decay_rates_);
   }
@@ -298,15 +452,22 @@ void GameWorld::TimeStep(
                         constants_->decay_rates_);
     }
   }
+  // The markets have dropped their offers, so no longer hold unit cargo.
+  for (auto& unit : world_state_->units_) {
+    unit->ReleaseResources();
+  }
 }
 
 void GameWorld::SaveToProto(games::setup::proto::GameWorld* proto) const {
+  // Restoring tags reads the world's tag registry.
+  util::Context::Scope scope(&context_);
   world_state_->ToProto(proto);
 }
 
 void GameWorld::SetProductionEvaluator(
     const util::proto::ObjectId& area_id, uint64 field_idx,
     industry::decisions::ProductionEvaluator* eval) {
+  util::Context::Scope scope(&context_);
   geography::Area* area = geography::Area::GetById(area_id);
   if (area == NULL) {
     // TODO: Maybe a better handling?
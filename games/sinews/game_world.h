@@ -9,24 +9,36 @@
 #include "games/factions/proto/factions.pb.h"
 #include "games/setup/proto/setup.pb.h"
 #include "games/setup/setup.h"
+#include "games/geography/chain_index.h"
 #include "games/geography/connection.h"
 #include "games/geography/geography.h"
 #include "games/geography/proto/geography.pb.h"
 #include "games/industry/decisions/production_evaluator.h"
 #include "games/industry/proto/industry.pb.h"
+#include "games/industry/worker.h"
+#include "games/market/proto/goods.pb.h"
 #include "games/population/popunit.h"
 #include "games/population/proto/population.pb.h"
 #include "games/units/unit.h"
+#include "util/arithmetic/microunits.h"
+#include "util/context/context.h"
 #include "util/proto/object_id.pb.h"
 
 namespace game {
 
+// Each GameWorld keeps its goods, areas, units and other registries in a
+// util::Context of its own, which its methods make current while they run, so
+// that several worlds can be simulated in one process. Callers that look
+// objects up in the registries themselves should hold a Scope for context().
 class GameWorld {
 public:
   GameWorld(const games::setup::proto::GameWorld& world,
             const games::setup::proto::Scenario& scenario);
   ~GameWorld();
 
+  // The context holding this world's registries.
+  util::Context* context() { return &context_; }
+
   // Sets the production evaluator for the field.
   void SetProductionEvaluator(const util::proto::ObjectId& area_id,
                               uint64 field_idx,
@@ -50,11 +62,25 @@ public:
     return *(production_map_.at(name));
   }
 
+  // Returns the index of chains by the field properties they require.
+  const geography::ChainIndex& chain_index() const { return chain_index_; }
+
+  // Number of fields whose production candidates were recalculated, and
+  // reused from the previous turn, in the last TimeStep.
+  int recalculated_fields() const { return recalculated_fields_; }
+  int reused_fields() const { return reused_fields_; }
+  // Number of fields with production state carried between turns.
+  int cached_fields() const;
+
   // Access the underlying data.
   const games::setup::World& World() const { return *world_state_; }
   games::setup::World* mutable_world() { return world_state_.get(); }
 
 private:
+  // Declared first so that it outlives everything registered in it. Mutable,
+  // since making it current does not change the world.
+  mutable util::Context context_;
+
   // Setup information that does not change in the simulation.
   std::unique_ptr<games::setup::Constants> constants_;
 
@@ -62,6 +88,37 @@ private:
   std::unique_ptr<games::setup::World> world_state_;
   std::unordered_map<std::string, const industry::Production*> production_map_;
   industry::decisions::ProductionEvaluator* default_evaluator_;
+  geography::ChainIndex chain_index_;
+  std::unique_ptr<industry::BatchEvaluator> batch_evaluator_;
+
+  // Production state carried between turns, so that candidate chains and their
+  // costs are only recalculated when the inputs to them change.
+  struct FieldCache {
+    population::PopUnit* owner;
+    int land_type;
+    market::proto::Container resources;
+    market::proto::Container fixed_capital;
+    std::string progress_name;
+    int progress_step;
+    micro::Measure progress_scaling_u;
+    micro::Measure progress_efficiency_u;
+  };
+  struct AreaCache {
+    std::unordered_map<population::PopUnit*,
+                       industry::decisions::ProductionContext>
+        contexts;
+    std::unordered_map<geography::proto::Field*, FieldCache> fields;
+    // Prices at the time the candidate costs were last calculated.
+    market::proto::Container prices_u;
+  };
+
+  // Updates the contexts of the area, recalculating candidates for fields
+  // whose chain inputs have changed.
+  void updateContexts(geography::Area* area, AreaCache* cache);
+
+  std::unordered_map<geography::Area*, AreaCache> area_caches_;
+  int recalculated_fields_;
+  int reused_fields_;
 
   // Player information.
   std::unordered_map<geography::proto::Field*,
@@ -13,6 +13,7 @@
 #include "games/industry/proto/decisions.pb.h"
 #include "games/market/goods_utils.h"
 #include "gtest/gtest.h"
+#include "util/arithmetic/microunits.h"
 #include "util/logging/logging.h"
 #include "util/proto/file.h"
 #include "util/status/status.h"
@@ -131,4 +132,79 @@ TEST_F(EconomyTest, TestTradingSteadyState) {
                            << world_proto_.DebugString();
 }
 
+TEST_F(EconomyTest, TestProductionCache) {
+  auto status = LoadTestData("simple");
+  ASSERT_TRUE(status.ok()) << status.ToString();
+  game::GameWorld game_world(world_proto_, scenario_);
+  std::unordered_map<geography::proto::Field*,
+                     industry::decisions::proto::ProductionDecision>
+      production_info;
+  auto* area = game_world.mutable_world()->areas_[0].get();
+  auto* fields = area->Proto()->mutable_fields();
+
+  // Nothing is cached on the first turn.
+  game_world.TimeStep(&production_info);
+  const int owned = game_world.cached_fields();
+  EXPECT_GT(owned, 0);
+  EXPECT_EQ(owned, game_world.recalculated_fields());
+  EXPECT_EQ(0, game_world.reused_fields());
+
+  // A resource no chain uses, so that changing it changes nothing else.
+  for (auto& field : *fields) {
+    market::Add("mana", micro::kOneInU * 1000, field.mutable_resources());
+  }
+  production_info.clear();
+  game_world.TimeStep(&production_info);
+  EXPECT_EQ(owned, game_world.recalculated_fields());
+
+  // Fields nobody worked keep their candidates.
+  production_info.clear();
+  game_world.TimeStep(&production_info);
+  EXPECT_GT(game_world.reused_fields(), 0);
+  EXPECT_EQ(owned,
+            game_world.reused_fields() + game_world.recalculated_fields());
+
+  // Resource changes far below the price tolerance still count, since they
+  // may cross a chain's raw-material threshold.
+  for (auto& field : *fields) {
+    market::Add("mana", 1, field.mutable_resources());
+  }
+  production_info.clear();
+  game_world.TimeStep(&production_info);
+  EXPECT_EQ(owned, game_world.recalculated_fields());
+  EXPECT_EQ(0, game_world.reused_fields());
+
+  // A change of scale alone counts, even when the chain and step are the same.
+  production_info.clear();
+  game_world.TimeStep(&production_info);
+  const int quiet = game_world.recalculated_fields();
+  geography::proto::Field* idle = nullptr;
+  for (auto& field : *fields) {
+    if (field.owner_id() != 0 && !field.has_progress()) {
+      idle = &field;
+    }
+  }
+  ASSERT_NE(nullptr, idle);
+  idle->mutable_progress()->set_scaling_u(micro::kOneInU);
+  production_info.clear();
+  game_world.TimeStep(&production_info);
+  EXPECT_EQ(quiet + 1, game_world.recalculated_fields());
+  idle->clear_progress();
+
+  // Fields that are gone are dropped from the cache.
+  int removed = 0;
+  for (int i = fields->size() - 1; i >= 0; --i) {
+    if (fields->Get(i).owner_id() != 0) {
+      fields->SwapElements(i, fields->size() - 1);
+      fields->RemoveLast();
+      ++removed;
+      break;
+    }
+  }
+  ASSERT_EQ(1, removed);
+  production_info.clear();
+  game_world.TimeStep(&production_info);
+  EXPECT_EQ(owned - 1, game_world.cached_fields());
+}
+
 } // namespace simple_economy_test
@@ -4,15 +4,24 @@
 
 #include "games/market/goods_utils.h"
 #include "util/arithmetic/microunits.h"
+#include "util/context/context.h"
 #include "util/logging/logging.h"
 #include "util/proto/object_id.h"
 #include "util/proto/object_id.pb.h"
 
-std::unordered_map<util::proto::ObjectId, const units::proto::Template> template_map_;
-std::unordered_map<util::proto::ObjectId, units::Unit*> units::Unit::units_;
-
 namespace units {
 
+struct Unit::Registry {
+  std::unordered_map<util::proto::ObjectId, const proto::Template> templates;
+  std::unordered_map<util::proto::ObjectId, Unit*> units;
+  // Changes whenever templates does, so units know to look theirs up again.
+  uint64 template_generation = 0;
+};
+
+Unit::Registry& Unit::registry() {
+  return util::Context::Current().Get<Registry>();
+}
+
 std::unique_ptr<Unit> Unit::FromProto(const proto::Unit& proto) {
   std::unique_ptr<Unit> ret;
   // TODO: Actually handle the errors when we get support for StatusOr<unique_ptr>.
@@ -38,7 +47,9 @@ std::unique_ptr<Unit> Unit::FromProto(const proto::Unit& proto) {
 }
 
 void Unit::ClearTemplates() {
-  template_map_.clear();
+  Registry& lookup = registry();
+  lookup.templates.clear();
+  lookup.template_generation++;
 }
 
 bool Unit::RegisterTemplate(const proto::Template& proto) {
@@ -46,26 +57,34 @@ bool Unit::RegisterTemplate(const proto::Template& proto) {
     return false;
   }
 
-  if (template_map_.find(proto.template_id()) != template_map_.end()) {
+  Registry& lookup = registry();
+  auto& templates = lookup.templates;
+  if (templates.find(proto.template_id()) != templates.end()) {
     return false;
   }
-  template_map_.emplace(proto.template_id(), proto);
+  templates.emplace(proto.template_id(), proto);
+  lookup.template_generation++;
   return true;
 }
 
 util::Status Unit::UnregisterTemplate(const util::proto::ObjectId& id) {
-  if (template_map_.find(id) == template_map_.end()) {
+  Registry& lookup = registry();
+  auto& templates = lookup.templates;
+  if (templates.find(id) == templates.end()) {
     return util::NotFoundError("Template for unregistering not found.");
   }
-  template_map_.erase(id);
+  templates.erase(id);
+  lookup.template_generation++;
   return util::OkStatus();
 }
 
 const proto::Template* Unit::TemplateById(const util::proto::ObjectId& id) {
-  if (template_map_.find(id) == template_map_.end()) {
+  const auto& templates = registry().templates;
+  auto found = templates.find(id);
+  if (found == templates.end()) {
     return NULL;
   }
-  return &template_map_.at(id);
+  return &found->second;
 }
 
 const proto::Template* Unit::TemplateByKind(const std::string& kind) {
@@ -75,27 +94,61 @@ const proto::Template* Unit::TemplateByKind(const std::string& kind) {
 }
 
 Unit* Unit::ById(const util::proto::ObjectId& id) {
-  return units_[id];
+  const auto& units = registry().units;
+  auto found = units.find(id);
+  if (found == units.end()) {
+    return nullptr;
+  }
+  return found->second;
 }
 
 const proto::Template& Unit::Template() const {
-  const proto::Template* t = TemplateByKind(proto_.unit_id().kind());
-  if (!t) {
+  if (template_ == nullptr ||
+      template_generation_ != registry_->template_generation) {
+    util::proto::ObjectId id;
+    id.set_kind(proto_.unit_id().kind());
+    auto found = registry_->templates.find(id);
+    template_ =
+        found == registry_->templates.end() ? nullptr : &found->second;
+    template_generation_ = registry_->template_generation;
+  }
+  if (!template_) {
     Log::Errorf("Could not find template for unit ID %s",
                 proto_.unit_id().DebugString());
   }
-  return *t;
+  return *template_;
+}
+
+void Unit::AddCargo(const std::string& good, micro::Measure amount_u) {
+  ++generation_;
+  market::Add(good, amount_u, proto_.mutable_resources());
+  if (cargo_counted_) {
+    cargo_bulk_u_ += micro::MultiplyU(market::BulkU(good), amount_u);
+    cargo_weight_u_ += micro::MultiplyU(market::WeightU(good), amount_u);
+  }
 }
 
 void Unit::Attrite() {
-  *mutable_resources() += Template().attrition();
+  const auto& attrition = Template().attrition();
+  ++generation_;
+  *proto_.mutable_resources() += attrition;
+  if (cargo_counted_) {
+    for (const auto& quantity : attrition.quantities()) {
+      cargo_bulk_u_ +=
+          micro::MultiplyU(market::BulkU(quantity.first), quantity.second);
+      cargo_weight_u_ +=
+          micro::MultiplyU(market::WeightU(quantity.first), quantity.second);
+    }
+  }
 }
 
 actions::proto::Strategy* Unit:: mutable_strategy() {
+  ++generation_;
   return proto_.mutable_strategy();
 }
 
 actions::proto::Plan* Unit::mutable_plan() {
+  ++generation_;
   return proto_.mutable_plan();
 }
 
@@ -116,6 +169,10 @@ const geography::proto::Location& Unit::location() const {
 }
 
 geography::proto::Location* Unit::mutable_location() {
+  if (listener_ != nullptr) {
+    listener_->Moving(this);
+  }
+  ++generation_;
   return proto_.mutable_location();
 }
 
@@ -124,14 +181,35 @@ const market::proto::Container& Unit::resources() const {
 }
 
 market::proto::Container* Unit::mutable_resources() {
+  cargo_counted_ = false;
+  ++generation_;
   return proto_.mutable_resources();
 }
 
-Unit::Unit(const proto::Unit& proto) : proto_(proto), used_action_points_u(0) {
-  units_[proto_.unit_id()] = this;
+market::proto::Container* Unit::share_resources() {
+  resources_shared_ = true;
+  return mutable_resources();
+}
+
+void Unit::ReleaseResources() {
+  resources_shared_ = false;
+  cargo_counted_ = false;
 }
 
-Unit::~Unit() { units_.erase(proto_.unit_id()); }
+Unit::Unit(const proto::Unit& proto)
+    : proto_(proto), used_action_points_u(0), registry_(&registry()),
+      template_(nullptr), template_generation_(0), cargo_bulk_u_(0),
+      cargo_weight_u_(0), cargo_counted_(false), resources_shared_(false),
+      generation_(0), listener_(nullptr) {
+  registry_->units[proto_.unit_id()] = this;
+}
+
+Unit::~Unit() {
+  if (listener_ != nullptr) {
+    listener_->Removed(this);
+  }
+  registry_->units.erase(proto_.unit_id());
+}
 
 micro::Measure Unit::capacity(const std::string& good, micro::Measure current_bulk_u, micro::Measure current_weight_u) const {
   if (market::TransportType(good) == market::proto::TradeGood::TTT_IMMOBILE) {
@@ -152,20 +230,36 @@ micro::Measure Unit::capacity(const std::string& good, micro::Measure current_bu
 
 }
 
-micro::Measure Unit::RemainingCapacity(const std::string& good) const {
-  if (market::TransportType(good) == market::proto::TradeGood::TTT_IMMOBILE) {
-    return 0;
+void Unit::countCargo() const {
+  if (cargo_counted_) {
+    return;
   }
-  micro::Measure current_bulk_u = 0;
-  micro::Measure current_weight_u = 0;
+  cargo_bulk_u_ = 0;
+  cargo_weight_u_ = 0;
   for (const auto& quantity : resources().quantities()) {
-    current_bulk_u +=
+    cargo_bulk_u_ +=
         micro::MultiplyU(market::BulkU(quantity.first), quantity.second);
-    current_weight_u +=
+    cargo_weight_u_ +=
         micro::MultiplyU(market::WeightU(quantity.first), quantity.second);
   }
+  cargo_counted_ = !resources_shared_;
+}
+
+micro::Measure Unit::RemainingCapacity(const std::string& good) const {
+  if (market::TransportType(good) == market::proto::TradeGood::TTT_IMMOBILE) {
+    return 0;
+  }
+  countCargo();
+  return capacity(good, cargo_bulk_u_, cargo_weight_u_);
+}
 
-  return capacity(good, current_bulk_u, current_weight_u);
+void Unit::RemainingCapacities(const std::vector<std::string>& goods,
+                               market::proto::Container* capacities) const {
+  countCargo();
+  for (const auto& good : goods) {
+    market::SetAmount(good, capacity(good, cargo_bulk_u_, cargo_weight_u_),
+                      capacities);
+  }
 }
 
 micro::Measure Unit::Capacity(const std::string& good) const {
@@ -198,24 +292,44 @@ Unit* ById(const util::proto::ObjectId unit_id) {
   return Unit::ById(unit_id);
 }
 
-const util::Status Unit::Match(const Filter& filter) const {
+util::LazyStatus Unit::Match(const Filter& filter) const {
   if (!util::objectid::IsNull(filter.faction_id)) {
     if (faction_id() != filter.faction_id) {
-      return util::NotFoundErrorf("wrong faction %s",
-                                  util::objectid::DisplayString(faction_id()));
+      // Only the number is kept, so that the status does not copy the id.
+      return util::LazyStatus::Deferred(
+          absl::StatusCode::kNotFound, [number = faction_id().number()]() {
+            return absl::StrFormat("wrong faction %s",
+                                   util::objectid::DisplayString(
+                                       util::objectid::New("faction", number)));
+          });
     }
   }
 
   if (!util::objectid::IsNull(filter.location_id)) {
     const auto& loc = location().a_area_id();
     if (loc != filter.location_id) {
-      return util::NotFoundErrorf("wrong location %s",
-                                  util::objectid::DisplayString(loc));
+      return util::LazyStatus::Deferred(
+          absl::StatusCode::kNotFound, [number = loc.number()]() {
+            return absl::StrFormat("wrong location %s",
+                                   util::objectid::DisplayString(
+                                       util::objectid::New("area", number)));
+          });
     }
   }
 
-  return util::OkStatus();
+  return util::LazyStatus();
 }
 
+bool Unit::Matches(const Filter& filter) const {
+  if (!util::objectid::IsNull(filter.faction_id) &&
+      faction_id() != filter.faction_id) {
+    return false;
+  }
+  if (!util::objectid::IsNull(filter.location_id) &&
+      location().a_area_id() != filter.location_id) {
+    return false;
+  }
+  return true;
+}
 
 } // namespace units
@@ -3,6 +3,7 @@
 
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "games/geography/mobile.h"
 #include "games/geography/proto/geography.pb.h"
@@ -10,6 +11,8 @@
 #include "games/units/proto/templates.pb.h"
 #include "games/units/proto/units.pb.h"
 #include "util/arithmetic/microunits.h"
+#include "util/headers/int_types.h"
+#include "util/status/lazy_status.h"
 #include "util/status/status.h"
 #include "util/proto/object_id.pb.h"
 
@@ -27,6 +30,16 @@ class Unit : public geography::Mobile {
 public:
   ~Unit();
 
+  // Told about a unit that moves or goes away.
+  struct Listener {
+    // The unit's location is about to change.
+    virtual void Moving(Unit* unit) = 0;
+    // The unit is being destroyed.
+    virtual void Removed(Unit* unit) = 0;
+  };
+  // Sets the one listener of this unit, or clears it if null.
+  void SetListener(Listener* listener) { listener_ = listener; }
+
   static std::unique_ptr<Unit> FromProto(const proto::Unit& proto);
   static void ClearTemplates();
   static bool RegisterTemplate(const proto::Template& proto);
@@ -38,6 +51,10 @@ public:
 
   // Template and proto access.
   const proto::Unit& Proto() const { return proto_; }
+  // Changes on every call of a non-const accessor, so that a copy of the
+  // proto taken at the same generation is still current. Does not see
+  // changes made through a container from share_resources.
+  uint64 generation() const { return generation_; }
   // Deprecated, use unit_id instead.
   const util::proto::ObjectId& ID() const { return proto_.unit_id(); }
   const util::proto::ObjectId& unit_id() const;
@@ -62,16 +79,33 @@ public:
   const geography::proto::Location& location() const override;
   geography::proto::Location* mutable_location() override;
 
-  // Cargo or supplies.
+  // Cargo or supplies. The unit keeps running totals of the bulk and weight
+  // of its resources; getting the mutable container marks them for
+  // recounting, so do not hold on to it across capacity queries. AddCargo
+  // and Attrite keep the totals instead.
   const market::proto::Container& resources() const;
   market::proto::Container* mutable_resources();
 
+  // Returns the resources for a holder that keeps the pointer and may change
+  // them after the call returns, such as a market holding a buy offer. Until
+  // ReleaseResources the unit recounts its totals on every capacity query.
+  market::proto::Container* share_resources();
+  // Called once nothing holds the container from share_resources.
+  void ReleaseResources();
+  bool resources_shared() const { return resources_shared_; }
+
+  // Adds amount_u, which may be negative, of good to the resources.
+  void AddCargo(const std::string& good, micro::Measure amount_u);
+
   // Adds the template attrition to the unit.
   void Attrite();
 
   // Returns the amount of good that can still be loaded, whether limited
   // by bulk or weight.
   micro::Measure RemainingCapacity(const std::string& good) const;
+  // Sets the remaining capacity for each of goods in capacities.
+  void RemainingCapacities(const std::vector<std::string>& goods,
+                           market::proto::Container* capacities) const;
   // Deprecated, use RemainingCapacity instead. Alias for RemainingCapacity.
   micro::Measure Capacity(const std::string& good) const;
 
@@ -81,20 +115,45 @@ public:
   
   const std::string& template_kind() const { return proto_.unit_id().kind(); }
 
-  // Returns an OK Status if the unit passes the filter.
-  const util::Status Match(const Filter& filter) const;
+  // Returns an OK status if the unit passes the filter; the reason it does
+  // not is only formatted if asked for.
+  util::LazyStatus Match(const Filter& filter) const;
+  // Returns true if the unit passes the filter; unlike Match, does not
+  // explain why not.
+  bool Matches(const Filter& filter) const;
 
 private:
   Unit(const proto::Unit& proto);
 
-  static std::unordered_map<util::proto::ObjectId, Unit*> units_;
+  // Units and templates of one simulation context.
+  struct Registry;
+  // The registry of the current context.
+  static Registry& registry();
 
   micro::Measure capacity(const std::string& good,
                           micro::Measure current_bulk_u = 0,
                           micro::Measure current_weight_u = 0) const;
+  // Recounts the cargo totals if they are stale.
+  void countCargo() const;
 
   proto::Unit proto_;
   micro::Measure used_action_points_u;
+  // Where this unit is listed, which is not necessarily the current registry
+  // by the time it is destroyed.
+  Registry* registry_;
+
+  // The template, as of the registry's template_generation in
+  // template_generation_.
+  mutable const proto::Template* template_;
+  mutable uint64 template_generation_;
+  // Bulk and weight of the resources, if cargo_counted_.
+  mutable micro::Measure cargo_bulk_u_;
+  mutable micro::Measure cargo_weight_u_;
+  mutable bool cargo_counted_;
+  // True while something outside the unit may change the resources.
+  bool resources_shared_;
+  uint64 generation_;
+  Listener* listener_;
 };
 
 Unit* ById(const util::proto::ObjectId unit_id);
@@ -0,0 +1,177 @@
+#include "games/units/unit_index.h"
+
+#include <algorithm>
+
+#include "games/geography/connection.h"
+
+namespace units {
+namespace {
+
+void addUnits(const std::vector<Unit*>& from, std::vector<const Unit*>* to) {
+  to->insert(to->end(), from.begin(), from.end());
+}
+
+void eraseUnit(const util::proto::ObjectId& key, Unit* unit,
+               std::unordered_map<util::proto::ObjectId,
+                                  std::unordered_map<util::proto::ObjectId,
+                                                     std::vector<Unit*>>>*
+                   places) {
+  auto place = places->find(key);
+  if (place == places->end()) {
+    return;
+  }
+  auto faction = place->second.find(unit->faction_id());
+  if (faction == place->second.end()) {
+    return;
+  }
+  auto& filed = faction->second;
+  filed.erase(std::find(filed.begin(), filed.end(), unit));
+  if (filed.empty()) {
+    place->second.erase(faction);
+    if (place->second.empty()) {
+      places->erase(place);
+    }
+  }
+}
+
+} // namespace
+
+UnitIndex::~UnitIndex() { Clear(); }
+
+void UnitIndex::Add(Unit* unit) {
+  if (places_.find(unit) != places_.end()) {
+    return;
+  }
+  unit->SetListener(this);
+  file(unit, &places_[unit]);
+}
+
+void UnitIndex::Remove(Unit* unit) {
+  auto place = places_.find(unit);
+  if (place == places_.end()) {
+    return;
+  }
+  unit->SetListener(nullptr);
+  unfile(unit, place->second);
+  if (place->second.moving) {
+    moving_.erase(std::find(moving_.begin(), moving_.end(), unit));
+  }
+  places_.erase(place);
+}
+
+void UnitIndex::Clear() {
+  for (auto& place : places_) {
+    place.first->SetListener(nullptr);
+  }
+  areas_.clear();
+  connections_.clear();
+  places_.clear();
+  moving_.clear();
+}
+
+void UnitIndex::Moving(Unit* unit) {
+  auto& place = places_[unit];
+  if (place.moving) {
+    return;
+  }
+  place.moving = true;
+  moving_.push_back(unit);
+}
+
+void UnitIndex::Removed(Unit* unit) { Remove(unit); }
+
+void UnitIndex::file(Unit* unit, Place* place) const {
+  const auto& location = unit->location();
+  place->area_id = location.a_area_id();
+  areas_[place->area_id][unit->faction_id()].push_back(unit);
+  place->connection_id.Clear();
+  if (location.has_connection_id()) {
+    place->connection_id = location.connection_id();
+    connections_[place->connection_id][unit->faction_id()].push_back(unit);
+  }
+  place->moving = false;
+}
+
+void UnitIndex::unfile(Unit* unit, const Place& place) const {
+  eraseUnit(place.area_id, unit, &areas_);
+  if (!util::objectid::IsNull(place.connection_id)) {
+    eraseUnit(place.connection_id, unit, &connections_);
+  }
+}
+
+void UnitIndex::refile() const {
+  for (Unit* unit : moving_) {
+    auto& place = places_.at(unit);
+    unfile(unit, place);
+    file(unit, &place);
+  }
+  moving_.clear();
+}
+
+void UnitIndex::InArea(const util::proto::ObjectId& area_id,
+                       const util::proto::ObjectId& faction_id,
+                       std::vector<const Unit*>* units) const {
+  refile();
+  auto area = areas_.find(area_id);
+  if (area == areas_.end()) {
+    return;
+  }
+  if (!util::objectid::IsNull(faction_id)) {
+    auto faction = area->second.find(faction_id);
+    if (faction != area->second.end()) {
+      addUnits(faction->second, units);
+    }
+    return;
+  }
+  for (const auto& faction : area->second) {
+    addUnits(faction.second, units);
+  }
+}
+
+void UnitIndex::EnemiesInArea(const util::proto::ObjectId& area_id,
+                              const util::proto::ObjectId& faction_id,
+                              std::vector<const Unit*>* units) const {
+  refile();
+  auto area = areas_.find(area_id);
+  if (area == areas_.end()) {
+    return;
+  }
+  for (const auto& faction : area->second) {
+    if (faction.first == faction_id) {
+      continue;
+    }
+    addUnits(faction.second, units);
+  }
+}
+
+void UnitIndex::InConnection(const util::proto::ObjectId& connection_id,
+                             const util::proto::ObjectId& from_area_id,
+                             micro::uMeasure min_u, micro::uMeasure max_u,
+                             const util::proto::ObjectId& faction_id,
+                             std::vector<const Unit*>* units) const {
+  refile();
+  auto connection = connections_.find(connection_id);
+  if (connection == connections_.end()) {
+    return;
+  }
+  const auto* conn = geography::Connection::ById(connection_id);
+  const micro::uMeasure length_u = conn == nullptr ? 0 : conn->length_u();
+  for (const auto& faction : connection->second) {
+    if (!util::objectid::IsNull(faction_id) && faction.first != faction_id) {
+      continue;
+    }
+    for (const Unit* unit : faction.second) {
+      const auto& location = unit->location();
+      micro::uMeasure position_u = location.progress_u();
+      if (location.a_area_id() != from_area_id) {
+        position_u = position_u > length_u ? 0 : length_u - position_u;
+      }
+      if (position_u < min_u || position_u > max_u) {
+        continue;
+      }
+      units->push_back(unit);
+    }
+  }
+}
+
+} // namespace units
@@ -0,0 +1,83 @@
+#ifndef UNITS_UNIT_INDEX_H
+#define UNITS_UNIT_INDEX_H
+
+#include <unordered_map>
+#include <vector>
+
+#include "games/units/unit.h"
+#include "util/arithmetic/microunits.h"
+#include "util/proto/object_id.h"
+#include "util/proto/object_id.pb.h"
+
+namespace units {
+
+// Finds units by where they are and whose they are without scanning every
+// unit. Units are filed under their area and, while travelling, also under
+// their connection; within each place they are filed by faction. The index
+// listens to its units, so a unit whose location changes is refiled before
+// the next query, and a destroyed unit drops out.
+class UnitIndex : public Unit::Listener {
+public:
+  UnitIndex() = default;
+  ~UnitIndex();
+  UnitIndex(const UnitIndex&) = delete;
+  UnitIndex& operator=(const UnitIndex&) = delete;
+
+  // Files unit and starts listening to it, replacing its previous listener.
+  void Add(Unit* unit);
+  // Stops listening to unit and forgets it.
+  void Remove(Unit* unit);
+  // Removes all units.
+  void Clear();
+
+  // Adds to units those whose area is area_id, in the order they were filed.
+  // If faction_id is not null, only that faction's units are added.
+  void InArea(const util::proto::ObjectId& area_id,
+              const util::proto::ObjectId& faction_id,
+              std::vector<const Unit*>* units) const;
+
+  // Adds to units those in area_id that do not belong to faction_id.
+  void EnemiesInArea(const util::proto::ObjectId& area_id,
+                     const util::proto::ObjectId& faction_id,
+                     std::vector<const Unit*>* units) const;
+
+  // Adds to units those travelling in connection_id that are between min_u
+  // and max_u, inclusive, from the end at from_area_id. If faction_id is not
+  // null, only that faction's units are added.
+  void InConnection(const util::proto::ObjectId& connection_id,
+                    const util::proto::ObjectId& from_area_id,
+                    micro::uMeasure min_u, micro::uMeasure max_u,
+                    const util::proto::ObjectId& faction_id,
+                    std::vector<const Unit*>* units) const;
+
+  // Unit::Listener.
+  void Moving(Unit* unit) override;
+  void Removed(Unit* unit) override;
+
+private:
+  typedef std::unordered_map<util::proto::ObjectId, std::vector<Unit*>>
+      ByFaction;
+
+  // Where a unit is filed.
+  struct Place {
+    util::proto::ObjectId area_id;
+    util::proto::ObjectId connection_id;
+    // True if the unit has changed location since it was filed.
+    bool moving = false;
+  };
+
+  void file(Unit* unit, Place* place) const;
+  void unfile(Unit* unit, const Place& place) const;
+  // Refiles the units that have changed location.
+  void refile() const;
+
+  // Refiling happens on lookup, hence mutable.
+  mutable std::unordered_map<util::proto::ObjectId, ByFaction> areas_;
+  mutable std::unordered_map<util::proto::ObjectId, ByFaction> connections_;
+  mutable std::unordered_map<Unit*, Place> places_;
+  mutable std::vector<Unit*> moving_;
+};
+
+} // namespace units
+
+#endif
@@ -0,0 +1,148 @@
+#include "games/units/unit_index.h"
+
+#include <memory>
+#include <vector>
+
+#include "games/geography/connection.h"
+#include "games/geography/geography.h"
+#include "games/geography/proto/geography.pb.h"
+#include "games/units/proto/templates.pb.h"
+#include "games/units/proto/units.pb.h"
+#include "games/units/unit.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "util/arithmetic/microunits.h"
+#include "util/proto/object_id.h"
+
+namespace units {
+
+using testing::ElementsAre;
+using testing::IsEmpty;
+using testing::UnorderedElementsAre;
+
+class UnitIndexTest : public testing::Test {
+protected:
+  void SetUp() override {
+    proto::Template temp;
+    temp.mutable_template_id()->set_kind("ship");
+    temp.mutable_mobility()->set_speed_u(1);
+    Unit::RegisterTemplate(temp);
+
+    geography::proto::Area area;
+    area_one_ = util::objectid::New("area", 1);
+    area_two_ = util::objectid::New("area", 2);
+    *area.mutable_area_id() = area_one_;
+    a_end_ = geography::Area::FromProto(area);
+    *area.mutable_area_id() = area_two_;
+    z_end_ = geography::Area::FromProto(area);
+
+    geography::proto::Connection conn;
+    connection_id_ = util::objectid::New("connection", 1);
+    *conn.mutable_connection_id() = connection_id_;
+    *conn.mutable_a_area_id() = area_one_;
+    *conn.mutable_z_area_id() = area_two_;
+    conn.set_distance_u(10 * micro::kOneInU);
+    conn.set_width_u(1);
+    connection_ = geography::Connection::FromProto(conn);
+
+    british_ = util::objectid::New("faction", 1);
+    french_ = util::objectid::New("faction", 2);
+  }
+
+  Unit* newUnit(int number, const util::proto::ObjectId& faction_id,
+                const util::proto::ObjectId& area_id) {
+    proto::Unit proto;
+    *proto.mutable_unit_id() = util::objectid::New("ship", number);
+    *proto.mutable_faction_id() = faction_id;
+    *proto.mutable_location()->mutable_a_area_id() = area_id;
+    units_.push_back(Unit::FromProto(proto));
+    index_.Add(units_.back().get());
+    return units_.back().get();
+  }
+
+  // Destroyed after the index, so it detaches from live units.
+  std::vector<std::unique_ptr<Unit>> units_;
+  UnitIndex index_;
+  std::unique_ptr<geography::Area> a_end_;
+  std::unique_ptr<geography::Area> z_end_;
+  std::unique_ptr<geography::Connection> connection_;
+  util::proto::ObjectId area_one_;
+  util::proto::ObjectId area_two_;
+  util::proto::ObjectId connection_id_;
+  util::proto::ObjectId british_;
+  util::proto::ObjectId french_;
+};
+
+TEST_F(UnitIndexTest, InArea) {
+  const Unit* first = newUnit(1, british_, area_one_);
+  const Unit* second = newUnit(2, french_, area_one_);
+  const Unit* third = newUnit(3, british_, area_two_);
+  const Unit* fourth = newUnit(4, british_, area_one_);
+
+  std::vector<const Unit*> found;
+  index_.InArea(area_one_, util::objectid::kNullId, &found);
+  EXPECT_THAT(found, UnorderedElementsAre(first, second, fourth));
+
+  found.clear();
+  index_.InArea(area_one_, british_, &found);
+  EXPECT_THAT(found, ElementsAre(first, fourth));
+
+  found.clear();
+  index_.EnemiesInArea(area_one_, british_, &found);
+  EXPECT_THAT(found, ElementsAre(second));
+
+  found.clear();
+  index_.InArea(area_two_, util::objectid::kNullId, &found);
+  EXPECT_THAT(found, ElementsAre(third));
+}
+
+TEST_F(UnitIndexTest, Moving) {
+  Unit* ship = newUnit(1, british_, area_one_);
+  *ship->mutable_location()->mutable_connection_id() = connection_id_;
+  ship->mutable_location()->set_progress_u(3 * micro::kOneInU);
+
+  std::vector<const Unit*> found;
+  index_.InConnection(connection_id_, area_one_, 0, 4 * micro::kOneInU,
+                      util::objectid::kNullId, &found);
+  EXPECT_THAT(found, ElementsAre(ship));
+
+  // Seen from the other end, the ship is seven units away.
+  found.clear();
+  index_.InConnection(connection_id_, area_two_, 0, 4 * micro::kOneInU,
+                      util::objectid::kNullId, &found);
+  EXPECT_THAT(found, IsEmpty());
+  index_.InConnection(connection_id_, area_two_, 7 * micro::kOneInU,
+                      7 * micro::kOneInU, british_, &found);
+  EXPECT_THAT(found, ElementsAre(ship));
+
+  // Arrives.
+  auto* location = ship->mutable_location();
+  location->clear_connection_id();
+  location->clear_progress_u();
+  *location->mutable_a_area_id() = area_two_;
+  found.clear();
+  index_.InConnection(connection_id_, area_one_, 0, 10 * micro::kOneInU,
+                      util::objectid::kNullId, &found);
+  EXPECT_THAT(found, IsEmpty());
+  index_.InArea(area_one_, util::objectid::kNullId, &found);
+  EXPECT_THAT(found, IsEmpty());
+  index_.InArea(area_two_, british_, &found);
+  EXPECT_THAT(found, ElementsAre(ship));
+}
+
+TEST_F(UnitIndexTest, Removed) {
+  newUnit(1, british_, area_one_);
+  Unit* second = newUnit(2, british_, area_one_);
+  units_[0].reset();
+
+  std::vector<const Unit*> found;
+  index_.InArea(area_one_, british_, &found);
+  EXPECT_THAT(found, ElementsAre(second));
+
+  index_.Remove(second);
+  found.clear();
+  index_.InArea(area_one_, util::objectid::kNullId, &found);
+  EXPECT_THAT(found, IsEmpty());
+}
+
+} // namespace units
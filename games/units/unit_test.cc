@@ -10,6 +10,7 @@
 #include "gtest/gtest.h"
 #include "src/google/protobuf/util/message_differencer.h"
 #include "util/arithmetic/microunits.h"
+#include "util/context/context.h"
 #include "util/headers/int_types.h"
 #include "util/proto/object_id.h"
 
@@ -44,6 +45,23 @@ TEST_F(UnitTest, GetById) {
   EXPECT_EQ(unit_.get(), Unit::ById(id));
 }
 
+TEST_F(UnitTest, SeparateContexts) {
+  const auto id = util::objectid::New("template", 1);
+  util::Context other;
+  {
+    util::Context::Scope scope(&other);
+    EXPECT_EQ(nullptr, Unit::ById(id));
+    EXPECT_EQ(nullptr, Unit::TemplateByKind("template"));
+    Unit::RegisterTemplate(template_);
+    auto twin = Unit::FromProto(unit_proto_);
+    ASSERT_TRUE(twin);
+    EXPECT_EQ(twin.get(), Unit::ById(id));
+    unit_.reset();
+    EXPECT_EQ(twin.get(), Unit::ById(id));
+  }
+  EXPECT_EQ(nullptr, Unit::ById(id));
+}
+
 TEST_F(UnitTest, GetTemplate) {
   google::protobuf::util::MessageDifferencer differ;
   const auto* lookup = Unit::TemplateByKind("template");
@@ -94,6 +112,65 @@ TEST_F(UnitTest, Capacity) {
   EXPECT_EQ(micro::kHalfInU, unit_->TotalCapacity(heavy.name()));
 }
 
+TEST_F(UnitTest, CargoTotals) {
+  market::proto::TradeGood bulky;
+  bulky.set_name("bulky");
+  bulky.set_bulk_u(2 * micro::kOneInU);
+  bulky.set_weight_u(micro::kHalfInU);
+  bulky.set_transport_type(market::proto::TradeGood::TTT_STANDARD);
+  market::CreateTradeGood(bulky);
+  market::proto::TradeGood heavy;
+  heavy.set_name("heavy");
+  heavy.set_bulk_u(micro::kHalfInU);
+  heavy.set_weight_u(2 * micro::kOneInU);
+  heavy.set_transport_type(market::proto::TradeGood::TTT_STANDARD);
+  market::CreateTradeGood(heavy);
+
+  EXPECT_EQ(micro::kHalfInU, unit_->RemainingCapacity(bulky.name()));
+  unit_->AddCargo(bulky.name(), 2 * micro::kOneTenthInU);
+  EXPECT_EQ(2 * micro::kOneTenthInU,
+            market::GetAmount(unit_->resources(), bulky.name()));
+  EXPECT_EQ(3 * micro::kOneTenthInU, unit_->RemainingCapacity(bulky.name()));
+
+  market::proto::Container capacities;
+  unit_->RemainingCapacities({bulky.name(), heavy.name()}, &capacities);
+  EXPECT_EQ(3 * micro::kOneTenthInU,
+            market::GetAmount(capacities, bulky.name()));
+  EXPECT_EQ(micro::kOneFourthInU + 2 * micro::kOneTenthInU,
+            market::GetAmount(capacities, heavy.name()));
+
+  unit_->AddCargo(bulky.name(), -2 * micro::kOneTenthInU);
+  EXPECT_EQ(micro::kHalfInU, unit_->RemainingCapacity(bulky.name()));
+
+  // Changes through the mutable container are counted too.
+  market::SetAmount(bulky.name(), micro::kHalfInU, unit_->mutable_resources());
+  EXPECT_EQ(0, unit_->RemainingCapacity(heavy.name()));
+
+  // A shared container may change between capacity queries.
+  auto* shared = unit_->share_resources();
+  market::SetAmount(bulky.name(), 0, shared);
+  EXPECT_EQ(micro::kHalfInU, unit_->RemainingCapacity(bulky.name()));
+  market::SetAmount(bulky.name(), 2 * micro::kOneTenthInU, shared);
+  EXPECT_EQ(3 * micro::kOneTenthInU, unit_->RemainingCapacity(bulky.name()));
+  unit_->ReleaseResources();
+  EXPECT_EQ(3 * micro::kOneTenthInU, unit_->RemainingCapacity(bulky.name()));
+  unit_->AddCargo(bulky.name(), -2 * micro::kOneTenthInU);
+  EXPECT_EQ(micro::kHalfInU, unit_->RemainingCapacity(bulky.name()));
+}
+
+TEST_F(UnitTest, TemplateChange) {
+  EXPECT_EQ(micro::kOneInU, unit_->action_points_u());
+  Unit::ClearTemplates();
+  template_.set_base_action_points_u(2 * micro::kOneInU);
+  Unit::RegisterTemplate(template_);
+  EXPECT_EQ(2 * micro::kOneInU, unit_->action_points_u());
+
+  Unit::ClearTemplates();
+  template_.set_base_action_points_u(micro::kOneInU);
+  Unit::RegisterTemplate(template_);
+  EXPECT_EQ(micro::kOneInU, unit_->action_points_u());
+}
+
 TEST_F(UnitTest, ActionPoints) {
   EXPECT_EQ(template_.base_action_points_u(), unit_->action_points_u());
   unit_->use_action_points(micro::kHalfInU);
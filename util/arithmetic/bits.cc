@@ -1,5 +1,6 @@
 #include "util/arithmetic/bits.h"
 
+#include <algorithm>
 #include <cstdarg>
 
 namespace bits {
@@ -70,6 +71,123 @@ bool Subset(const Mask& cand, const Mask& super) {
   return ((cand ^ super) & cand).none();
 }
 
+void WideMask::set(unsigned int idx) {
+  const unsigned int word = idx / kWordBits;
+  if (word >= words_.size()) {
+    words_.resize(word + 1, 0);
+  }
+  words_[word] |= uint64(1) << (idx % kWordBits);
+}
+
+void WideMask::reset(unsigned int idx) {
+  const unsigned int word = idx / kWordBits;
+  if (word < words_.size()) {
+    words_[word] &= ~(uint64(1) << (idx % kWordBits));
+  }
+}
+
+bool WideMask::any() const {
+  for (const uint64 word : words_) {
+    if (word != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+unsigned int WideMask::count() const {
+  unsigned int total = 0;
+  for (const uint64 word : words_) {
+    total += __builtin_popcountll(word);
+  }
+  return total;
+}
+
+int WideMask::next(unsigned int idx) const {
+  unsigned int word = idx / kWordBits;
+  if (word >= words_.size()) {
+    return -1;
+  }
+  uint64 bits = words_[word] & (~uint64(0) << (idx % kWordBits));
+  while (true) {
+    if (bits != 0) {
+      return word * kWordBits + __builtin_ctzll(bits);
+    }
+    if (++word >= words_.size()) {
+      return -1;
+    }
+    bits = words_[word];
+  }
+}
+
+WideMask& WideMask::operator&=(const WideMask& other) {
+  if (words_.size() > other.words_.size()) {
+    words_.resize(other.words_.size());
+  }
+  for (unsigned int i = 0; i < words_.size(); ++i) {
+    words_[i] &= other.words_[i];
+  }
+  return *this;
+}
+
+WideMask& WideMask::operator|=(const WideMask& other) {
+  if (words_.size() < other.words_.size()) {
+    words_.resize(other.words_.size(), 0);
+  }
+  for (unsigned int i = 0; i < other.words_.size(); ++i) {
+    words_[i] |= other.words_[i];
+  }
+  return *this;
+}
+
+WideMask& WideMask::Remove(const WideMask& other) {
+  const auto common = std::min(words_.size(), other.words_.size());
+  for (unsigned int i = 0; i < common; ++i) {
+    words_[i] &= ~other.words_[i];
+  }
+  return *this;
+}
+
+bool WideMask::operator==(const WideMask& other) const {
+  const bool fewer = words_.size() < other.words_.size();
+  const auto& shorter = fewer ? words_ : other.words_;
+  const auto& longer = fewer ? other.words_ : words_;
+  for (unsigned int i = 0; i < longer.size(); ++i) {
+    const uint64 word = i < shorter.size() ? shorter[i] : 0;
+    if (longer[i] != word) {
+      return false;
+    }
+  }
+  return true;
+}
+
+size_t WideMask::Hash() const {
+  // Trailing empty words are skipped, so that equal masks hash equally.
+  size_t hash = 0;
+  unsigned int end = words_.size();
+  while (end > 0 && words_[end - 1] == 0) {
+    --end;
+  }
+  for (unsigned int i = 0; i < end; ++i) {
+    hash = hash * 31 + std::hash<uint64>()(words_[i]);
+  }
+  return hash;
+}
+
+WideMask operator&(WideMask one, const WideMask& two) { return one &= two; }
+
+WideMask operator|(WideMask one, const WideMask& two) { return one |= two; }
+
+bool Subset(const WideMask& cand, const WideMask& super) {
+  for (unsigned int i = 0; i < cand.words_.size(); ++i) {
+    const uint64 word = i < super.words_.size() ? super.words_[i] : 0;
+    if ((cand.words_[i] & ~word) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
 
 
 } // namespace bits
@@ -3,9 +3,13 @@
 #define UTIL_ARITHMETIC_BITS_H
 
 #include <bitset>
+#include <cstddef>
+#include <functional>
 #include <limits>
 #include <vector>
 
+#include "util/headers/int_types.h"
+
 namespace bits {
 
 typedef std::bitset<32> Mask;
@@ -66,6 +70,55 @@ Mask GetMask(std::vector<unsigned int> ms);
 // Subset returns true if cand is a subset of super.
 bool Subset(const Mask& cand, const Mask& super);
 
+// A mask with as many bits as needed, for sets that may outgrow Mask. Bits
+// past the end read as unset; setting one grows the mask.
+class WideMask {
+public:
+  WideMask() = default;
+
+  void set(unsigned int idx);
+  void reset(unsigned int idx);
+  bool test(unsigned int idx) const {
+    const unsigned int word = idx / kWordBits;
+    return word < words_.size() && (words_[word] >> (idx % kWordBits)) & 1;
+  }
+  bool any() const;
+  bool none() const { return !any(); }
+  unsigned int count() const;
+  // Returns the lowest set bit at or above idx, or -1 if there is none.
+  int next(unsigned int idx) const;
+
+  WideMask& operator&=(const WideMask& other);
+  WideMask& operator|=(const WideMask& other);
+  // Unsets the bits set in other.
+  WideMask& Remove(const WideMask& other);
+
+  // Masks are equal if they have the same bits set, whatever their width.
+  bool operator==(const WideMask& other) const;
+  bool operator!=(const WideMask& other) const { return !(*this == other); }
+
+  size_t Hash() const;
+
+private:
+  static constexpr unsigned int kWordBits = 64;
+
+  friend bool Subset(const WideMask& cand, const WideMask& super);
+
+  std::vector<uint64> words_;
+};
+
+WideMask operator&(WideMask one, const WideMask& two);
+WideMask operator|(WideMask one, const WideMask& two);
+
+// Subset returns true if cand is a subset of super.
+bool Subset(const WideMask& cand, const WideMask& super);
+
 } // namespace bits
 
+namespace std {
+template <> struct hash<bits::WideMask> {
+  size_t operator()(const bits::WideMask& mask) const { return mask.Hash(); }
+};
+} // namespace std
+
 #endif
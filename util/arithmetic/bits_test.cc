@@ -67,4 +67,37 @@ TEST(BitsTest, Subsets) {
   EXPECT_TRUE(Subset(GetMask({0, 4, 31}), GetMask(23, 16, 31, 4, 0)));
 }
 
+TEST(BitsTest, WideMask) {
+  WideMask mask;
+  EXPECT_TRUE(mask.none());
+  EXPECT_EQ(-1, mask.next(0));
+  mask.set(3);
+  mask.set(70);
+  mask.set(200);
+  EXPECT_EQ(3, mask.count());
+  EXPECT_TRUE(mask.test(70));
+  EXPECT_FALSE(mask.test(71));
+  EXPECT_FALSE(mask.test(1000));
+  EXPECT_EQ(3, mask.next(0));
+  EXPECT_EQ(70, mask.next(4));
+  EXPECT_EQ(200, mask.next(71));
+  EXPECT_EQ(-1, mask.next(201));
+
+  WideMask other;
+  other.set(70);
+  EXPECT_TRUE(Subset(other, mask));
+  EXPECT_FALSE(Subset(mask, other));
+  EXPECT_EQ(other, mask & other);
+  EXPECT_EQ(mask, mask | other);
+
+  // Width does not matter to equality or hashing.
+  mask.reset(200);
+  mask.reset(3);
+  EXPECT_EQ(other, mask);
+  EXPECT_EQ(other.Hash(), mask.Hash());
+  mask.Remove(other);
+  EXPECT_TRUE(mask.none());
+  EXPECT_EQ(WideMask(), mask);
+}
+
 } // namespace bits
@@ -0,0 +1,86 @@
+// Bounded caches.
+#ifndef UTIL_CACHE_LRU_H
+#define UTIL_CACHE_LRU_H
+
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace util {
+
+// Holds up to capacity values, discarding the least recently used one to
+// make room for a new one. The evict callback, if any, is called for each
+// value as it is discarded - including by Clear and the destructor - so
+// that values owning resources, such as textures, can release them.
+template <typename Key, typename Value, typename Hash = std::hash<Key>,
+          typename Equal = std::equal_to<Key>>
+class LruCache {
+public:
+  typedef std::function<void(const Key&, Value&)> Evict;
+
+  explicit LruCache(int capacity, Evict evict = nullptr)
+      : capacity_(capacity < 1 ? 1 : capacity), evict_(std::move(evict)) {}
+  ~LruCache() { Clear(); }
+  LruCache(const LruCache&) = delete;
+  LruCache& operator=(const LruCache&) = delete;
+
+  // Returns the value for key, marking it as the most recently used, or null
+  // if there is none. The pointer is good until the next Insert or Clear.
+  Value* Find(const Key& key) {
+    auto found = index_.find(key);
+    if (found == index_.end()) {
+      return nullptr;
+    }
+    entries_.splice(entries_.begin(), entries_, found->second);
+    return &found->second->second;
+  }
+
+  // Stores value for key, replacing any value already there, and returns
+  // the stored value.
+  Value& Insert(const Key& key, Value value) {
+    auto found = index_.find(key);
+    if (found != index_.end()) {
+      discard(found->second);
+      index_.erase(found);
+    } else if (static_cast<int>(index_.size()) >= capacity_) {
+      auto oldest = std::prev(entries_.end());
+      index_.erase(oldest->first);
+      discard(oldest);
+    }
+    entries_.emplace_front(key, std::move(value));
+    index_.emplace(key, entries_.begin());
+    return entries_.front().second;
+  }
+
+  // Discards every value.
+  void Clear() {
+    index_.clear();
+    while (!entries_.empty()) {
+      discard(entries_.begin());
+    }
+  }
+
+  int size() const { return index_.size(); }
+  int capacity() const { return capacity_; }
+
+private:
+  typedef std::list<std::pair<Key, Value>> Entries;
+
+  void discard(typename Entries::iterator entry) {
+    if (evict_) {
+      evict_(entry->first, entry->second);
+    }
+    entries_.erase(entry);
+  }
+
+  const int capacity_;
+  Evict evict_;
+  // Most recently used first.
+  Entries entries_;
+  std::unordered_map<Key, typename Entries::iterator, Hash, Equal> index_;
+};
+
+}  // namespace util
+
+#endif
@@ -0,0 +1,58 @@
+#include "util/cache/lru.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace util {
+
+TEST(LruCacheTest, EvictsLeastRecentlyUsed) {
+  std::vector<std::string> evicted;
+  LruCache<std::string, int> cache(
+      2, [&evicted](const std::string& key, int& value) {
+        evicted.push_back(key);
+      });
+  EXPECT_EQ(nullptr, cache.Find("one"));
+  cache.Insert("one", 1);
+  cache.Insert("two", 2);
+  EXPECT_EQ(2, cache.size());
+
+  // Using "one" makes "two" the oldest.
+  ASSERT_NE(nullptr, cache.Find("one"));
+  EXPECT_EQ(1, *cache.Find("one"));
+  EXPECT_EQ(3, cache.Insert("three", 3));
+  EXPECT_EQ(2, cache.size());
+  EXPECT_EQ(std::vector<std::string>({"two"}), evicted);
+  EXPECT_EQ(nullptr, cache.Find("two"));
+  EXPECT_EQ(1, *cache.Find("one"));
+  EXPECT_EQ(3, *cache.Find("three"));
+}
+
+TEST(LruCacheTest, ReplaceAndClear) {
+  std::vector<int> evicted;
+  {
+    LruCache<std::string, int> cache(
+        2,
+        [&evicted](const std::string& key, int& value) {
+          evicted.push_back(value);
+        });
+    cache.Insert("one", 1);
+    cache.Insert("one", 11);
+    EXPECT_EQ(1, cache.size());
+    EXPECT_EQ(11, *cache.Find("one"));
+    EXPECT_EQ(std::vector<int>({1}), evicted);
+
+    cache.Insert("two", 2);
+    cache.Clear();
+    EXPECT_EQ(0, cache.size());
+    EXPECT_EQ(nullptr, cache.Find("one"));
+    EXPECT_EQ(3, evicted.size());
+
+    cache.Insert("three", 3);
+  }
+  // The destructor releases what is left.
+  EXPECT_EQ(3, evicted.back());
+}
+
+}  // namespace util
@@ -0,0 +1,74 @@
+#include "util/context/context.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "util/logging/logging.h"
+
+namespace util {
+namespace {
+
+thread_local Context* current = nullptr;
+
+}  // namespace
+
+constexpr int Context::kMaxSlots;
+
+Context::Context() {
+  for (auto& slot : slots_) {
+    slot.store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+Context::~Context() {
+  for (auto& slot : slots_) {
+    delete slot.load(std::memory_order_acquire);
+  }
+}
+
+Context& Context::Default() {
+  // Never destroyed, so that registries outlive other statics that might
+  // still refer to them at exit.
+  static Context* context = new Context();
+  return *context;
+}
+
+Context& Context::Current() {
+  return current != nullptr ? *current : Default();
+}
+
+int Context::nextSlot(const char* name) {
+  static std::atomic<int> next(0);
+  const int slot = next++;
+  if (slot >= kMaxSlots) {
+    // This can only be a programming error; there is one slot per registry
+    // type. Written straight to stderr as well, since there may be no logger
+    // registered yet.
+    Log::Errorf("Check failed: context slot %d for %s; kMaxSlots is %d", slot,
+                name, kMaxSlots);
+    std::fprintf(stderr,
+                 "%s:%d: Check failed: context slot %d for %s; kMaxSlots is "
+                 "%d\n",
+                 __FILE__, __LINE__, slot, name, kMaxSlots);
+    std::abort();
+  }
+  return slot;
+}
+
+Context::Slot* Context::install(int slot, Slot* entry) {
+  Slot* expected = nullptr;
+  if (slots_[slot].compare_exchange_strong(expected, entry,
+                                           std::memory_order_acq_rel)) {
+    return entry;
+  }
+  delete entry;
+  return expected;
+}
+
+Context::Scope::Scope(Context* context) : previous_(current) {
+  current = context;
+}
+
+Context::Scope::~Scope() { current = previous_; }
+
+}  // namespace util
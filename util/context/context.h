@@ -0,0 +1,75 @@
+// Registries for one simulation.
+#ifndef UTIL_CONTEXT_CONTEXT_H
+#define UTIL_CONTEXT_CONTEXT_H
+
+#include <array>
+#include <atomic>
+#include <typeinfo>
+
+namespace util {
+
+// Holds the registries of one simulation - goods, areas, units, object tags,
+// AI executors and so on - so that several independent simulations can run
+// in one process. Each module keeps its registry in a slot of the context,
+// created on first use. Free functions and static lookups use Current(),
+// which is the process-wide default unless a Scope on this thread says
+// otherwise; so to run a world in its own context, create the context and
+// hold a Scope for it on every thread that touches the world.
+class Context {
+public:
+  Context();
+  ~Context();
+  Context(const Context&) = delete;
+  Context& operator=(const Context&) = delete;
+
+  // Returns this context's instance of T, default-constructing it the first
+  // time. Safe to call concurrently. Each T takes one of kMaxSlots slots,
+  // for every context; running out is a programming error, which aborts
+  // naming T.
+  template <typename T> T& Get() {
+    static const int slot = nextSlot(typeid(T).name());
+    Slot* entry = slots_[slot].load(std::memory_order_acquire);
+    if (entry == nullptr) {
+      entry = install(slot, new Holder<T>());
+    }
+    return static_cast<Holder<T>*>(entry)->value;
+  }
+
+  // The context used when no Scope is active.
+  static Context& Default();
+
+  // The context of the innermost Scope on this thread, or the default.
+  static Context& Current();
+
+  // Makes a context current on this thread for the lifetime of the scope.
+  class Scope {
+  public:
+    explicit Scope(Context* context);
+    ~Scope();
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+  private:
+    Context* previous_;
+  };
+
+private:
+  static constexpr int kMaxSlots = 32;
+
+  struct Slot {
+    virtual ~Slot() = default;
+  };
+  template <typename T> struct Holder : public Slot { T value; };
+
+  // Returns an unused slot for the type called name.
+  static int nextSlot(const char* name);
+  // Stores entry in the slot unless another thread got there first, in which
+  // case entry is deleted. Returns whatever is in the slot.
+  Slot* install(int slot, Slot* entry);
+
+  std::array<std::atomic<Slot*>, kMaxSlots> slots_;
+};
+
+}  // namespace util
+
+#endif
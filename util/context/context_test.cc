@@ -0,0 +1,85 @@
+#include "util/context/context.h"
+
+#include <initializer_list>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace util {
+namespace {
+
+struct Counter {
+  Counter() : count(0) {}
+  int count;
+};
+
+template <int N> struct Numbered {
+  Numbered() : number(N) {}
+  int number;
+};
+
+// Takes a slot for each of Numbered<0> to Numbered<N - 1>.
+template <int... N>
+void getNumbered(Context* context, std::integer_sequence<int, N...>) {
+  (void)std::initializer_list<int>{(context->Get<Numbered<N>>(), 0)...};
+}
+
+}  // namespace
+
+TEST(ContextTest, SeparateRegistries) {
+  Context::Default().Get<Counter>().count = 0;
+  Context one;
+  Context two;
+  one.Get<Counter>().count = 1;
+  two.Get<Counter>().count = 2;
+  EXPECT_EQ(1, one.Get<Counter>().count);
+  EXPECT_EQ(2, two.Get<Counter>().count);
+  EXPECT_EQ(0, Context::Default().Get<Counter>().count);
+}
+
+TEST(ContextTest, Scope) {
+  Context one;
+  EXPECT_EQ(&Context::Default(), &Context::Current());
+  {
+    Context::Scope scope(&one);
+    EXPECT_EQ(&one, &Context::Current());
+    Context two;
+    {
+      Context::Scope inner(&two);
+      EXPECT_EQ(&two, &Context::Current());
+    }
+    EXPECT_EQ(&one, &Context::Current());
+  }
+  EXPECT_EQ(&Context::Default(), &Context::Current());
+}
+
+TEST(ContextTest, Threads) {
+  std::vector<Context> contexts(8);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < contexts.size(); ++i) {
+    threads.emplace_back([&contexts, i]() {
+      Context::Scope scope(&contexts[i]);
+      for (int j = 0; j <= i; ++j) {
+        Context::Current().Get<Counter>().count++;
+      }
+      // Other threads have their own current context.
+      EXPECT_EQ(&contexts[i], &Context::Current());
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (int i = 0; i < contexts.size(); ++i) {
+    EXPECT_EQ(i + 1, contexts[i].Get<Counter>().count);
+  }
+}
+
+TEST(ContextDeathTest, OutOfSlots) {
+  Context context;
+  EXPECT_DEATH(getNumbered(&context, std::make_integer_sequence<int, 40>()),
+               "Check failed: context slot .*Numbered");
+}
+
+}  // namespace util
@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <iostream>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -24,7 +25,12 @@ struct listener {
 
 std::vector<listener> listeners;
 
+// Guards the listeners and verbosity, so that logging is safe from worker
+// threads. Recursive in case a listener logs.
+std::recursive_mutex mutex;
+
 void Log(const std::string& message, Priority p) {
+  std::lock_guard<std::recursive_mutex> lock(mutex);
   for (auto& l : listeners) {
     if (l.minimum > p) {
       continue;
@@ -36,10 +42,12 @@ void Log(const std::string& message, Priority p) {
 }  // namespace internal
 
 void SetVerbosity(const std::string& file, int level) {
+  std::lock_guard<std::recursive_mutex> lock(internal::mutex);
   internal::verbosity[file] = level;
 }
 
 void UnRegister(callback c) {
+  std::lock_guard<std::recursive_mutex> lock(internal::mutex);
   auto newend =
       std::remove_if(internal::listeners.begin(), internal::listeners.end(),
                      [&](const internal::listener& l) {
@@ -52,6 +60,7 @@ void Register(callback l, Priority m) {
   if (l == NULL) {
     return;
   }
+  std::lock_guard<std::recursive_mutex> lock(internal::mutex);
   internal::listeners.emplace_back(l, m);
 }
 
@@ -100,8 +109,14 @@ void Stream(Priority p, const std::string& message) {
 
 void Verbose(int level, const char* file, int line,
              const std::string& message) {
-  if (internal::verbosity[file] < level) {
-    return;
+  {
+    std::lock_guard<std::recursive_mutex> lock(internal::mutex);
+    auto verbosity = internal::verbosity.find(file);
+    int threshold =
+        verbosity == internal::verbosity.end() ? 0 : verbosity->second;
+    if (threshold < level) {
+      return;
+    }
   }
   Infof("%s:%d : %s", file, line, message);
 }
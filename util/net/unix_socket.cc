@@ -0,0 +1,195 @@
+#include "util/net/unix_socket.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "absl/strings/substitute.h"
+#include "src/google/protobuf/io/coded_stream.h"
+#include "src/google/protobuf/io/zero_copy_stream_impl_lite.h"
+
+namespace net {
+namespace {
+
+// Longest byte count accepted from the other end.
+constexpr int kMaxMessageSize = 64 << 20;
+
+util::Status makeAddress(const std::string& path, sockaddr_un* address) {
+  memset(address, 0, sizeof(*address));
+  address->sun_family = AF_UNIX;
+  if (path.size() >= sizeof(address->sun_path)) {
+    return util::InvalidArgumentError(
+        absl::Substitute("Socket path too long: $0", path));
+  }
+  strncpy(address->sun_path, path.c_str(), sizeof(address->sun_path) - 1);
+  return util::OkStatus();
+}
+
+util::Status errnoError(const std::string& what) {
+  return util::FailedPreconditionError(
+      absl::Substitute("$0: $1", what, strerror(errno)));
+}
+
+}  // namespace
+
+Connection::~Connection() {
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+}
+
+util::Status Connection::Send(const google::protobuf::Message& message) {
+  std::string buffer;
+  {
+    google::protobuf::io::StringOutputStream stream(&buffer);
+    google::protobuf::io::CodedOutputStream coded(&stream);
+    coded.WriteVarint32(message.ByteSizeLong());
+    if (!message.SerializeToCodedStream(&coded)) {
+      return util::InvalidArgumentError(absl::Substitute(
+          "Could not serialize $0", message.GetTypeName()));
+    }
+  }
+  const char* data = buffer.data();
+  size_t left = buffer.size();
+  while (left > 0) {
+    ssize_t sent = send(fd_, data, left, MSG_NOSIGNAL);
+    if (sent < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return errnoError("send");
+    }
+    data += sent;
+    left -= sent;
+  }
+  return util::OkStatus();
+}
+
+util::Status Connection::SetSendTimeout(int milliseconds) {
+  timeval timeout;
+  timeout.tv_sec = milliseconds / 1000;
+  timeout.tv_usec = (milliseconds % 1000) * 1000;
+  if (setsockopt(fd_, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)) <
+      0) {
+    return errnoError("setsockopt");
+  }
+  return util::OkStatus();
+}
+
+util::Status Connection::readAll(char* buffer, int size) {
+  while (size > 0) {
+    ssize_t got = recv(fd_, buffer, size, 0);
+    if (got < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return errnoError("recv");
+    }
+    if (got == 0) {
+      return util::NotFoundError("Connection closed");
+    }
+    buffer += got;
+    size -= got;
+  }
+  return util::OkStatus();
+}
+
+util::Status Connection::Receive(google::protobuf::Message* message) {
+  // Read the varint one byte at a time so that nothing past the message is
+  // consumed; callers poll the descriptor between messages.
+  uint32_t size = 0;
+  for (int shift = 0;; shift += 7) {
+    if (shift > 28) {
+      return util::InvalidArgumentError("Malformed message length");
+    }
+    char byte;
+    auto status = readAll(&byte, 1);
+    if (!status.ok()) {
+      if (shift > 0 && absl::IsNotFound(status)) {
+        return util::InvalidArgumentError("Connection closed mid-message");
+      }
+      return status;
+    }
+    size |= static_cast<uint32_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      break;
+    }
+  }
+  if (size > kMaxMessageSize) {
+    return util::InvalidArgumentError(
+        absl::Substitute("Message of $0 bytes is too large", size));
+  }
+
+  std::string buffer(size, '\0');
+  auto status = readAll(&buffer[0], size);
+  if (!status.ok()) {
+    return util::InvalidArgumentError(
+        absl::Substitute("Truncated message: $0", status.message()));
+  }
+  if (!message->ParseFromString(buffer)) {
+    return util::InvalidArgumentError(
+        absl::Substitute("Could not parse $0", message->GetTypeName()));
+  }
+  return util::OkStatus();
+}
+
+util::Status Listen(const std::string& path, int* listener) {
+  sockaddr_un address;
+  auto status = makeAddress(path, &address);
+  if (!status.ok()) {
+    return status;
+  }
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return errnoError("socket");
+  }
+  unlink(path.c_str());
+  if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+    status = errnoError(absl::Substitute("bind $0", path));
+    close(fd);
+    return status;
+  }
+  if (listen(fd, 8) < 0) {
+    status = errnoError("listen");
+    close(fd);
+    return status;
+  }
+  *listener = fd;
+  return util::OkStatus();
+}
+
+util::Status Accept(int listener, std::unique_ptr<Connection>* connection) {
+  int fd = accept(listener, nullptr, nullptr);
+  if (fd < 0) {
+    return errnoError("accept");
+  }
+  connection->reset(new Connection(fd));
+  return util::OkStatus();
+}
+
+util::Status Connect(const std::string& path,
+                     std::unique_ptr<Connection>* connection) {
+  sockaddr_un address;
+  auto status = makeAddress(path, &address);
+  if (!status.ok()) {
+    return status;
+  }
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return errnoError("socket");
+  }
+  if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) <
+      0) {
+    status = errnoError(absl::Substitute("connect $0", path));
+    close(fd);
+    return status;
+  }
+  connection->reset(new Connection(fd));
+  return util::OkStatus();
+}
+
+}  // namespace net
@@ -0,0 +1,57 @@
+// Unix-domain stream sockets carrying length-delimited protobufs.
+
+#ifndef UTIL_NET_UNIX_SOCKET_H
+#define UTIL_NET_UNIX_SOCKET_H
+
+#include <memory>
+#include <string>
+
+#include "src/google/protobuf/message.h"
+#include "util/status/status.h"
+
+namespace net {
+
+// One end of a connected socket. Each message is sent as a varint byte count
+// followed by the serialized proto. Closes the socket on destruction.
+class Connection {
+public:
+  explicit Connection(int fd) : fd_(fd) {}
+  ~Connection();
+  Connection(const Connection&) = delete;
+  Connection& operator=(const Connection&) = delete;
+
+  int fd() const { return fd_; }
+
+  // Sends message, failing if the other end has not taken it within the
+  // send timeout, if one is set.
+  util::Status Send(const google::protobuf::Message& message);
+
+  // Makes Send fail rather than wait more than milliseconds for the other end
+  // to make room.
+  util::Status SetSendTimeout(int milliseconds);
+
+  // Blocks until a whole message has arrived and parses it into message.
+  // Returns NotFoundError if the other end closed the connection cleanly
+  // between messages.
+  util::Status Receive(google::protobuf::Message* message);
+
+private:
+  util::Status readAll(char* buffer, int size);
+
+  int fd_;
+};
+
+// Creates a socket listening on path, replacing any stale socket file, and
+// stores its descriptor in listener.
+util::Status Listen(const std::string& path, int* listener);
+
+// Waits for a client on listener.
+util::Status Accept(int listener, std::unique_ptr<Connection>* connection);
+
+// Connects to the server listening on path.
+util::Status Connect(const std::string& path,
+                     std::unique_ptr<Connection>* connection);
+
+}  // namespace net
+
+#endif
@@ -0,0 +1,81 @@
+#include "util/net/unix_socket.h"
+
+#include <stdlib.h>
+#include <sys/socket.h>
+
+#include <memory>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "util/proto/object_id.pb.h"
+#include "util/status/status.h"
+
+namespace net {
+
+TEST(UnixSocketTest, SendReceive) {
+  int fds[2];
+  ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+  Connection one(fds[0]);
+  std::unique_ptr<Connection> two(new Connection(fds[1]));
+
+  util::proto::ObjectId sent;
+  sent.set_kind("unit");
+  sent.set_number(300);
+  util::proto::ObjectId big;
+  big.set_kind(std::string(1000, 'x'));
+  ASSERT_TRUE(one.Send(sent).ok());
+  ASSERT_TRUE(one.Send(big).ok());
+
+  util::proto::ObjectId got;
+  ASSERT_TRUE(two->Receive(&got).ok());
+  EXPECT_EQ("unit", got.kind());
+  EXPECT_EQ(300, got.number());
+  ASSERT_TRUE(two->Receive(&got).ok());
+  EXPECT_EQ(1000, got.kind().size());
+
+  two.reset();
+  auto status = one.Receive(&got);
+  EXPECT_EQ(absl::StatusCode::kNotFound, status.code()) << status.message();
+}
+
+TEST(UnixSocketTest, SendTimeout) {
+  int fds[2];
+  ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+  Connection one(fds[0]);
+  Connection two(fds[1]);
+  auto status = one.SetSendTimeout(10);
+  ASSERT_TRUE(status.ok()) << status.message();
+
+  // Nobody reads from two, so this cannot fit in the socket buffers.
+  util::proto::ObjectId big;
+  big.set_kind(std::string(1 << 24, 'x'));
+  EXPECT_FALSE(one.Send(big).ok());
+}
+
+TEST(UnixSocketTest, ListenConnect) {
+  const char* tmp = getenv("TEST_TMPDIR");
+  const std::string path =
+      std::string(tmp == nullptr ? "/tmp" : tmp) + "/unix_socket_test.sock";
+  int listener = -1;
+  auto status = Listen(path, &listener);
+  ASSERT_TRUE(status.ok()) << status.message();
+
+  std::unique_ptr<Connection> client;
+  status = Connect(path, &client);
+  ASSERT_TRUE(status.ok()) << status.message();
+  std::unique_ptr<Connection> server;
+  status = Accept(listener, &server);
+  ASSERT_TRUE(status.ok()) << status.message();
+  Connection closer(listener);
+
+  util::proto::ObjectId id;
+  id.set_number(7);
+  ASSERT_TRUE(client->Send(id).ok());
+  util::proto::ObjectId got;
+  ASSERT_TRUE(server->Receive(&got).ok());
+  EXPECT_EQ(7, got.number());
+
+  EXPECT_FALSE(Connect(path + ".missing", &client).ok());
+}
+
+}  // namespace net
@@ -1,6 +1,8 @@
 #include "util/proto/file.h"
 
+#include <cstdio>
 #include <fstream>
+#include <sstream>
 
 #include "absl/strings/substitute.h"
 #include "google/protobuf/text_format.h"
@@ -42,5 +44,50 @@ MergeProtoFile(const std::string& filename, google::protobuf::Message* proto) {
   return util::OkStatus();
 }
 
+util::Status ReadFile(const std::string& filename, std::string* contents) {
+  std::ifstream reader(filename, std::ios::binary);
+  if (!reader.good()) {
+    return util::InvalidArgumentError(
+        absl::Substitute("Could not open file $0", filename));
+  }
+  std::ostringstream buffer;
+  buffer << reader.rdbuf();
+  *contents = buffer.str();
+  return util::OkStatus();
+}
+
+util::Status WriteFile(const std::string& filename,
+                       const std::string& contents) {
+  const std::string temp_name = filename + ".tmp";
+  std::ofstream writer(temp_name, std::ios::binary | std::ios::trunc);
+  if (!writer.good()) {
+    return util::InvalidArgumentError(
+        absl::Substitute("Could not open file $0", temp_name));
+  }
+  writer << contents;
+  writer.close();
+  if (!writer.good()) {
+    std::remove(temp_name.c_str());
+    return util::InvalidArgumentError(
+        absl::Substitute("Could not write file $0", temp_name));
+  }
+  if (std::rename(temp_name.c_str(), filename.c_str()) != 0) {
+    std::remove(temp_name.c_str());
+    return util::InvalidArgumentError(
+        absl::Substitute("Could not replace file $0", filename));
+  }
+  return util::OkStatus();
+}
+
+util::Status MergeProtoText(const std::string& text,
+                            const std::string& filename,
+                            google::protobuf::Message* proto) {
+  if (!google::protobuf::TextFormat::MergeFromString(text, proto)) {
+    return util::InvalidArgumentError(
+        absl::Substitute("Error parsing file $0", filename));
+  }
+  return util::OkStatus();
+}
+
 }  // namespace proto
 }  // namespace util
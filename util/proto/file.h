@@ -19,6 +19,20 @@ util::Status ParseProtoFile(const std::string& filename,
 util::Status MergeProtoFile(const std::string& filename,
                             google::protobuf::Message* proto);
 
+// Reads the whole of filename into contents.
+util::Status ReadFile(const std::string& filename, std::string* contents);
+
+// Writes contents to filename, replacing it only once the whole of contents
+// is written, so that readers never see half a file.
+util::Status WriteFile(const std::string& filename,
+                       const std::string& contents);
+
+// Merges text, a text-format proto read from filename, into proto. The
+// filename is only used in error messages.
+util::Status MergeProtoText(const std::string& text,
+                            const std::string& filename,
+                            google::protobuf::Message* proto);
+
 }  // namespace proto
 }  // namespace util
 
@@ -47,5 +47,34 @@ TEST(ProtoUtils, TestMergeProtoFile) {
   EXPECT_EQ("check", proto.tag()) << proto.DebugString();
 }
 
+TEST(ProtoUtils, TestReadAndWriteFile) {
+  std::string text;
+  const std::string filename = "objectid.pb.txt";
+  auto status = ReadFile(
+      absl::StrJoin({kTestDir, kWorkdir, kTestDataLocation, filename}, "/"),
+      &text);
+  EXPECT_TRUE(status.ok()) << status.ToString();
+
+  ObjectId proto;
+  status = MergeProtoText(text, filename, &proto);
+  EXPECT_TRUE(status.ok()) << status.ToString();
+  EXPECT_EQ("test", proto.kind()) << proto.DebugString();
+  status = MergeProtoText("kind: ", filename, &proto);
+  EXPECT_FALSE(status.ok());
+
+  const char* tmp = getenv("TEST_TMPDIR");
+  const std::string path =
+      std::string(tmp == nullptr ? "/tmp" : tmp) + "/file_test.bin";
+  status = WriteFile(path, proto.SerializeAsString());
+  ASSERT_TRUE(status.ok()) << status.ToString();
+  std::string binary;
+  status = ReadFile(path, &binary);
+  ASSERT_TRUE(status.ok()) << status.ToString();
+  ObjectId read;
+  EXPECT_TRUE(read.ParseFromString(binary));
+  EXPECT_EQ(1, read.number()) << read.DebugString();
+  EXPECT_EQ("check", read.tag()) << read.DebugString();
+}
+
 }  // namespace proto
 }  // namespace util
@@ -2,6 +2,7 @@
 
 #include "absl/strings/str_join.h"
 #include "absl/strings/substitute.h"
+#include "util/context/context.h"
 #include "util/proto/object_id.pb.h"
 #include "util/status/status.h"
 
@@ -35,11 +36,16 @@ public:
 
 }  // namespace std
 
-std::unordered_map<std::pair<std::string, uint64>, std::string> numToTagMap;
-std::unordered_map<std::pair<std::string, std::string>, uint64> tagToNumMap;
-
 namespace {
 
+struct TagMaps {
+  std::unordered_map<std::pair<std::string, uint64>, std::string> numToTag;
+  std::unordered_map<std::pair<std::string, std::string>, uint64> tagToNum;
+};
+
+// Returns the tag maps of the current simulation context.
+TagMaps& tagMaps() { return util::Context::Current().Get<TagMaps>(); }
+
 std::string getKind(const util::proto::ObjectId& obj_id) {
   std::string kind = obj_id.kind();
   if (kind.empty()) {
@@ -48,13 +54,13 @@ std::string getKind(const util::proto::ObjectId& obj_id) {
   return kind;
 }
 
-// Returns the ObjectId's key into numToTagMap.
+// Returns the ObjectId's key into the number-to-tag map.
 std::pair<std::string, uint64> makeNumKey(const util::proto::ObjectId& obj_id) {
   std::string kind = getKind(obj_id);
   return std::make_pair(kind, obj_id.number());
 }
 
-// Returns the ObjectId's key into tagToNumMap.
+// Returns the ObjectId's key into the tag-to-number map.
 std::pair<std::string, std::string>
 makeTagKey(const util::proto::ObjectId& obj_id) {
   std::string kind = getKind(obj_id);
@@ -73,6 +79,7 @@ bool Always(const util::proto::ObjectId& one, const util::proto::ObjectId& two)
 }
 
 util::Status Canonicalise(util::proto::ObjectId* obj_id) {
+  TagMaps& maps = tagMaps();
   if (!obj_id->has_type() && !obj_id->has_kind()) {
     return util::InvalidArgumentError(absl::Substitute(
         "Cannot canonicalise object ID without type or kind: $0",
@@ -89,18 +96,18 @@ util::Status Canonicalise(util::proto::ObjectId* obj_id) {
     }
 
     // Original object.
-    if (numToTagMap.find(numkey) != numToTagMap.end()) {
+    if (maps.numToTag.find(numkey) != maps.numToTag.end()) {
       return util::AlreadyExistsError(absl::Substitute(
           "Object $0 (number) already exists", obj_id->DebugString()));
     }
 
-    if (tagToNumMap.find(tagkey) != tagToNumMap.end()) {
+    if (maps.tagToNum.find(tagkey) != maps.tagToNum.end()) {
       return util::AlreadyExistsError(absl::Substitute(
           "Object $0 (tag) already exists", obj_id->DebugString()));
     }
 
-    numToTagMap[numkey] = obj_id->tag();
-    tagToNumMap[tagkey] = obj_id->number();
+    maps.numToTag[numkey] = obj_id->tag();
+    maps.tagToNum[tagkey] = obj_id->number();
     obj_id->clear_tag();
     return util::OkStatus();
   }
@@ -110,27 +117,29 @@ util::Status Canonicalise(util::proto::ObjectId* obj_id) {
         "Object ID with no number or tag: $0", obj_id->DebugString()));
   }
 
-  if (tagToNumMap.find(tagkey) == tagToNumMap.end()) {
+  if (maps.tagToNum.find(tagkey) == maps.tagToNum.end()) {
     return util::NotFoundError(absl::Substitute(
         "Cannot find number for tagged ID: $0", obj_id->DebugString()));
   }
-  obj_id->set_number(tagToNumMap[tagkey]);
+  obj_id->set_number(maps.tagToNum[tagkey]);
   obj_id->clear_tag();
   return util::OkStatus();
 }
 
 void ClearTags() {
-  numToTagMap.clear();
-  tagToNumMap.clear();
+  TagMaps& maps = tagMaps();
+  maps.numToTag.clear();
+  maps.tagToNum.clear();
 }
 
 std::string Tag(const util::proto::ObjectId& obj_id) {
+  TagMaps& maps = tagMaps();
   if (obj_id.has_tag()) {
     return obj_id.tag();
   }
   auto numkey = makeNumKey(obj_id);
-  if (numToTagMap.find(numkey) != numToTagMap.end()) {
-    return numToTagMap[numkey];
+  if (maps.numToTag.find(numkey) != maps.numToTag.end()) {
+    return maps.numToTag[numkey];
   }
 
   return absl::Substitute("$0_$1", getKind(obj_id), obj_id.number());
@@ -180,11 +189,12 @@ util::proto::ObjectId New(const std::string& kind, int num) {
 }
 
 void RestoreTag(util::proto::ObjectId* obj_id) {
+  TagMaps& maps = tagMaps();
   auto numkey = makeNumKey(*obj_id);
-  if (numToTagMap.find(numkey) == numToTagMap.end()) {
+  if (maps.numToTag.find(numkey) == maps.numToTag.end()) {
     return;
   }
-  obj_id->set_tag(numToTagMap[numkey]);
+  obj_id->set_tag(maps.numToTag[numkey]);
 }
 
 void Set(const std::string& kind, int num, util::proto::ObjectId* obj_id) {
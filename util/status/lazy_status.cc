@@ -0,0 +1,66 @@
+#include "util/status/lazy_status.h"
+
+namespace util {
+
+LazyStatus::LazyStatus(const LazyStatus& other)
+    : code_(other.code_), message_(other.message_), formatter_(nullptr),
+      status_(other.status_) {
+  if (other.formatter_ != nullptr) {
+    other.formatter_->copy(other.payload_, payload_);
+    formatter_ = other.formatter_;
+  }
+}
+
+LazyStatus& LazyStatus::operator=(const LazyStatus& other) {
+  if (this == &other) {
+    return *this;
+  }
+  reset();
+  code_ = other.code_;
+  message_ = other.message_;
+  status_ = other.status_;
+  if (other.formatter_ != nullptr) {
+    other.formatter_->copy(other.payload_, payload_);
+    formatter_ = other.formatter_;
+  }
+  return *this;
+}
+
+void LazyStatus::reset() {
+  if (formatter_ != nullptr) {
+    formatter_->destroy(payload_);
+    formatter_ = nullptr;
+  }
+}
+
+std::string LazyStatus::message() const {
+  if (formatter_ != nullptr) {
+    return formatter_->format(payload_);
+  }
+  if (message_ != nullptr) {
+    return message_;
+  }
+  return std::string(status_.message());
+}
+
+Status LazyStatus::ToStatus() const {
+  if (formatter_ != nullptr || message_ != nullptr) {
+    return Status(code_, message());
+  }
+  return status_;
+}
+
+bool IsNotComplete(const LazyStatus& cand) {
+  if (cand.code() != NotComplete().code()) {
+    return false;
+  }
+  if (cand.formatter_ != nullptr) {
+    return cand.message() == NotComplete().message();
+  }
+  if (cand.message_ != nullptr) {
+    return absl::string_view(cand.message_) == NotComplete().message();
+  }
+  return IsNotComplete(cand.status_);
+}
+
+} // namespace util
@@ -0,0 +1,111 @@
+// A status that formats its message only when asked for it.
+
+#ifndef UTIL_STATUS_LAZY_STATUS_H
+#define UTIL_STATUS_LAZY_STATUS_H
+
+#include <cstddef>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "util/status/status.h"
+
+namespace util {
+
+// Stands in for Status where failures are expected and usually discarded
+// unread, such as a unit being filtered out or a step not being affordable
+// yet. A failure carries either a fixed message, which costs nothing to
+// create, or a function that makes the message; that function is stored
+// inline, so creating or copying the status does not allocate, and it is
+// only called when the message is read. Converts to and from Status, so it
+// can be returned where a Status was, and passed on to code that wants one.
+class LazyStatus {
+public:
+  // An OK status.
+  LazyStatus()
+      : code_(absl::StatusCode::kOk), message_(nullptr), formatter_(nullptr) {}
+  LazyStatus(const Status& status)
+      : code_(status.code()), message_(nullptr), formatter_(nullptr),
+        status_(status) {}
+  // A failure whose message is message, which must outlive the status;
+  // string literals do.
+  LazyStatus(absl::StatusCode code, const char* message)
+      : code_(code), message_(message), formatter_(nullptr) {}
+  LazyStatus(const LazyStatus& other);
+  LazyStatus& operator=(const LazyStatus& other);
+  ~LazyStatus() { reset(); }
+
+  // A failure whose message is returned by format, which is called each time
+  // the message is read. Anything format needs should be captured by value,
+  // and kept small and cheap to copy - ids' numbers rather than the ids, say
+  // - since copying a capture that allocates defeats the point.
+  template <typename F>
+  static LazyStatus Deferred(absl::StatusCode code, F format) {
+    static_assert(sizeof(F) <= kInlineSize,
+                  "Deferred message captures too much to store inline");
+    static_assert(alignof(F) <= alignof(std::max_align_t),
+                  "Deferred message capture is over-aligned");
+    LazyStatus status(code, nullptr);
+    new (status.payload_) F(std::move(format));
+    status.formatter_ = &Formatter<F>::kOps;
+    return status;
+  }
+
+  bool ok() const { return code_ == absl::StatusCode::kOk; }
+  absl::StatusCode code() const { return code_; }
+  std::string message() const;
+  // As Status::ToString.
+  std::string ToString() const { return ToStatus().ToString(); }
+
+  // Builds the equivalent Status, formatting the message if need be.
+  Status ToStatus() const;
+  operator Status() const { return ToStatus(); }
+
+private:
+  friend bool IsNotComplete(const LazyStatus& cand);
+
+  // Room for the function of a deferred message.
+  static constexpr size_t kInlineSize = 64;
+
+  // How to use a function of type F stored in payload_.
+  struct FormatterOps {
+    std::string (*format)(const void* payload);
+    void (*copy)(const void* from, void* to);
+    void (*destroy)(void* payload);
+  };
+  template <typename F> struct Formatter {
+    static std::string Format(const void* payload) {
+      return (*static_cast<const F*>(payload))();
+    }
+    static void Copy(const void* from, void* to) {
+      new (to) F(*static_cast<const F*>(from));
+    }
+    static void Destroy(void* payload) { static_cast<F*>(payload)->~F(); }
+    static constexpr FormatterOps kOps = {&Format, &Copy, &Destroy};
+  };
+
+  // Destroys the deferred message function, if any.
+  void reset();
+
+  absl::StatusCode code_;
+  // Set for failures with a fixed message.
+  const char* message_;
+  // Set for failures with a deferred message, whose function is in payload_.
+  const FormatterOps* formatter_;
+  alignas(std::max_align_t) unsigned char payload_[kInlineSize];
+  // Set when built from a Status.
+  Status status_;
+};
+
+template <typename F>
+constexpr LazyStatus::FormatterOps LazyStatus::Formatter<F>::kOps;
+
+// Returns true if cand is NotComplete.
+bool IsNotComplete(const LazyStatus& cand);
+
+} // namespace util
+
+#endif // UTIL_STATUS_LAZY_STATUS_H
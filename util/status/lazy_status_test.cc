@@ -0,0 +1,97 @@
+#include "util/status/lazy_status.h"
+
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "util/status/status.h"
+
+namespace {
+// Number of calls to operator new since the test started counting.
+int allocations = 0;
+}  // namespace
+
+void* operator new(size_t size) {
+  ++allocations;
+  void* ptr = std::malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+
+namespace util {
+
+TEST(LazyStatusTest, Fixed) {
+  LazyStatus ok;
+  EXPECT_TRUE(ok.ok());
+  EXPECT_TRUE(ok.ToStatus().ok());
+
+  LazyStatus failed(absl::StatusCode::kNotFound, "gone");
+  EXPECT_FALSE(failed.ok());
+  EXPECT_EQ(absl::StatusCode::kNotFound, failed.code());
+  EXPECT_EQ("gone", failed.message());
+  EXPECT_TRUE(Equal(NotFoundError("gone"), failed));
+}
+
+TEST(LazyStatusTest, Deferred) {
+  int calls = 0;
+  const int number = 7;
+  auto status = LazyStatus::Deferred(absl::StatusCode::kInvalidArgument,
+                                     [&calls, number]() {
+                                       ++calls;
+                                       return absl::StrFormat("bad %d", number);
+                                     });
+  EXPECT_FALSE(status.ok());
+  EXPECT_EQ(absl::StatusCode::kInvalidArgument, status.code());
+  EXPECT_EQ(0, calls);
+  EXPECT_EQ("bad 7", status.message());
+  EXPECT_EQ(1, calls);
+  Status converted = status;
+  EXPECT_TRUE(Equal(InvalidArgumentError("bad 7"), converted));
+}
+
+TEST(LazyStatusTest, DeferredDoesNotAllocate) {
+  const uint64_t number = 7;
+  const char* name = "schooner";
+  allocations = 0;
+  {
+    auto status = LazyStatus::Deferred(
+        absl::StatusCode::kNotFound, [number, name]() {
+          return absl::StrFormat("no %s %d", name, number);
+        });
+    LazyStatus copy = status;
+    LazyStatus assigned;
+    assigned = copy;
+    EXPECT_FALSE(assigned.ok());
+  }
+  const int made = allocations;
+  EXPECT_EQ(0, made);
+
+  auto status = LazyStatus::Deferred(absl::StatusCode::kNotFound,
+                                     [number, name]() {
+                                       return absl::StrFormat("no %s %d", name,
+                                                              number);
+                                     });
+  LazyStatus copy = status;
+  status = LazyStatus();
+  EXPECT_EQ("no schooner 7", copy.message());
+}
+
+TEST(LazyStatusTest, FromStatus) {
+  LazyStatus status = FailedPreconditionError("no");
+  EXPECT_EQ(absl::StatusCode::kFailedPrecondition, status.code());
+  EXPECT_EQ("no", status.message());
+  EXPECT_FALSE(IsNotComplete(status));
+
+  EXPECT_TRUE(IsNotComplete(LazyStatus(NotComplete())));
+  EXPECT_TRUE(IsNotComplete(
+      LazyStatus(NotComplete().code(), "not completed")));
+  EXPECT_FALSE(IsNotComplete(LazyStatus()));
+}
+
+} // namespace util
@@ -0,0 +1,147 @@
+#include "util/threads/parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "util/context/context.h"
+
+namespace threads {
+namespace {
+
+std::atomic<int> max_workers(0);
+
+}  // namespace
+
+int MaxWorkers() {
+  int workers = max_workers.load();
+  if (workers > 0) {
+    return workers;
+  }
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+void SetMaxWorkers(int workers) { max_workers.store(std::max(0, workers)); }
+
+void ParallelFor(int count, const std::function<void(int)>& work) {
+  const int workers = std::min(count, MaxWorkers());
+  if (workers <= 1) {
+    for (int i = 0; i < count; ++i) {
+      work(i);
+    }
+    return;
+  }
+
+  // Indices are handed out one at a time, since the cost of each piece of
+  // work is typically uneven.
+  std::atomic<int> next(0);
+  auto drain = [&]() {
+    for (int i = next++; i < count; i = next++) {
+      work(i);
+    }
+  };
+  // The work runs in the caller's simulation context, whichever thread it
+  // lands on.
+  util::Context* context = &util::Context::Current();
+  std::vector<std::thread> threads;
+  threads.reserve(workers - 1);
+  for (int i = 1; i < workers; ++i) {
+    threads.emplace_back([context, &drain]() {
+      util::Context::Scope scope(context);
+      drain();
+    });
+  }
+  drain();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+WorkerPool::WorkerPool(int workers)
+    : busy_(false), work_(nullptr), count_(0), context_(nullptr), job_(0), remaining_(0),
+      quit_(false), next_(0) {
+  if (workers <= 0) {
+    workers = MaxWorkers();
+  }
+  threads_.reserve(workers - 1);
+  for (int i = 1; i < workers; ++i) {
+    threads_.emplace_back([this]() { run(); });
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    quit_ = true;
+  }
+  wake_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+void WorkerPool::run() {
+  uint64 last_job = 0;
+  while (true) {
+    const std::function<void(int)>* work = nullptr;
+    int count = 0;
+    util::Context* context = nullptr;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      wake_.wait(lock, [this, last_job]() { return quit_ || job_ != last_job; });
+      if (quit_) {
+        return;
+      }
+      last_job = job_;
+      work = work_;
+      count = count_;
+      context = context_;
+    }
+    {
+      util::Context::Scope scope(context);
+      for (int i = next_++; i < count; i = next_++) {
+        (*work)(i);
+      }
+    }
+    // The caller waits for every thread, so none can still be reading this
+    // job's fields when the next one is set up.
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--remaining_ == 0) {
+      done_.notify_all();
+    }
+  }
+}
+
+void WorkerPool::ParallelFor(int count,
+                             const std::function<void(int)>& work) {
+  if (threads_.empty() || count <= 1 || busy_.exchange(true)) {
+    for (int i = 0; i < count; ++i) {
+      work(i);
+    }
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    work_ = &work;
+    count_ = count;
+    context_ = &util::Context::Current();
+    remaining_ = threads_.size();
+    next_ = 0;
+    ++job_;
+  }
+  wake_.notify_all();
+  for (int i = next_++; i < count; i = next_++) {
+    work(i);
+  }
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this]() { return remaining_ == 0; });
+    work_ = nullptr;
+  }
+  busy_ = false;
+}
+
+}  // namespace threads
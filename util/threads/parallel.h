@@ -0,0 +1,79 @@
+// Helpers for running independent pieces of work on several cores.
+#ifndef UTIL_THREADS_PARALLEL_H
+#define UTIL_THREADS_PARALLEL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "util/context/context.h"
+#include "util/headers/int_types.h"
+
+namespace threads {
+
+// Calls work(i) once for each i in [0, count), spread over up to
+// MaxWorkers() threads, and returns when all calls have finished. Calls
+// may run in any order and concurrently, so they must not touch the same
+// mutable state. Runs on the calling thread if there is only one worker.
+// Every call sees the caller's current util::Context. Starts and joins its
+// threads each time, so it suits one-off work such as loading; work that
+// repeats, such as every turn, should use a WorkerPool.
+void ParallelFor(int count, const std::function<void(int)>& work);
+
+// Threads that are started once and then run the work of each ParallelFor
+// call, so that a simulation need not start threads every turn. The caller
+// of ParallelFor works too, so a pool of n workers has n - 1 threads.
+class WorkerPool {
+public:
+  // Starts the threads for the given number of workers; zero or less means
+  // MaxWorkers() as of now.
+  explicit WorkerPool(int workers = 0);
+  // Stops and joins the threads. No ParallelFor may be running.
+  ~WorkerPool();
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  // As the free ParallelFor, on the pool's threads. If the pool is already
+  // busy - for instance when called from inside work - the calls run on the
+  // calling thread instead.
+  void ParallelFor(int count, const std::function<void(int)>& work);
+
+  // Returns the number of workers, counting the caller.
+  int size() const { return threads_.size() + 1; }
+
+private:
+  // Body of each thread: waits for jobs and takes indices from them.
+  void run();
+
+  // Set by the caller for the whole of a ParallelFor.
+  std::atomic<bool> busy_;
+  // Guards the job fields below.
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable done_;
+  // The current job. Each is numbered, so that threads can tell a new one
+  // from the one they last ran.
+  const std::function<void(int)>* work_;
+  int count_;
+  util::Context* context_;
+  uint64 job_;
+  // Threads that have not yet finished the current job.
+  int remaining_;
+  bool quit_;
+  std::atomic<int> next_;
+  std::vector<std::thread> threads_;
+};
+
+// Returns the number of threads ParallelFor will use.
+int MaxWorkers();
+
+// Sets the number of threads ParallelFor will use; zero or less restores the
+// default of one per hardware thread.
+void SetMaxWorkers(int workers);
+
+}  // namespace threads
+
+#endif
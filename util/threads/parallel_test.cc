@@ -0,0 +1,83 @@
+#include "util/threads/parallel.h"
+
+#include <atomic>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "util/context/context.h"
+
+namespace threads {
+
+TEST(ParallelTest, CoversEveryIndexOnce) {
+  SetMaxWorkers(4);
+  EXPECT_EQ(4, MaxWorkers());
+  std::vector<int> calls(1000, 0);
+  ParallelFor(calls.size(), [&calls](int i) { calls[i]++; });
+  for (int i = 0; i < calls.size(); ++i) {
+    EXPECT_EQ(1, calls[i]) << i;
+  }
+
+  ParallelFor(0, [&calls](int i) { calls[i]++; });
+  EXPECT_EQ(1, calls[0]);
+}
+
+TEST(ParallelTest, SingleWorker) {
+  SetMaxWorkers(1);
+  std::vector<int> order;
+  ParallelFor(5, [&order](int i) { order.push_back(i); });
+  EXPECT_EQ(std::vector<int>({0, 1, 2, 3, 4}), order);
+
+  SetMaxWorkers(0);
+  EXPECT_LE(1, MaxWorkers());
+}
+
+TEST(ParallelTest, CallerContext) {
+  SetMaxWorkers(4);
+  util::Context context;
+  util::Context::Scope scope(&context);
+  std::vector<const util::Context*> seen(100, nullptr);
+  ParallelFor(seen.size(),
+              [&seen](int i) { seen[i] = &util::Context::Current(); });
+  for (int i = 0; i < seen.size(); ++i) {
+    EXPECT_EQ(&context, seen[i]) << i;
+  }
+  SetMaxWorkers(0);
+}
+
+TEST(WorkerPoolTest, ReusesThreads) {
+  WorkerPool pool(4);
+  EXPECT_EQ(4, pool.size());
+  util::Context context;
+  util::Context::Scope scope(&context);
+  for (int run = 0; run < 50; ++run) {
+    std::vector<int> calls(200, 0);
+    std::vector<const util::Context*> seen(calls.size(), nullptr);
+    pool.ParallelFor(calls.size(), [&calls, &seen](int i) {
+      calls[i]++;
+      seen[i] = &util::Context::Current();
+    });
+    for (int i = 0; i < calls.size(); ++i) {
+      ASSERT_EQ(1, calls[i]) << run << " " << i;
+      ASSERT_EQ(&context, seen[i]) << run << " " << i;
+    }
+  }
+}
+
+TEST(WorkerPoolTest, Nested) {
+  WorkerPool pool(4);
+  std::atomic<int> calls(0);
+  pool.ParallelFor(10, [&pool, &calls](int i) {
+    pool.ParallelFor(10, [&calls](int j) { calls++; });
+  });
+  EXPECT_EQ(100, calls.load());
+}
+
+TEST(WorkerPoolTest, SingleWorker) {
+  WorkerPool pool(1);
+  EXPECT_EQ(1, pool.size());
+  std::vector<int> order;
+  pool.ParallelFor(5, [&order](int i) { order.push_back(i); });
+  EXPECT_EQ(std::vector<int>({0, 1, 2, 3, 4}), order);
+}
+
+}  // namespace threads